@@ -0,0 +1,723 @@
+#include <QBuffer>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QtEndian>
+#include <algorithm>
+#include <optional>
+#include <pybind11/embed.h>
+#include "lib/addressmapping.h"
+#include "lib/configuration.h"
+#include "lib/datafileset.h"
+#include "lib/exewrapper.h"
+#include "lib/filemanifest.h"
+#include "lib/freespacemanager.h"
+#include "lib/fortunestreetdata.h"
+#include "lib/fslocale.h"
+#include "lib/gameinstance.h"
+#include "lib/importexportutils.h"
+#include "lib/mapdescriptor.h"
+#include "lib/mods/arc/defaultminimapicons.h"
+#include "lib/mods/csmmmodpack.h"
+#include "lib/mods/defaultmodlist.h"
+#include "lib/mods/modloader.h"
+#include "lib/powerpcasm.h"
+#include "lib/python/pythonbindings.h"
+#include "lib/textureencoder.h"
+#include "lib/tracing.h"
+#include "lib/uimessage.h"
+#include "lib/vanilladatabase.h"
+
+PYBIND11_EMBEDDED_MODULE(pycsmm, m) {
+    init_pycsmm(m);
+}
+
+/**
+ * Times the CPU and IO heavy stages of CSMM and loading and saving a synthetic game on fixtures scaled by the number
+ * of maps, and optionally loading and saving a real game directory, and prints the results as json so that runs of different commits
+ * can be compared.
+ */
+namespace {
+
+struct Bench {
+    QJsonArray results;
+    int repeat = 3;
+
+    /**
+     * @brief Runs the stage repeat times and records the median duration.
+     * @param stage returns the number of bytes processed
+     */
+    void time(const QString &name, int maps, const std::function<qint64()> &stage) {
+        QVector<qint64> durations;
+        qint64 bytes = 0;
+        for (int i = 0; i < repeat; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            bytes = stage();
+            durations.append(timer.nsecsElapsed());
+        }
+        record(name, maps, durations, bytes);
+    }
+
+    /**
+     * @brief Records the median of durations which were measured elsewhere, e.g. spans of a trace.
+     * @param durations the durations in nanoseconds
+     */
+    void record(const QString &name, int maps, QVector<qint64> durations, qint64 bytes = 0) {
+        std::sort(durations.begin(), durations.end());
+        double ms = durations[durations.size() / 2] / 1e6;
+        QJsonObject result{{"name", name}, {"maps", maps}, {"ms", ms}, {"bytes", bytes}};
+        if (bytes > 0 && ms > 0) {
+            result["mbPerSec"] = bytes / 1e3 / ms;
+        }
+        results.append(result);
+        qInfo().noquote() << QString("%1 (%2 maps): %3 ms").arg(name).arg(maps).arg(ms, 0, 'f', 2);
+    }
+};
+
+std::vector<MapDescriptor> syntheticDescriptors(int maps) {
+    std::vector<MapDescriptor> descriptors(maps);
+    for (int i = 0; i < maps; ++i) {
+        auto &descriptor = descriptors[i];
+        descriptor.internalName = QString("bench%1").arg(i);
+        descriptor.mapSet = i % 2;
+        descriptor.zone = (i / 2) % 3;
+        descriptor.order = i / 6;
+        descriptor.initialCash = 1000 + i;
+        descriptor.targetAmount = 10000 + i;
+        descriptor.baseSalary = 200;
+        descriptor.salaryIncrement = 100;
+        descriptor.maxDiceRoll = 6;
+        descriptor.background = "bg901";
+        descriptor.frbFiles = {QString("bench%1_a").arg(i)};
+        descriptor.nameMsgId = 25000 + 2 * i;
+        descriptor.descMsgId = 25000 + 2 * i + 1;
+        for (auto &locale: FS_LOCALES) {
+            descriptor.names[locale] = QString("Bench Board %1 (%2)").arg(i).arg(locale);
+            descriptor.descs[locale] = QString("A synthetic board for benchmarking, number %1.").arg(i);
+        }
+        descriptor.districtNames = VanillaDatabase::getVanillaDistrictNames();
+        descriptor.shopNames = VanillaDatabase::getVanillaShopNames();
+    }
+    return descriptors;
+}
+
+/**
+ * @return a file of the given size whose contents look like code: mostly repeating instruction words
+ */
+QByteArray syntheticDol(int size, quint32 seed) {
+    QByteArray result(size, '\0');
+    QRandomGenerator random(seed);
+    for (int i = 0; i + 4 <= size; i += 4) {
+        quint32 word = random.bounded(16) == 0 ? random.generate() : 0x38600000 | (i & 0xffff);
+        qToBigEndian(word, result.data() + i);
+    }
+    return result;
+}
+
+void benchConfiguration(Bench &bench, int maps, const QDir &workDir) {
+    auto descriptors = syntheticDescriptors(maps);
+    auto configFile = workDir.filePath(QString("config%1.yaml").arg(maps));
+    bench.time("configuration.save", maps, [&]() {
+        Configuration::save(configFile, descriptors);
+        return QFileInfo(configFile).size();
+    });
+    bench.time("configuration.status", maps, [&]() {
+        return (qint64)Configuration::status(configFile).size();
+    });
+    QVector<std::string> yamls;
+    for (auto &descriptor: descriptors) {
+        yamls.append(descriptor.toYaml().toStdString());
+    }
+    bench.time("mapdescriptor.toYaml", maps, [&]() {
+        qint64 bytes = 0;
+        for (auto &descriptor: descriptors) {
+            bytes += descriptor.toYaml().size();
+        }
+        return bytes;
+    });
+    bench.time("mapdescriptor.fromYaml", maps, [&]() {
+        qint64 bytes = 0;
+        for (auto &yaml: yamls) {
+            MapDescriptor descriptor;
+            descriptor.fromYaml(YAML::Load(yaml));
+            bytes += yaml.size();
+        }
+        return bytes;
+    });
+}
+
+void benchFreeSpace(Bench &bench, int maps) {
+    // one free block per map like the tables which the DolIO mods relocate, and one allocation per map and table
+    static constexpr quint32 BASE = 0x80000000;
+    const quint32 size = maps * 0x400;
+    AddressMapper mapper(AddressSectionMapper({{BASE, BASE + size, BASE, "bench"}}));
+    bench.time("freespace.allocate", maps, [&]() {
+        QByteArray dol(size, '\0');
+        QBuffer buffer(&dol);
+        buffer.open(QIODevice::ReadWrite);
+        QDataStream stream(&buffer);
+        FreeSpaceManager freeSpaceManager;
+        for (int i = 0; i < maps; ++i) {
+            freeSpaceManager.addFreeSpace(BASE + i * 0x400, BASE + i * 0x400 + 0x3f0);
+        }
+        qint64 bytes = 0;
+        for (int table = 0; table < 8; ++table) {
+            for (int i = 0; i < maps; ++i) {
+                QByteArray entry(24 + (i % 5) * 4, (char)(table * 31 + i));
+                freeSpaceManager.allocateUnusedSpace(entry, stream, mapper, QString(), true);
+                bytes += entry.size();
+            }
+        }
+        freeSpaceManager.nullTheFreeSpace(stream, mapper);
+        return bytes;
+    });
+}
+
+void benchBsdiff(Bench &bench, int maps, const QDir &workDir) {
+    // main.dol is about 4 MB; every map changes a few tables
+    auto oldDol = syntheticDol(4 * 1024 * 1024, 1);
+    auto newDol = oldDol;
+    QRandomGenerator random(2);
+    for (int i = 0; i < maps * 16; ++i) {
+        int offset = random.bounded(newDol.size() / 4) * 4;
+        qToBigEndian(random.generate(), newDol.data() + offset);
+    }
+    auto oldFile = workDir.filePath("old.dol"), newFile = workDir.filePath("new.dol");
+    auto patchFile = workDir.filePath(QString("dol%1.bsdiff").arg(maps)), patchedFile = workDir.filePath("patched.dol");
+    for (auto &pair: {std::make_pair(oldFile, &oldDol), std::make_pair(newFile, &newDol)}) {
+        QFile file(pair.first);
+        file.open(QFile::WriteOnly);
+        file.write(*pair.second);
+    }
+    bench.time("bsdiff", maps, [&]() {
+        QFile::remove(patchFile);
+        auto errors = ImportExportUtils::createBsdiff(oldFile, newFile, patchFile);
+        if (!errors.isEmpty()) {
+            qCritical() << errors;
+        }
+        return (qint64)newDol.size();
+    });
+    bench.time("bspatch", maps, [&]() {
+        QFile::remove(patchedFile);
+        auto errors = ImportExportUtils::applyBspatch(oldFile, patchedFile, patchFile);
+        if (!errors.isEmpty()) {
+            qCritical() << errors;
+        }
+        return (qint64)newDol.size();
+    });
+}
+
+void benchHashing(Bench &bench, int maps, const QDir &workDir) {
+    // every map brings its frb files, a background and music
+    QDir gameDir(workDir.filePath(QString("game%1").arg(maps)));
+    gameDir.mkpath("files/param");
+    gameDir.mkpath("files/sound/stream");
+    qint64 totalSize = 0;
+    for (int i = 0; i < maps; ++i) {
+        auto frb = syntheticDol(16 * 1024, i);
+        auto brstm = syntheticDol(256 * 1024, i + maps);
+        QFile frbFile(gameDir.filePath(QString("files/param/bench%1_a.frb").arg(i)));
+        frbFile.open(QFile::WriteOnly);
+        frbFile.write(frb);
+        QFile brstmFile(gameDir.filePath(QString("files/sound/stream/bench%1.brstm").arg(i)));
+        brstmFile.open(QFile::WriteOnly);
+        brstmFile.write(brstm);
+        totalSize += frb.size() + brstm.size();
+    }
+    bench.time("filemanifest.compute", maps, [&]() {
+        FileManifest::compute(gameDir);
+        return totalSize;
+    });
+}
+
+void benchTextures(Bench &bench, int maps) {
+    // every map brings a map icon and the loading screen textures
+    QImage image(256, 256, QImage::Format_ARGB32);
+    QRandomGenerator random(3);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            image.setPixel(x, y, qRgba(x, y, (x * y) % 256, random.bounded(2) ? 255 : 0));
+        }
+    }
+    for (auto quality: {TextureEncoder::Quality::Fast, TextureEncoder::Quality::Normal, TextureEncoder::Quality::Best}) {
+        QString qualityName = quality == TextureEncoder::Quality::Fast ? "fast" : quality == TextureEncoder::Quality::Normal ? "normal" : "best";
+        bench.time("texture.cmpr." + qualityName, maps, [&]() {
+            qint64 bytes = 0;
+            for (int i = 0; i < maps; ++i) {
+                bytes += TextureEncoder::encode(image, TextureEncoder::CMPR, quality).size();
+            }
+            return bytes;
+        });
+    }
+}
+
+/*
+ * The full pipeline is timed on a synthetic Fortune Street game directory. Instead of the Wiimms tools the bench runs
+ * itself as wit, wszst and wimgt (see runFakeTool), so that the process and file overhead of the arc stages is
+ * measured without needing a disc image.
+ */
+
+// the magic number of the archives which the fake wszst reads and writes
+constexpr quint32 FAKE_ARC_MAGIC = 0x43534d42;
+constexpr int DOL_HEADER_SIZE = 0x100;
+constexpr int DOL_TEXT_SECTIONS = 7;
+constexpr int DOL_SECTIONS = 18;
+
+void writeFile(const QString &path, const QByteArray &content) {
+    QFileInfo(path).dir().mkpath(".");
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly) || file.write(content) != content.size()) {
+        throw std::runtime_error("could not write " + path.toStdString());
+    }
+}
+
+/**
+ * @brief Writes a fake archive containing the files of the directory.
+ */
+void writeFakeArc(const QString &arcFile, const QDir &dir) {
+    QVector<QPair<QString, QByteArray>> files;
+    QDirIterator it(dir.path(), QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        auto path = it.next();
+        QFile file(path);
+        if (!file.open(QFile::ReadOnly)) {
+            throw std::runtime_error("could not read " + path.toStdString());
+        }
+        files.append({dir.relativeFilePath(path), file.readAll()});
+    }
+    QByteArray arc;
+    QDataStream stream(&arc, QIODevice::WriteOnly);
+    stream << FAKE_ARC_MAGIC << files;
+    writeFile(arcFile, arc);
+}
+
+/**
+ * @brief Extracts a fake archive written by writeFakeArc to the directory.
+ */
+void extractFakeArc(const QString &arcFile, const QDir &dir) {
+    QFile file(arcFile);
+    if (!file.open(QFile::ReadOnly)) {
+        throw std::runtime_error("could not read " + arcFile.toStdString());
+    }
+    QDataStream stream(&file);
+    quint32 magic;
+    QVector<QPair<QString, QByteArray>> files;
+    stream >> magic >> files;
+    if (magic != FAKE_ARC_MAGIC || stream.status() != QDataStream::Ok) {
+        throw std::runtime_error(arcFile.toStdString() + " is no fake archive");
+    }
+    for (auto &entry: files) {
+        writeFile(dir.filePath(entry.first), entry.second);
+    }
+}
+
+/**
+ * @brief Prints the sections of a dol file like "wit DUMP -l" does, as far as ExeWrapper::readSections reads them.
+ */
+void fakeWitDump(const QString &dolFile) {
+    QFile file(dolFile);
+    if (!file.open(QFile::ReadOnly)) {
+        throw std::runtime_error("could not read " + dolFile.toStdString());
+    }
+    auto header = file.read(DOL_HEADER_SIZE);
+    if (header.size() != DOL_HEADER_SIZE) {
+        throw std::runtime_error(dolFile.toStdString() + " is no dol file");
+    }
+    QTextStream out(stdout);
+    out << "Delta between file offset and virtual address:\n\n";
+    out << "       addr range    :   size   :  delta   : section\n";
+    out << QString(52, '-') << "\n";
+    for (int i = 0; i < DOL_SECTIONS; ++i) {
+        auto offset = qFromBigEndian<quint32>(header.constData() + i * 4);
+        auto address = qFromBigEndian<quint32>(header.constData() + 0x48 + i * 4);
+        auto size = qFromBigEndian<quint32>(header.constData() + 0x90 + i * 4);
+        if (size == 0) {
+            continue;
+        }
+        auto name = i < DOL_TEXT_SECTIONS ? QString("text%1").arg(i) : QString("data%1").arg(i - DOL_TEXT_SECTIONS);
+        out << QString(" %1 : %2..%3 : %4 : %5 : %6\n").arg(i, 2)
+               .arg(address, 8, 16, QChar('0')).arg(address + size - 1, 8, 16, QChar('0'))
+               .arg(size, 8, 16, QChar('0')).arg(address - offset, 8, 16, QChar('0')).arg(name);
+    }
+}
+
+/**
+ * @brief Runs wszst EXTRACT or CREATE on fake archives, substituting %P and %F in --dest like wszst.
+ */
+void fakeWszst(const QStringList &args) {
+    QString destPattern;
+    QStringList sources;
+    for (int i = 1; i < args.size(); ++i) {
+        if (args[i] == "--dest" || args[i] == "--transform" || args[i] == "--n-mipmaps") {
+            if (args[i] == "--dest" && i + 1 < args.size()) {
+                destPattern = args[i + 1];
+            }
+            ++i;
+        } else if (!args[i].startsWith("--")) {
+            sources.append(args[i]);
+        }
+    }
+    if (destPattern.isEmpty()) {
+        throw std::runtime_error("wszst: --dest is missing");
+    }
+    for (auto &source: sources) {
+        QFileInfo sourceInfo(QDir::current().relativeFilePath(source));
+        auto dest = QString(destPattern).replace("%P", sourceInfo.path()).replace("%F", sourceInfo.fileName());
+        if (args[0] == "EXTRACT") {
+            extractFakeArc(source, QDir(dest));
+        } else if (args[0] == "CREATE") {
+            writeFakeArc(dest, QDir(source));
+        } else {
+            throw std::runtime_error("wszst: unsupported command " + args[0].toStdString());
+        }
+    }
+}
+
+/**
+ * @brief Runs the bench as the Wiimms tool it was copied to by installFakeTools.
+ * @return the exit code, or nullopt if the bench was not started as one of the tools
+ */
+std::optional<int> runFakeTool(int argc, char *argv[]) {
+    auto tool = QFileInfo(QString::fromLocal8Bit(argv[0])).completeBaseName();
+    if (tool != "wit" && tool != "wszst" && tool != "wimgt") {
+        return std::nullopt;
+    }
+    QStringList args;
+    for (int i = 1; i < argc; ++i) {
+        args.append(QString::fromLocal8Bit(argv[i]));
+    }
+    try {
+        if (tool == "wit" && args.size() == 3 && args[0] == "DUMP") {
+            fakeWitDump(args[2]);
+        } else if (tool == "wszst" && !args.isEmpty()) {
+            fakeWszst(args);
+        } else if (tool == "wimgt" && args.size() >= 5 && args[0] == "ENCODE") {
+            // ENCODE --overwrite <png> --dest <dest>: the format does not matter for the timing
+            QFile::remove(args[4]);
+            if (!QFile::copy(args[2], args[4])) {
+                throw std::runtime_error("could not write " + args[4].toStdString());
+            }
+        } else {
+            throw std::runtime_error(QString("%1: unsupported arguments %2").arg(tool, args.join(' ')).toStdString());
+        }
+    } catch (const std::runtime_error &error) {
+        QTextStream(stderr) << error.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Copies the bench as wit, wszst and wimgt into dir, the layout which ExeWrapper expects. The copies find the
+ * Qt libraries the same way as the bench, so on Windows the Qt bin directory must be in PATH.
+ */
+void installFakeTools(const QDir &dir) {
+    auto self = QCoreApplication::applicationFilePath();
+    for (auto &tool: {QString("wit/bin/" WIT_NAME), QString("szs/bin/" WSZST_NAME), QString("szs/bin/" WIMGT_NAME)}) {
+        dir.mkpath(QFileInfo(tool).path());
+        QFile::remove(dir.filePath(tool));
+        if (!QFile::copy(self, dir.filePath(tool))) {
+            throw std::runtime_error("could not install " + dir.filePath(tool).toStdString());
+        }
+    }
+}
+
+/**
+ * @return a zero filled main.dol whose sections cover the addresses of the Fortune Street main.dol which the mods
+ * patch, with the instruction which GameInstance detects Fortune Street by
+ */
+QByteArray syntheticFortuneDol() {
+    struct Section { quint32 begin, end; bool text; };
+    const Section sections[] = {
+        {0x80003100, 0x8040da00, true},
+        {0x8040da00, 0x804aca00, false},
+        {0x804aca00, 0x80820000, false},
+    };
+    QByteArray dol(DOL_HEADER_SIZE, '\0');
+    int textIndex = 0, dataIndex = DOL_TEXT_SECTIONS;
+    for (auto &section: sections) {
+        int index = section.text ? textIndex++ : dataIndex++;
+        qToBigEndian<quint32>(dol.size(), dol.data() + index * 4);
+        qToBigEndian<quint32>(section.begin, dol.data() + 0x48 + index * 4);
+        qToBigEndian<quint32>(section.end - section.begin, dol.data() + 0x90 + index * 4);
+        dol.append(QByteArray(section.end - section.begin, '\0'));
+    }
+    qToBigEndian<quint32>(PowerPcAsm::lwz(0, -0x547c, 13), dol.data() + DOL_HEADER_SIZE + (0x8007a2c0 - sections[0].begin));
+    return dol;
+}
+
+/**
+ * @brief SyntheticMinimapIcons The default minimap icons without the dependency on mapIconTable, which needs the
+ * real layout files and is therefore left out of the synthetic pipeline.
+ */
+class SyntheticMinimapIcons : public DefaultMinimapIcons {
+public:
+    QSet<QString> depends() const override { return {}; }
+};
+
+/**
+ * @return the default mods which work on a synthetic game: the mods which patch real layouts (mapIconTable,
+ * displayMapInResults, namedDistricts) or the sound archive (musicTable) and the mods depending on them are left out
+ */
+ModListType syntheticModList() {
+    static const QSet<QString> NEED_REAL_ASSETS{
+        "mapIconTable", "displayMapInResults", "namedDistricts", "districtNameFreeSpace", "musicTable", "changeMusicOnSwitch"
+    };
+    ModListType result;
+    for (auto &mod: DefaultModList::defaultModList()) {
+        if (mod->modId() == DefaultMinimapIcons::MODID.data()) {
+            result.append(CSMMModHolder::fromCppObj<SyntheticMinimapIcons>());
+        } else if (!NEED_REAL_ASSETS.contains(mod->modId())) {
+            result.append(mod);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Writes the files of a Fortune Street game directory which the mods read: main.dol, Itast.brsar, the ui
+ * message csvs and fake arc files with as many sub-files as the real ones.
+ */
+void writeSyntheticGame(const QDir &gameDir, ModListType &mods) {
+    writeFile(gameDir.filePath(MAIN_DOL), syntheticFortuneDol());
+    writeFile(gameDir.filePath(ITAST_BRSAR), QByteArray(1024 * 1024, '\0'));
+
+    QSet<QString> messageFiles, arcFiles;
+    for (auto &mod: mods) {
+        auto uiMessageInterface = mod.getCapability<UiMessageInterface>();
+        if (uiMessageInterface) {
+            for (auto &messageFile: uiMessageInterface->loadUiMessages().keys()) {
+                messageFiles.insert(messageFile);
+            }
+            for (auto &messageFile: uiMessageInterface->saveUiMessages().keys()) {
+                messageFiles.insert(messageFile);
+            }
+        }
+        auto arcFileInterface = mod.getCapability<ArcFileInterface>();
+        if (arcFileInterface) {
+            for (auto &arcFile: arcFileInterface->modifyArcFile().keys()) {
+                arcFiles.insert(arcFile);
+            }
+        }
+    }
+    for (auto &messageFile: messageFiles) {
+        // the vanilla csvs have about 6000 messages
+        QFile file(gameDir.filePath(messageFile));
+        gameDir.mkpath(QFileInfo(messageFile).path());
+        if (!file.open(QFile::WriteOnly)) {
+            throw std::runtime_error("could not write " + file.fileName().toStdString());
+        }
+        UiMessage messages;
+        for (quint32 id = 0; id < 6000; ++id) {
+            messages[id] = QString("Synthetic message %1 of %2").arg(id).arg(messageFile);
+        }
+        messageToFile(&file, messages);
+    }
+    QTemporaryDir arcContents;
+    QDir arcDir(arcContents.path());
+    for (int i = 0; i < 64; ++i) {
+        writeFile(arcDir.filePath(QString("arc/blyt/synthetic%1.brlyt").arg(i)), syntheticDol(8 * 1024, i));
+    }
+    for (auto &tpl: {"ui_minimap_icon2_ja", "ui_minimap_icon2_w_ja", "ui_minimap_icon_ja", "ui_minimap_icon_w_ja", "ui_mark_eventsquare"}) {
+        writeFile(arcDir.filePath(QString("arc/timg/%1.tpl").arg(tpl)), syntheticDol(32 * 1024, 0));
+    }
+    for (auto &arcFile: arcFiles) {
+        writeFakeArc(gameDir.filePath(arcFile), arcDir);
+    }
+}
+
+/**
+ * @brief Writes the files of the imported maps: an frb file per map and turnlot images per background.
+ */
+void writeSyntheticImport(const QDir &importDir, const std::vector<MapDescriptor> &descriptors) {
+    QSet<QString> backgrounds;
+    for (auto &descriptor: descriptors) {
+        QByteArray frb;
+        QDataStream stream(&frb, QIODevice::WriteOnly);
+        BoardFile boardFile(true);
+        boardFile.boardInfo.initialCash = descriptor.initialCash;
+        stream << boardFile;
+        writeFile(importDir.filePath(PARAM_FOLDER + "/" + descriptor.frbFiles[0] + ".frb"), frb);
+        backgrounds.insert(descriptor.background);
+    }
+    QImage turnlot(64, 64, QImage::Format_RGB32);
+    for (auto &background: backgrounds) {
+        for (char extChr = 'a'; extChr <= 'c'; ++extChr) {
+            turnlot.fill(qRgb(extChr, (int)(qHash(background) & 0xff), 0x80));
+            auto path = importDir.filePath(turnlotPng(extChr, background));
+            importDir.mkpath(QFileInfo(turnlotPng(extChr, background)).path());
+            if (!turnlot.save(path)) {
+                throw std::runtime_error("could not write " + path.toStdString());
+            }
+        }
+    }
+}
+
+void benchPipeline(Bench &bench, int maps, const QDir &workDir) {
+    QDir gameDir(workDir.filePath(QString("pipeline%1/game").arg(maps)));
+    QDir importDir(workDir.filePath(QString("pipeline%1/import").arg(maps)));
+    auto mods = syntheticModList();
+    auto descriptors = syntheticDescriptors(maps);
+    // a new background for about every eighth map, each of which gets its turnlot arc packed
+    for (int i = 0; i < maps; ++i) {
+        descriptors[i].background = QString("bench_bg%1").arg(i % std::max(1, maps / 8));
+    }
+    writeSyntheticGame(gameDir, mods);
+    writeSyntheticImport(importDir, descriptors);
+
+    auto save = [&]() {
+        auto gameInstance = GameInstance::fromGameDirectory(gameDir.path(), importDir.path(), descriptors);
+        CSMMModpack modpack(gameInstance, mods.begin(), mods.end());
+        modpack.save(gameDir.path());
+    };
+    // the first save writes the tables of the mods into main.dol, which loading reads
+    save();
+
+    auto mainDolSize = QFileInfo(gameDir.filePath(MAIN_DOL)).size();
+    bench.time("pipeline.load", maps, [&]() {
+        auto gameInstance = GameInstance::fromGameDirectory(gameDir.path(), "");
+        CSMMModpack modpack(gameInstance, mods.begin(), mods.end());
+        modpack.load(gameDir.path());
+        return mainDolSize;
+    });
+
+    // the stages of saving are the spans of a trace of each save
+    auto traceFile = workDir.filePath("pipeline.json");
+    QVector<qint64> saveDurations;
+    QMap<QString, QVector<qint64>> spanDurations;
+    for (int i = 0; i < bench.repeat; ++i) {
+        Tracing::start(traceFile);
+        QElapsedTimer timer;
+        timer.start();
+        save();
+        saveDurations.append(timer.nsecsElapsed());
+        Tracing::stop();
+
+        QFile file(traceFile);
+        if (!file.open(QFile::ReadOnly)) {
+            throw std::runtime_error("could not read " + traceFile.toStdString());
+        }
+        for (auto event: QJsonDocument::fromJson(file.readAll())["traceEvents"].toArray()) {
+            auto category = event["cat"].toString(), name = event["name"].toString();
+            if ((category == "mod" && name.startsWith("save ")) || (category == "modpack" && name != "save")) {
+                spanDurations[QString("pipeline.%1.%2").arg(category, name)].append(event["dur"].toInteger() * 1000);
+            }
+        }
+    }
+    bench.record("pipeline.save", maps, saveDurations, mainDolSize);
+    for (auto it = spanDurations.begin(); it != spanDurations.end(); ++it) {
+        bench.record(it.key(), maps, it.value());
+    }
+}
+
+void benchGame(Bench &bench, const QString &gameDir, const QString &modpackFile) {
+    auto mods = ModLoader::importModpackFile(modpackFile);
+    await(ExeWrapper::extractMissingFiles(gameDir, CSMMModpack::fileDependencies(mods.begin(), mods.end())));
+    // saving is timed once as it modifies the game directory
+    auto repeat = bench.repeat;
+    std::vector<MapDescriptor> descriptors;
+    bench.time("game.load", 0, [&]() {
+        auto gameInstance = GameInstance::fromGameDirectory(gameDir, "");
+        CSMMModpack modpack(gameInstance, mods.begin(), mods.end());
+        modpack.load(gameDir);
+        descriptors = gameInstance.mapDescriptors();
+        return (qint64)0;
+    });
+    bench.repeat = 1;
+    QTemporaryDir importDir;
+    bench.time("game.save", (int)descriptors.size(), [&]() {
+        auto gameInstance = GameInstance::fromGameDirectory(gameDir, importDir.path(), descriptors);
+        CSMMModpack modpack(gameInstance, mods.begin(), mods.end());
+        modpack.save(gameDir);
+        return (qint64)0;
+    });
+    bench.repeat = repeat;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (auto exitCode = runFakeTool(argc, argv)) {
+        return *exitCode;
+    }
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("csmm_bench");
+    QCoreApplication::setApplicationVersion(QString("%1").arg(CSMM_VERSION));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the stages of CSMM and prints the results as json.");
+    parser.addHelpOption();
+    QCommandLineOption mapsOption("maps", "Comma separated list of map counts to scale the synthetic fixtures to.", "maps", "40,200,1000");
+    QCommandLineOption repeatOption("repeat", "How often each stage is run; the median is reported.", "repeat", "3");
+    QCommandLineOption gameOption("game", "An extracted Fortune Street game directory to time loading and saving with. "
+                                          "WARNING: the directory is saved to, so pass a copy.", "gameDir");
+    QCommandLineOption modPackOption("modpack", "The modpack file (.zip or modlist.txt) to use with --game (leave blank for default).", "modpack");
+    QCommandLineOption outputOption("output", "Write the json to this file instead of stdout.", "file");
+    parser.addOptions({mapsOption, repeatOption, gameOption, modPackOption, outputOption});
+    parser.process(app);
+
+#ifdef Q_OS_MAC
+    Py_SetPythonHome(QDir(QCoreApplication::applicationDirPath()).filePath("lib").toStdWString().c_str());
+#else
+    Py_SetPythonHome(QDir(QCoreApplication::applicationDirPath()).filePath("py").toStdWString().c_str());
+#endif
+    pybind11::scoped_interpreter guard{};
+
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        qCritical() << "Could not create temporary directory" << workDir.errorString();
+        return 1;
+    }
+
+    Bench bench;
+    bench.repeat = std::max(1, parser.value(repeatOption).toInt());
+    try {
+        QDir toolsDir(QDir(workDir.path()).filePath("tools"));
+        installFakeTools(toolsDir);
+        for (auto &mapsStr: parser.value(mapsOption).split(",", Qt::SkipEmptyParts)) {
+            int maps = mapsStr.toInt();
+            benchConfiguration(bench, maps, workDir.path());
+            benchFreeSpace(bench, maps);
+            benchBsdiff(bench, maps, workDir.path());
+            benchHashing(bench, maps, workDir.path());
+            benchTextures(bench, maps);
+            ExeWrapper::setToolsDirectory(toolsDir.path());
+            benchPipeline(bench, maps, workDir.path());
+            ExeWrapper::setToolsDirectory("");
+        }
+        if (parser.isSet(gameOption)) {
+            benchGame(bench, parser.value(gameOption), parser.value(modPackOption));
+        }
+    } catch (const std::runtime_error &error) {
+        qCritical() << error.what();
+        return 1;
+    }
+
+    QJsonObject report{
+        {"version", QCoreApplication::applicationVersion()},
+        {"commit", qEnvironmentVariable("CSMM_BENCH_COMMIT")},
+        {"results", bench.results}
+    };
+    auto json = QJsonDocument(report).toJson();
+    if (parser.isSet(outputOption)) {
+        QFile outputFile(parser.value(outputOption));
+        if (!outputFile.open(QFile::WriteOnly) || outputFile.write(json) != json.size()) {
+            qCritical() << "Could not write" << outputFile.fileName();
+            return 1;
+        }
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return 0;
+}
@@ -1,4 +1,8 @@
 #include "csmmprogressdialog.h"
+#include <QEventLoop>
+#include <QThread>
+#include <pybind11/embed.h>
+#include "lib/cancellation.h"
 #include "lib/progresscanceled.h"
 
 
@@ -21,3 +25,51 @@ void CSMMProgressDialog::setValue(int progress)
     QProgressDialog::setValue(progress);
 }
 
+void CSMMProgressDialog::runInWorker(const std::function<void (const std::function<void (int)> &)> &job)
+{
+    Cancellation::Token token;
+    auto cancelConnection = connect(this, &QProgressDialog::canceled, this, [token]() mutable {
+        token.cancel();
+    });
+    auto progressConnection = connect(this, &CSMMProgressDialog::workerProgressChanged, this, [this](int progress) {
+        if (!wasCanceled()) {
+            QProgressDialog::setValue(progress);
+        }
+    }, Qt::QueuedConnection);
+
+    std::exception_ptr error;
+    QEventLoop loop;
+    QThread *worker = QThread::create([&]() {
+        Cancellation::Scope scope(token);
+        // python mods run on the worker, so it holds the GIL for the whole job
+        std::unique_ptr<pybind11::gil_scoped_acquire> gil;
+        if (Py_IsInitialized()) {
+            gil = std::make_unique<pybind11::gil_scoped_acquire>();
+        }
+        try {
+            job([this](int progress) {
+                Cancellation::checkpoint();
+                Q_EMIT workerProgressChanged(progress);
+            });
+        } catch (...) {
+            error = std::current_exception();
+        }
+    });
+    connect(worker, &QThread::finished, &loop, &QEventLoop::quit);
+    {
+        std::unique_ptr<pybind11::gil_scoped_release> release;
+        if (Py_IsInitialized()) {
+            release = std::make_unique<pybind11::gil_scoped_release>();
+        }
+        worker->start();
+        loop.exec();
+        worker->wait();
+    }
+    delete worker;
+    disconnect(cancelConnection);
+    disconnect(progressConnection);
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
@@ -4,12 +4,23 @@
 #include <QProgressDialog>
 #include <QObject>
 #include <QException>
+#include <functional>
 
 class CSMMProgressDialog : public QProgressDialog {
+    Q_OBJECT
 public:
     CSMMProgressDialog(QWidget *parent = nullptr, Qt::WindowFlags flags = Qt::WindowFlags());
     CSMMProgressDialog(const QString &labelText, const QString &cancelButtonText, int minimum, int maximum, QWidget *parent = nullptr, Qt::WindowFlags f = Qt::WindowFlags(), bool cancelable = false);
     void setValue(int progress);
+    /**
+     * @brief Runs job on a worker thread and keeps this dialog responsive until it is done; exceptions thrown by
+     * job are rethrown here. job must not touch widgets; it reports progress through the callback it is given,
+     * which delivers the value to this dialog through a queued signal. Canceling the dialog makes the next
+     * Cancellation::checkpoint() in job throw ProgressCanceled.
+     */
+    void runInWorker(const std::function<void(const std::function<void(int)> &setProgress)> &job);
+Q_SIGNALS:
+    void workerProgressChanged(int progress);
 };
 
 #endif // CSMMPROGRESSDIALOG_H
@@ -0,0 +1,113 @@
+#include "assetstore.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QRegularExpression>
+#include <QThread>
+#include <atomic>
+#include <filesystem>
+#include "lib/filecopy.h"
+#include "lib/tracing.h"
+
+namespace Assets {
+
+static QString sha1(const QString &file) {
+    QFile f(file);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!f.open(QFile::ReadOnly) || !hash.addData(&f)) {
+        throw Exception(QString("Could not read %1").arg(file));
+    }
+    return hash.result().toHex();
+}
+
+static void renameOver(const QString &from, const QString &to) {
+    std::error_code error;
+    std::filesystem::rename(from.toStdU16String(), to.toStdU16String(), error);
+    if (error) {
+        QFile::remove(from);
+        throw Exception(QString("Could not move %1 to %2: %3").arg(from, to, QString::fromStdString(error.message())));
+    }
+}
+
+Store::Store(const QString &root) : root(root) {
+}
+
+QString Store::blobPath(const QString &sha1) const {
+    // fan out by the first two hex digits so that no directory gets too large
+    return QDir(root).filePath(sha1.left(2) + "/" + sha1);
+}
+
+QString Store::add(const QString &file) const {
+    auto blob = blobPath(sha1(file));
+    if (QFileInfo::exists(blob)) {
+        return blob;
+    }
+    auto tmp = temporaryFile();
+    try {
+        FileCopy::copyFile(file, tmp);
+    } catch (const FileCopy::Exception &e) {
+        throw Exception(e.what());
+    }
+    QDir().mkpath(QFileInfo(blob).path());
+    renameOver(tmp, blob);
+    return blob;
+}
+
+QString Store::take(const QString &file) const {
+    auto blob = blobPath(sha1(file));
+    if (QFileInfo::exists(blob)) {
+        QFile::remove(file);
+        return blob;
+    }
+    QDir().mkpath(QFileInfo(blob).path());
+    renameOver(file, blob);
+    return blob;
+}
+
+QString Store::temporaryFile() const {
+    static std::atomic<quint64> counter = 0;
+    if (!QDir().mkpath(root)) {
+        throw Exception(QString("Could not create %1").arg(root));
+    }
+    return QDir(root).filePath(QString("tmp-%1-%2").arg(quintptr(QThread::currentThreadId())).arg(counter++));
+}
+
+void Store::materialize(const QString &blob, const QString &dest) const {
+    auto tmp = QString("%1.%2.tmp").arg(dest).arg(quintptr(QThread::currentThreadId()));
+    QFile::remove(tmp);
+    std::error_code error;
+    std::filesystem::create_hard_link(blob.toStdU16String(), tmp.toStdU16String(), error);
+    if (error) {
+        try {
+            FileCopy::copyFile(blob, tmp);
+        } catch (const FileCopy::Exception &e) {
+            throw Exception(e.what());
+        }
+    }
+    renameOver(tmp, dest);
+}
+
+int Store::collectGarbage() const {
+    Tracing::Span span("assets", "collectGarbage");
+    static const QRegularExpression blobName("^[0-9a-f]{40}$");
+    int removed = 0;
+    QDirIterator it(root, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        auto path = it.next();
+        if (!blobName.match(it.fileName()).hasMatch()) {
+            continue;
+        }
+        std::error_code error;
+        auto linkCount = std::filesystem::hard_link_count(path.toStdU16String(), error);
+        // the store's own entry is the only link left
+        if (!error && linkCount <= 1 && QFile::remove(path)) {
+            ++removed;
+        }
+    }
+    span.arg("removed", removed);
+    return removed;
+}
+
+}
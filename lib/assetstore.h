@@ -0,0 +1,63 @@
+#ifndef ASSETSTORE_H
+#define ASSETSTORE_H
+
+#include <QException>
+#include <QString>
+#include <stdexcept>
+
+/**
+ * A content-addressed store of imported assets. Every distinct file content is kept once as a blob named by its
+ * SHA-1, and the paths the mods read from (backgrounds for every locale, shared .brstm and .frb files) are hard
+ * links to the blobs, or copies where the file system cannot link.
+ */
+namespace Assets {
+
+class Store {
+public:
+    /**
+     * @param root the directory the blobs are kept in; created on demand
+     */
+    explicit Store(const QString &root);
+
+    /**
+     * @brief add Copies file into the store.
+     * @return the path of the blob with the file's content
+     */
+    QString add(const QString &file) const;
+    /**
+     * @brief take Moves file into the store; file should be a path returned by temporaryFile().
+     * @return the path of the blob with the file's content
+     */
+    QString take(const QString &file) const;
+    /**
+     * @return a new path inside the store to stage a file at before taking it into the store
+     */
+    QString temporaryFile() const;
+    /**
+     * @brief materialize Replaces dest with a link to blob. dest is replaced atomically, so other links to the
+     * previous file are never modified.
+     */
+    void materialize(const QString &blob, const QString &dest) const;
+    /**
+     * @brief collectGarbage Removes the blobs which nothing links to anymore.
+     * @return the number of blobs removed
+     */
+    int collectGarbage() const;
+private:
+    QString blobPath(const QString &sha1) const;
+
+    QString root;
+};
+
+class Exception : public QException, public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+    const char *what() const noexcept override { return std::runtime_error::what(); }
+    Exception(const QString &str) : std::runtime_error(str.toStdString()) {}
+    void raise() const override { throw *this; }
+    Exception *clone() const override { return new Exception(*this); }
+};
+
+}
+
+#endif // ASSETSTORE_H
@@ -30,6 +30,7 @@ inline T await(QFuture<T> future, int timeout = -1) {
 
 inline void await(QFuture<void> future, int timeout = -1) {
      if (future.isFinished()) {
+         future.waitForFinished(); // throw errors if applicable
          return;
      }
 
@@ -0,0 +1,453 @@
+#include "binarymaplist.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QSaveFile>
+#include <QtEndian>
+#include <fstream>
+#include <filesystem>
+#include <yaml-cpp/yaml.h>
+#include "lib/descriptorcache.h"
+#include "lib/tracing.h"
+#include "lib/zipreader.h"
+
+namespace BinaryMapList {
+
+static constexpr char MAGIC[4] = {'C', 'S', 'M', 'L'};
+static constexpr quint32 VERSION = 2;
+// version 1 lists end their header before the summaries and names fields
+static constexpr quint32 HEADER_SIZE_V1 = 48;
+static constexpr quint32 HEADER_SIZE = 60;
+static constexpr quint32 ENTRY_SIZE = 40;
+static constexpr quint32 SUMMARY_SIZE = 48;
+static constexpr quint32 NAME_SIZE = 8;
+// set in the flags of a summary record if the map descriptor could be read
+static constexpr quint32 SUMMARY_PRESENT = 1;
+static constexpr quint32 BACKGROUND_SIZE = 12;
+static constexpr quint32 FILE_SIZE = 24;
+
+Reader::Reader(const QString &fileName) : file(fileName) {
+    Tracing::Span span("maplist", "open " + QFileInfo(fileName).fileName());
+    if (!file.open(QFile::ReadOnly)) {
+        throw Exception(QString("Could not open %1").arg(fileName));
+    }
+    size = file.size();
+    data = size > 0 ? file.map(0, size) : nullptr;
+    if (!data || size < HEADER_SIZE_V1 || memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        throw Exception(QString("%1 is not a binary map list").arg(fileName));
+    }
+    version = u32(4);
+    if (version < 1 || version > VERSION) {
+        throw Exception(QString("%1 has the unsupported version %2").arg(fileName).arg(version));
+    }
+    entries = u32(8);
+    backgrounds = u32(12);
+    urlCount = u32(16);
+    files = u32(20);
+    entriesOffset = u32(24);
+    backgroundsOffset = u32(28);
+    urlsOffset = u32(32);
+    filesOffset = u32(36);
+    stringsOffset = u32(40);
+    stringsSize = u32(44);
+    if (version >= 2) {
+        summariesOffset = u32(48);
+        names = u32(52);
+        namesOffset = u32(56);
+    }
+    // the accessors check the bounds of every read, so only the tables need to be checked up front
+    auto checkSection = [&](quint64 offset, quint64 length) {
+        if (offset + length > size) {
+            throw Exception(QString("%1 is truncated").arg(fileName));
+        }
+    };
+    checkSection(entriesOffset, quint64(entries) * ENTRY_SIZE);
+    checkSection(backgroundsOffset, quint64(backgrounds) * BACKGROUND_SIZE);
+    checkSection(urlsOffset, quint64(urlCount) * 4);
+    checkSection(filesOffset, quint64(files) * FILE_SIZE);
+    checkSection(stringsOffset, stringsSize);
+    if (version >= 2) {
+        checkSection(summariesOffset, quint64(entries) * SUMMARY_SIZE);
+        checkSection(namesOffset, quint64(names) * NAME_SIZE);
+    }
+}
+
+quint32 Reader::u32(quint64 offset) const {
+    if (offset + 4 > size) {
+        throw Exception(QString("%1 is truncated").arg(file.fileName()));
+    }
+    return qFromLittleEndian<quint32>(data + offset);
+}
+
+qint32 Reader::i32(quint64 offset) const {
+    return (qint32)u32(offset);
+}
+
+quint64 Reader::u64(quint64 offset) const {
+    return u32(offset) | (quint64(u32(offset + 4)) << 32);
+}
+
+QString Reader::string(quint32 ref) const {
+    if (ref == 0xFFFFFFFF) {
+        return QString();
+    }
+    if (quint64(ref) + 4 > stringsSize) {
+        throw Exception(QString("%1 has an invalid string reference").arg(file.fileName()));
+    }
+    quint32 length = u32(stringsOffset + ref);
+    if (quint64(ref) + 4 + length > stringsSize) {
+        throw Exception(QString("%1 has an invalid string reference").arg(file.fileName()));
+    }
+    return QString::fromUtf8((const char *)data + stringsOffset + ref + 4, length);
+}
+
+QVector<QString> Reader::urls(quint32 first, quint32 count) const {
+    if (quint64(first) + count > urlCount) {
+        throw Exception(QString("%1 has an invalid url reference").arg(file.fileName()));
+    }
+    QVector<QString> result;
+    for (quint32 i = 0; i < count; ++i) {
+        result.append(string(u32(urlsOffset + quint64(first + i) * 4)));
+    }
+    return result;
+}
+
+quint64 Reader::record(quint32 sectionOffset, quint32 recordSize, quint32 count, quint32 index) const {
+    if (index >= count) {
+        throw Exception(QString("%1 has no record %2").arg(file.fileName()).arg(index));
+    }
+    return sectionOffset + quint64(index) * recordSize;
+}
+
+int Reader::entryCount() const {
+    return entries;
+}
+
+Configuration::ConfigEntry Reader::entry(int index) const {
+    auto offset = record(entriesOffset, ENTRY_SIZE, entries, index);
+    Configuration::ConfigEntry entry;
+    entry.mapId = i32(offset);
+    entry.mapSet = i32(offset + 4);
+    entry.mapZone = i32(offset + 8);
+    entry.mapOrder = i32(offset + 12);
+    entry.practiceBoard = i32(offset + 16);
+    entry.name = string(u32(offset + 20));
+    entry.mapDescriptorRelativePath = string(u32(offset + 24));
+    entry.mapDescriptorUrls = urls(u32(offset + 28), u32(offset + 32));
+    return entry;
+}
+
+QMap<QString, QVector<QString>> Reader::backgroundPaths() const {
+    QMap<QString, QVector<QString>> result;
+    for (quint32 i = 0; i < backgrounds; ++i) {
+        auto offset = record(backgroundsOffset, BACKGROUND_SIZE, backgrounds, i);
+        result[string(u32(offset))] = urls(u32(offset + 4), u32(offset + 8));
+    }
+    return result;
+}
+
+Configuration::ConfigFile Reader::toConfigFile() const {
+    Configuration::ConfigFile config;
+    config.entries.reserve(entries);
+    for (quint32 i = 0; i < entries; ++i) {
+        config.entries.append(entry(i));
+    }
+    config.backgroundPaths = backgroundPaths();
+    return config;
+}
+
+QStringList Reader::embeddedFiles(int index) const {
+    auto offset = record(entriesOffset, ENTRY_SIZE, entries, index);
+    // the files of an entry are consecutive, the first one is recorded in the upper 24 bits and the count in the lower 8
+    quint32 filesRef = u32(offset + 36);
+    QStringList result;
+    for (quint32 i = 0; i < (filesRef & 0xFF); ++i) {
+        result.append(string(u32(record(filesOffset, FILE_SIZE, files, (filesRef >> 8) + i))));
+    }
+    return result;
+}
+
+std::optional<Summary> Reader::summary(int index) const {
+    if (version < 2) {
+        return std::nullopt;
+    }
+    auto offset = record(summariesOffset, SUMMARY_SIZE, entries, index);
+    if (!(u32(offset) & SUMMARY_PRESENT)) {
+        return std::nullopt;
+    }
+    Summary summary;
+    summary.ruleSet = RuleSet(u32(offset + 4));
+    summary.theme = BoardTheme(u32(offset + 8));
+    summary.initialCash = u32(offset + 12);
+    summary.targetAmount = u32(offset + 16);
+    summary.baseSalary = u32(offset + 20);
+    summary.salaryIncrement = u32(offset + 24);
+    summary.maxDiceRoll = u32(offset + 28);
+    summary.loopingMode = LoopingMode(u32(offset + 32));
+    summary.background = string(u32(offset + 36));
+    quint32 firstName = u32(offset + 40), nameCount = u32(offset + 44);
+    if (quint64(firstName) + nameCount > names) {
+        throw Exception(QString("%1 has an invalid name reference").arg(file.fileName()));
+    }
+    for (quint32 i = 0; i < nameCount; ++i) {
+        auto nameOffset = namesOffset + quint64(firstName + i) * NAME_SIZE;
+        summary.names[string(u32(nameOffset))] = string(u32(nameOffset + 4));
+    }
+    return summary;
+}
+
+void Reader::extractEmbeddedFiles(int index, const QDir &dir) const {
+    auto offset = record(entriesOffset, ENTRY_SIZE, entries, index);
+    quint32 filesRef = u32(offset + 36);
+    for (quint32 i = 0; i < (filesRef & 0xFF); ++i) {
+        auto fileOffset = record(filesOffset, FILE_SIZE, files, (filesRef >> 8) + i);
+        auto name = string(u32(fileOffset));
+        // map lists are shared between users, so an embedded file must not be placed outside of dir
+        auto cleanName = QDir::cleanPath(name);
+        if (name.isEmpty() || QDir::isAbsolutePath(cleanName) || cleanName == ".." || cleanName.startsWith("../")
+                || cleanName.contains(':')) {
+            throw Exception(QString("%1 embeds the file %2 outside of its directory").arg(file.fileName(), name));
+        }
+        auto path = dir.filePath(cleanName);
+        auto blobOffset = u64(fileOffset + 8), blobSize = u64(fileOffset + 16);
+        if (blobOffset + blobSize > size) {
+            throw Exception(QString("%1 is truncated").arg(file.fileName()));
+        }
+        QByteArray blob = QByteArray::fromRawData((const char *)data + blobOffset, blobSize);
+        QFile existing(path);
+        if (existing.size() == qint64(blobSize) && existing.open(QFile::ReadOnly) && existing.readAll() == blob) {
+            continue;
+        }
+        existing.close();
+        dir.mkpath(QFileInfo(path).path());
+        QSaveFile out(path);
+        if (!out.open(QFile::WriteOnly) || out.write(blob) != qint64(blobSize) || !out.commit()) {
+            throw Exception(QString("Could not write %1").arg(path));
+        }
+    }
+}
+
+/**
+ * @return the files next to a map descriptor yaml which it uses as .frb files
+ */
+static QStringList frbFiles(const QString &yamlFile) {
+    std::ifstream stream(std::filesystem::path(yamlFile.toStdU16String()));
+    auto node = YAML::Load(stream);
+    QStringList result;
+    if (node["frbFiles"]) {
+        for (auto &frbFile: node["frbFiles"]) {
+            result.append(QString::fromStdString(frbFile.as<std::string>()) + ".frb");
+        }
+    } else {
+        for (int i = 1; i <= 4; ++i) {
+            auto key = QString("frbFile%1").arg(i).toStdString();
+            if (node[key]) {
+                result.append(QString::fromStdString(node[key].as<std::string>()) + ".frb");
+            }
+        }
+    }
+    result.removeAll(".frb");
+    return result;
+}
+
+/**
+ * @return the map descriptor at descPath, a yaml file or a map zip, or nullopt if it cannot be read
+ */
+static std::optional<MapDescriptor> readDescriptor(const QString &descPath) {
+    QByteArray yaml;
+    try {
+        if (QFileInfo(descPath).suffix() == "zip") {
+            Zip::Reader archive(descPath);
+            QString yamlEntry;
+            for (auto &entry: archive.entries()) {
+                QFileInfo fi(entry);
+                if (fi.suffix() == "yaml" && !fi.completeBaseName().startsWith(".")) {
+                    yamlEntry = entry;
+                }
+            }
+            if (yamlEntry.isEmpty()) {
+                return std::nullopt;
+            }
+            yaml = archive.read(yamlEntry);
+        } else {
+            QFile file(descPath);
+            if (!file.open(QFile::ReadOnly)) {
+                return std::nullopt;
+            }
+            yaml = file.readAll();
+        }
+        MapDescriptor descriptor;
+        if (DescriptorCache::fromYaml(yaml, descriptor)) {
+            return descriptor;
+        }
+    } catch (const std::exception &e) {
+        qWarning() << "could not read" << descPath << ":" << e.what();
+    }
+    return std::nullopt;
+}
+
+class Builder {
+public:
+    QByteArray strings;
+    QVector<quint32> urlRefs;
+
+    quint32 string(const QString &str) {
+        if (str.isNull()) {
+            return 0xFFFFFFFF;
+        }
+        auto utf8 = str.toUtf8();
+        auto it = stringRefs.constFind(utf8);
+        if (it != stringRefs.constEnd()) {
+            return *it;
+        }
+        quint32 ref = strings.size();
+        appendU32(strings, utf8.size());
+        strings.append(utf8);
+        strings.append((4 - strings.size() % 4) % 4, '\0');
+        stringRefs[utf8] = ref;
+        return ref;
+    }
+
+    quint32 urls(const QVector<QString> &urls) {
+        quint32 first = urlRefs.size();
+        for (auto &url: urls) {
+            urlRefs.append(string(url));
+        }
+        return first;
+    }
+
+    static void appendU32(QByteArray &bytes, quint32 value) {
+        char buf[4];
+        qToLittleEndian(value, buf);
+        bytes.append(buf, 4);
+    }
+
+    static void appendU64(QByteArray &bytes, quint64 value) {
+        appendU32(bytes, value & 0xFFFFFFFF);
+        appendU32(bytes, value >> 32);
+    }
+private:
+    QHash<QByteArray, quint32> stringRefs;
+};
+
+void write(const QString &fileName, const Configuration::ConfigFile &config, const QDir &sourceDir, bool embedFiles) {
+    Tracing::Span span("maplist", "write " + QFileInfo(fileName).fileName());
+    Builder builder;
+    QByteArray entryTable, summaryTable, nameTable, backgroundTable, fileTable, blobs;
+    quint32 fileCount = 0, nameCount = 0;
+    for (auto &entry: config.entries) {
+        std::optional<MapDescriptor> descriptor;
+        if (!entry.mapDescriptorRelativePath.isEmpty()) {
+            descriptor = readDescriptor(sourceDir.filePath(entry.mapDescriptorRelativePath));
+        }
+        if (descriptor) {
+            quint32 firstName = nameCount;
+            for (auto name: descriptor->names) {
+                Builder::appendU32(nameTable, builder.string(name.first));
+                Builder::appendU32(nameTable, builder.string(name.second));
+                ++nameCount;
+            }
+            for (quint32 value: {SUMMARY_PRESENT, (quint32)descriptor->ruleSet, (quint32)descriptor->theme,
+                                 descriptor->initialCash, descriptor->targetAmount, descriptor->baseSalary,
+                                 descriptor->salaryIncrement, descriptor->maxDiceRoll, (quint32)descriptor->loopingMode,
+                                 builder.string(descriptor->background), firstName, nameCount - firstName}) {
+                Builder::appendU32(summaryTable, value);
+            }
+        } else {
+            summaryTable.append(SUMMARY_SIZE, '\0');
+        }
+
+        QStringList embedded;
+        if (embedFiles && !entry.mapDescriptorRelativePath.isEmpty()) {
+            auto descPath = sourceDir.filePath(entry.mapDescriptorRelativePath);
+            if (QFileInfo::exists(descPath)) {
+                embedded.append(entry.mapDescriptorRelativePath);
+                if (QFileInfo(descPath).suffix() == "yaml") {
+                    auto descDir = QFileInfo(entry.mapDescriptorRelativePath).path();
+                    for (auto &frbFile: frbFiles(descPath)) {
+                        embedded.append(QDir::cleanPath(descDir + "/" + frbFile));
+                    }
+                }
+            } else {
+                qWarning() << "not embedding" << descPath << "as it does not exist";
+            }
+        }
+        if (embedded.size() > 0xFF || fileCount + embedded.size() > 0xFFFFFF) {
+            throw Exception(QString("Too many files to embed for %1").arg(entry.name));
+        }
+        Builder::appendU32(entryTable, entry.mapId);
+        Builder::appendU32(entryTable, entry.mapSet);
+        Builder::appendU32(entryTable, entry.mapZone);
+        Builder::appendU32(entryTable, entry.mapOrder);
+        Builder::appendU32(entryTable, entry.practiceBoard);
+        Builder::appendU32(entryTable, builder.string(entry.name));
+        Builder::appendU32(entryTable, builder.string(entry.mapDescriptorRelativePath));
+        Builder::appendU32(entryTable, builder.urls(entry.mapDescriptorUrls));
+        Builder::appendU32(entryTable, entry.mapDescriptorUrls.size());
+        Builder::appendU32(entryTable, (fileCount << 8) | embedded.size());
+        for (auto &relativePath: embedded) {
+            QFile embeddedFile(sourceDir.filePath(relativePath));
+            if (!embeddedFile.open(QFile::ReadOnly)) {
+                throw Exception(QString("Could not read %1").arg(embeddedFile.fileName()));
+            }
+            Builder::appendU32(fileTable, builder.string(relativePath));
+            Builder::appendU32(fileTable, 0);
+            // blob offsets are relative to the blob section until the layout is known
+            Builder::appendU64(fileTable, blobs.size());
+            Builder::appendU64(fileTable, embeddedFile.size());
+            blobs.append(embeddedFile.readAll());
+            blobs.append((8 - blobs.size() % 8) % 8, '\0');
+            ++fileCount;
+        }
+    }
+    for (auto it = config.backgroundPaths.begin(); it != config.backgroundPaths.end(); ++it) {
+        Builder::appendU32(backgroundTable, builder.string(it.key()));
+        Builder::appendU32(backgroundTable, builder.urls(it.value()));
+        Builder::appendU32(backgroundTable, it.value().size());
+    }
+    QByteArray urlTable;
+    for (auto ref: builder.urlRefs) {
+        Builder::appendU32(urlTable, ref);
+    }
+
+    quint32 entriesOffset = HEADER_SIZE;
+    quint32 summariesOffset = entriesOffset + entryTable.size();
+    quint32 namesOffset = summariesOffset + summaryTable.size();
+    quint32 backgroundsOffset = namesOffset + nameTable.size();
+    quint32 urlsOffset = backgroundsOffset + backgroundTable.size();
+    quint32 filesOffset = urlsOffset + urlTable.size();
+    quint32 stringsOffset = filesOffset + fileTable.size();
+    quint64 blobsOffset = stringsOffset + builder.strings.size();
+    blobsOffset += (8 - blobsOffset % 8) % 8;
+    for (quint32 i = 0; i < fileCount; ++i) {
+        auto offsetPos = fileTable.data() + i * FILE_SIZE + 8;
+        qToLittleEndian<quint64>(qFromLittleEndian<quint64>(offsetPos) + blobsOffset, offsetPos);
+    }
+
+    QByteArray header(MAGIC, sizeof(MAGIC));
+    for (quint32 value: {VERSION, (quint32)config.entries.size(), (quint32)config.backgroundPaths.size(), (quint32)builder.urlRefs.size(), fileCount,
+                         entriesOffset, backgroundsOffset, urlsOffset, filesOffset, stringsOffset, (quint32)builder.strings.size(),
+                         summariesOffset, nameCount, namesOffset}) {
+        Builder::appendU32(header, value);
+    }
+
+    QSaveFile out(fileName);
+    if (!out.open(QFile::WriteOnly)) {
+        throw Exception(QString("Could not open %1 for writing").arg(fileName));
+    }
+    out.write(header);
+    out.write(entryTable);
+    out.write(summaryTable);
+    out.write(nameTable);
+    out.write(backgroundTable);
+    out.write(urlTable);
+    out.write(fileTable);
+    out.write(builder.strings);
+    out.write(QByteArray(blobsOffset - (stringsOffset + builder.strings.size()), '\0'));
+    out.write(blobs);
+    if (!out.commit()) {
+        throw Exception(QString("Could not write %1").arg(fileName));
+    }
+}
+
+}
@@ -0,0 +1,111 @@
+#ifndef BINARYMAPLIST_H
+#define BINARYMAPLIST_H
+
+#include <QDir>
+#include <QException>
+#include <QFile>
+#include <optional>
+#include <stdexcept>
+#include "lib/configuration.h"
+#include "lib/mapdescriptor.h"
+
+/**
+ * A binary map list (*.csml) with the same contents as a YAML map list, laid out so that it can be memory mapped
+ * and its entries read in any order without parsing the whole file:
+ *
+ *     header          magic "CSML", version, counts and offsets of the sections below
+ *     entries         one fixed size record per map list entry
+ *     summaries       one fixed size record per map list entry with the fields of its map descriptor which are
+ *                     needed to browse and filter map lists (since version 2)
+ *     names           (locale, name) string references of the summaries
+ *     backgrounds     one fixed size record per background download
+ *     urls            string references of the download urls of the entries and backgrounds
+ *     files           fixed size records of the embedded files (path, offset, size)
+ *     strings         length prefixed UTF-8 strings, referenced by their offset in this section
+ *     blobs           the contents of the embedded files
+ *
+ * All integers are little endian. A list may embed the map descriptors it refers to and their .frb files, so that
+ * it can be passed around as one file. Version 1 lists, which have no summaries, can still be read.
+ */
+namespace BinaryMapList {
+
+static const QString SUFFIX = "csml";
+
+/**
+ * @brief Summary The fields of a map descriptor which are needed to browse and filter map lists.
+ */
+struct Summary {
+    QMap<QString, QString> names;
+    RuleSet ruleSet = Standard;
+    BoardTheme theme = Mario;
+    quint32 initialCash = 0;
+    quint32 targetAmount = 0;
+    quint32 baseSalary = 0;
+    quint32 salaryIncrement = 0;
+    quint32 maxDiceRoll = 0;
+    LoopingMode loopingMode = None;
+    QString background;
+};
+
+class Reader {
+public:
+    explicit Reader(const QString &fileName);
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    int entryCount() const;
+    Configuration::ConfigEntry entry(int index) const;
+    QMap<QString, QVector<QString>> backgroundPaths() const;
+    Configuration::ConfigFile toConfigFile() const;
+    /**
+     * @return the paths of the files embedded for the entry, relative to the map list
+     */
+    QStringList embeddedFiles(int index) const;
+    /**
+     * @return the summary of the entry's map descriptor, or nullopt if the descriptor could not be read when the
+     * list was written or the list predates summaries
+     */
+    std::optional<Summary> summary(int index) const;
+    /**
+     * @brief extractEmbeddedFiles Writes the files embedded for the entry into dir, skipping those which already have
+     * the embedded content. Throws if a file would be placed outside of dir.
+     */
+    void extractEmbeddedFiles(int index, const QDir &dir) const;
+private:
+    quint32 u32(quint64 offset) const;
+    qint32 i32(quint64 offset) const;
+    quint64 u64(quint64 offset) const;
+    QString string(quint32 ref) const;
+    QVector<QString> urls(quint32 first, quint32 count) const;
+    quint64 record(quint32 sectionOffset, quint32 recordSize, quint32 count, quint32 index) const;
+
+    QFile file;
+    const uchar *data = nullptr;
+    quint64 size = 0;
+    quint32 version;
+    quint32 entries, backgrounds, urlCount, files, names = 0;
+    quint32 entriesOffset, backgroundsOffset, urlsOffset, filesOffset, stringsOffset, stringsSize;
+    quint32 summariesOffset = 0, namesOffset = 0;
+};
+
+/**
+ * @brief write Writes config as a binary map list.
+ * @param sourceDir the directory the paths in config are relative to
+ * @param embedFiles whether to embed the map descriptors the entries refer to and their .frb files
+ *
+ * The summaries are read from the map descriptors the entries refer to, where they exist in sourceDir.
+ */
+void write(const QString &fileName, const Configuration::ConfigFile &config, const QDir &sourceDir, bool embedFiles);
+
+class Exception : public QException, public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+    const char *what() const noexcept override { return std::runtime_error::what(); }
+    Exception(const QString &str) : std::runtime_error(str.toStdString()) {}
+    void raise() const override { throw *this; }
+    Exception *clone() const override { return new Exception(*this); }
+};
+
+}
+
+#endif // BINARYMAPLIST_H
@@ -0,0 +1,223 @@
+#include "brres.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+#include <QtEndian>
+#include <algorithm>
+
+namespace Brres {
+
+static constexpr quint32 SUB_FILE_ALIGNMENT = 0x20;
+
+static quint32 readU32(const QByteArray &data, quint32 offset) {
+    if (offset + 4 > (quint32)data.size()) {
+        throw Exception(QString("Offset %1 is out of bounds of the brres file").arg(offset));
+    }
+    return qFromBigEndian<quint32>(data.constData() + offset);
+}
+
+static quint16 readU16(const QByteArray &data, quint32 offset) {
+    if (offset + 2 > (quint32)data.size()) {
+        throw Exception(QString("Offset %1 is out of bounds of the brres file").arg(offset));
+    }
+    return qFromBigEndian<quint16>(data.constData() + offset);
+}
+
+static void writeU32(QByteArray &data, quint32 offset, quint32 value) {
+    qToBigEndian<quint32>(value, data.data() + offset);
+}
+
+/**
+ * @return the string at offset; strings are preceded by their length
+ */
+static QString readString(const QByteArray &data, quint32 offset) {
+    quint32 length = readU32(data, offset - 4);
+    if (offset + length > (quint32)data.size()) {
+        throw Exception(QString("String at offset %1 is out of bounds of the brres file").arg(offset));
+    }
+    return QString::fromUtf8(data.constData() + offset, length);
+}
+
+/**
+ * @brief Calls entryCallback with the name, the absolute data offset and the absolute offset of the data offset
+ * field of every entry of the index group at groupOffset.
+ */
+template<class Callback>
+static void forEachGroupEntry(const QByteArray &data, quint32 groupOffset, Callback entryCallback) {
+    quint32 count = readU32(data, groupOffset + 4);
+    // entry 0 is the root of the search tree and has no data
+    for (quint32 i = 1; i <= count; ++i) {
+        quint32 entryOffset = groupOffset + 8 + 16 * i;
+        qint32 nameOffset = readU32(data, entryOffset + 8);
+        qint32 dataOffset = readU32(data, entryOffset + 12);
+        entryCallback(readString(data, groupOffset + nameOffset), groupOffset + dataOffset, entryOffset + 12);
+    }
+}
+
+static bool isRelocatable(const QByteArray &subFile) {
+    // the name at 0x14 is the only string these sub-files reference; everything else is relative to the sub-file
+    return subFile.startsWith("TEX0") || subFile.startsWith("PLT0");
+}
+
+Archive::Archive(const QByteArray &data) : original(data) {
+    if (original.size() < 0x10 || !original.startsWith("bres") || readU16(original, 4) != 0xFEFF) {
+        throw Exception("Not a big endian brres file");
+    }
+    quint32 rootOffset = readU16(original, 0x0C);
+    if (original.mid(rootOffset, 4) != "root") {
+        throw Exception("The brres file has no root section");
+    }
+    forEachGroupEntry(original, rootOffset + 8, [&](const QString &folder, quint32 folderGroupOffset, quint32) {
+        forEachGroupEntry(original, folderGroupOffset, [&](const QString &name, quint32 offset, quint32 dataOffsetField) {
+            Entry entry;
+            entry.path = folder + "/" + name;
+            entry.groupOffset = folderGroupOffset;
+            entry.dataOffsetField = dataOffsetField;
+            entry.offset = offset;
+            entry.size = readU32(original, offset + 4);
+            if (offset + entry.size > (quint32)original.size()) {
+                throw Exception(QString("Sub-file %1 is out of bounds of the brres file").arg(entry.path));
+            }
+            entries.append(entry);
+        });
+    });
+}
+
+Archive Archive::fromFile(const QString &brresFile) {
+    QFile file(brresFile);
+    if (!file.open(QFile::ReadOnly)) {
+        throw Exception(QString("Could not open %1").arg(brresFile));
+    }
+    return Archive(file.readAll());
+}
+
+void Archive::toFile(const QString &brresFile) const {
+    auto data = serialize();
+    QSaveFile file(brresFile);
+    if (!file.open(QFile::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        throw Exception(QString("Could not write %1").arg(brresFile));
+    }
+}
+
+QVector<QString> Archive::paths() const {
+    QVector<QString> result;
+    for (auto &entry: entries) {
+        result.append(entry.path);
+    }
+    return result;
+}
+
+bool Archive::contains(const QString &path) const {
+    return std::any_of(entries.begin(), entries.end(), [&](const Entry &entry) { return entry.path == path; });
+}
+
+int Archive::entryIndex(const QString &path) const {
+    auto it = std::find_if(entries.begin(), entries.end(), [&](const Entry &entry) { return entry.path == path; });
+    if (it == entries.end()) {
+        throw Exception(QString("The brres file has no sub-file %1").arg(path));
+    }
+    return it - entries.begin();
+}
+
+QByteArray Archive::subFile(const QString &path) const {
+    auto &subFileEntry = entries[entryIndex(path)];
+    return subFileEntry.replaced ? subFileEntry.replacement : original.mid(subFileEntry.offset, subFileEntry.size);
+}
+
+void Archive::setSubFile(const QString &path, const QByteArray &data) {
+    auto &subFileEntry = entries[entryIndex(path)];
+    auto magic = original.mid(subFileEntry.offset, 4);
+    if (data.size() < 0x18 || data.left(4) != magic) {
+        throw Exception(QString("The replacement for %1 must be a %2 sub-file").arg(path, QString::fromLatin1(magic)));
+    }
+    if ((quint32)data.size() > subFileEntry.size && !isRelocatable(data)) {
+        throw Exception(QString("The replacement for %1 must not be larger than %2 bytes; only TEX0 and PLT0 sub-files can grow")
+                        .arg(path).arg(subFileEntry.size));
+    }
+    subFileEntry.replacement = data;
+    subFileEntry.replaced = true;
+}
+
+bool Archive::isModified() const {
+    return std::any_of(entries.begin(), entries.end(), [](const Entry &entry) { return entry.replaced; });
+}
+
+void Archive::extractTo(const QString &dir) const {
+    QDir root(dir);
+    for (auto &entry: entries) {
+        auto filePath = root.filePath(entry.path);
+        QFile file(filePath);
+        auto data = subFile(entry.path);
+        if (!root.mkpath(QFileInfo(entry.path).path()) || !file.open(QFile::WriteOnly) || file.write(data) != data.size()) {
+            throw Exception(QString("Could not write %1").arg(filePath));
+        }
+    }
+}
+
+bool Archive::updateFrom(const QString &dir) {
+    QDir root(dir);
+    QSet<QString> files;
+    QDirIterator it(dir, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        files.insert(root.relativeFilePath(it.next()));
+    }
+    auto archivePaths = paths();
+    if (files != QSet<QString>(archivePaths.begin(), archivePaths.end())) {
+        return false;
+    }
+    Archive updated = *this;
+    for (auto &path: archivePaths) {
+        QFile file(root.filePath(path));
+        if (!file.open(QFile::ReadOnly)) {
+            throw Exception(QString("Could not open %1").arg(file.fileName()));
+        }
+        auto data = file.readAll();
+        if (data == subFile(path)) {
+            continue;
+        }
+        try {
+            updated.setSubFile(path, data);
+        } catch (const Exception &) {
+            return false;
+        }
+    }
+    *this = updated;
+    return true;
+}
+
+QByteArray Archive::serialize() const {
+    QByteArray result = original;
+    for (auto &entry: entries) {
+        if (!entry.replaced) {
+            continue;
+        }
+        auto replacement = entry.replacement;
+        bool relocatable = isRelocatable(replacement);
+        quint32 offset = entry.offset;
+        if ((quint32)replacement.size() > entry.size) {
+            offset = (result.size() + SUB_FILE_ALIGNMENT - 1) / SUB_FILE_ALIGNMENT * SUB_FILE_ALIGNMENT;
+            result.resize(offset, '\0');
+            writeU32(result, entry.dataOffsetField, offset - entry.groupOffset);
+        }
+        // the sub-file points back to the start of the brres file
+        writeU32(replacement, 0x0C, -(qint32)offset);
+        if (relocatable) {
+            // keep the original name from the string table
+            quint32 nameAddress = entry.offset + readU32(original, entry.offset + 0x14);
+            writeU32(replacement, 0x14, nameAddress - offset);
+        }
+        if (offset == entry.offset) {
+            std::copy(replacement.begin(), replacement.end(), result.begin() + offset);
+            std::fill(result.begin() + offset + replacement.size(), result.begin() + offset + entry.size, '\0');
+        } else {
+            result += replacement;
+        }
+    }
+    writeU32(result, 0x08, result.size());
+    return result;
+}
+
+}
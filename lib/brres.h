@@ -0,0 +1,85 @@
+#ifndef BRRES_H
+#define BRRES_H
+
+#include <QByteArray>
+#include <QException>
+#include <QString>
+#include <QVector>
+#include <stdexcept>
+
+namespace Brres {
+
+/**
+ * @brief An in-memory .brres archive whose sub-files (TEX0, PLT0, MDL0, …) can be read and replaced as buffers.
+ *
+ * The index groups and the string table are kept as they are, so sub-files can be replaced but not added,
+ * removed or renamed. Sub-files which do not grow are written in place; grown TEX0 and PLT0 sub-files are moved
+ * to the end of the archive since their only reference into the string table is their name. An archive without
+ * replaced sub-files serializes to exactly the bytes it was read from.
+ */
+class Archive {
+public:
+    explicit Archive(const QByteArray &data);
+
+    static Archive fromFile(const QString &brresFile);
+    void toFile(const QString &brresFile) const;
+
+    /**
+     * @return the paths of the sub-files, named like wszst extracts them (e.g. "Textures(NW4R)/name")
+     */
+    QVector<QString> paths() const;
+    bool contains(const QString &path) const;
+    /**
+     * @return the current contents of the sub-file at path
+     */
+    QByteArray subFile(const QString &path) const;
+    /**
+     * @brief Replaces the contents of the sub-file at path.
+     */
+    void setSubFile(const QString &path, const QByteArray &data);
+    /**
+     * @return whether any sub-file has been replaced
+     */
+    bool isModified() const;
+
+    /**
+     * @brief Writes the current contents of every sub-file below dir, laid out like wszst extracts the archive.
+     */
+    void extractTo(const QString &dir) const;
+    /**
+     * @brief Replaces the sub-files which differ from the files below dir, as written by extractTo and then modified.
+     * @return false, leaving the archive unchanged, if files were added or removed below dir or a sub-file was
+     * replaced in a way the archive cannot represent; the directory must then be packed with wszst
+     */
+    bool updateFrom(const QString &dir);
+
+    QByteArray serialize() const;
+private:
+    struct Entry {
+        QString path;
+        quint32 groupOffset; // absolute offset of the index group that references the sub-file
+        quint32 dataOffsetField; // absolute offset of the index group entry field holding the sub-file offset
+        quint32 offset;
+        quint32 size;
+        QByteArray replacement;
+        bool replaced = false;
+    };
+
+    int entryIndex(const QString &path) const;
+
+    QByteArray original;
+    QVector<Entry> entries;
+};
+
+class Exception : public QException, public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+    const char *what() const noexcept override { return std::runtime_error::what(); }
+    Exception(const QString &str) : std::runtime_error(str.toStdString()) {}
+    void raise() const override { throw *this; }
+    Exception *clone() const override { return new Exception(*this); }
+};
+
+}
+
+#endif // BRRES_H
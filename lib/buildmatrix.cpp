@@ -0,0 +1,313 @@
+#include "buildmatrix.h"
+
+#include <QDirIterator>
+#include <QTemporaryDir>
+#include <filesystem>
+#include <fstream>
+#include <yaml-cpp/yaml.h>
+#include "lib/await.h"
+#include "lib/configuration.h"
+#include "lib/exewrapper.h"
+#include "lib/filecopy.h"
+#include "lib/gameinstance.h"
+#include "lib/riivolution.h"
+#include "lib/tracing.h"
+#include "lib/mods/csmmmodpack.h"
+#include "lib/mods/modloader.h"
+
+namespace BuildMatrix {
+
+static QStringList toStringList(const YAML::Node &node) {
+    QStringList result;
+    if (!node.IsDefined() || node.IsNull()) {
+        return result;
+    }
+    if (node.IsSequence()) {
+        for (auto it = node.begin(); it != node.end(); ++it) {
+            result.append(QString::fromStdString(it->as<std::string>()));
+        }
+    } else {
+        result.append(QString::fromStdString(node.as<std::string>()));
+    }
+    return result;
+}
+
+static Format formatFromString(const QString &str) {
+    if (str == "wbfs") return Format::Wbfs;
+    if (str == "iso") return Format::Iso;
+    if (str == "folder") return Format::Folder;
+    if (str == "riivolution") return Format::Riivolution;
+    throw Exception(QString("unknown output format '%1'; expected wbfs, iso, folder or riivolution").arg(str));
+}
+
+QString formatToString(Format format) {
+    switch (format) {
+    case Format::Wbfs: return "wbfs";
+    case Format::Iso: return "iso";
+    case Format::Folder: return "folder";
+    case Format::Riivolution: return "riivolution";
+    }
+    return QString();
+}
+
+/**
+ * @return the part of the variant name for an axis value, or an empty string if the axis has a single value
+ */
+static QString namePart(const QStringList &paths, int axisSize) {
+    if (axisSize <= 1) {
+        return QString();
+    }
+    QStringList names;
+    for (auto &path: paths) {
+        names.append(QFileInfo(path).completeBaseName());
+    }
+    return names.isEmpty() ? "default" : names.join('+');
+}
+
+Matrix parse(const QString &matrixFile) {
+    YAML::Node node;
+    try {
+        std::ifstream stream(std::filesystem::path(matrixFile.toStdU16String()));
+        if (!stream) {
+            throw Exception(QString("could not open %1").arg(matrixFile));
+        }
+        node = YAML::Load(stream);
+    } catch (const YAML::Exception &exception) {
+        throw Exception(QString("could not parse %1: %2").arg(matrixFile, exception.what()));
+    }
+    QDir matrixDir = QFileInfo(matrixFile).absoluteDir();
+    auto resolve = [&](const QString &path) { return QDir::cleanPath(matrixDir.absoluteFilePath(path)); };
+
+    Matrix matrix;
+    QVector<QStringList> modpackAxis;
+    QStringList baseAxis, mapListAxis;
+    QVector<Format> formatAxis;
+    try {
+        for (auto &base: toStringList(node["base"])) {
+            baseAxis.append(resolve(base));
+        }
+        auto modpacksNode = node["modpacks"];
+        if (modpacksNode.IsDefined() && modpacksNode.IsSequence()) {
+            for (auto it = modpacksNode.begin(); it != modpacksNode.end(); ++it) {
+                QStringList modpacks;
+                for (auto &modpack: toStringList(*it)) {
+                    modpacks.append(resolve(modpack));
+                }
+                modpackAxis.append(modpacks);
+            }
+        } else if (modpacksNode.IsDefined() && !modpacksNode.IsNull()) {
+            modpackAxis.append({resolve(QString::fromStdString(modpacksNode.as<std::string>()))});
+        }
+        for (auto &mapList: toStringList(node["mapLists"])) {
+            mapListAxis.append(resolve(mapList));
+        }
+        for (auto &format: toStringList(node["formats"])) {
+            formatAxis.append(formatFromString(format));
+        }
+        if (node["markerCode"].IsDefined()) {
+            matrix.markerCode = QString::fromStdString(node["markerCode"].as<std::string>());
+        }
+        if (node["separateSaveGame"].IsDefined()) {
+            matrix.separateSaveGame = node["separateSaveGame"].as<bool>();
+        }
+        if (node["riivolutionName"].IsDefined()) {
+            matrix.riivolutionName = QString::fromStdString(node["riivolutionName"].as<std::string>());
+        }
+    } catch (const YAML::Exception &exception) {
+        throw Exception(QString("invalid matrix %1: %2").arg(matrixFile, exception.what()));
+    }
+    if (baseAxis.isEmpty()) {
+        throw Exception(QString("the matrix %1 has no base").arg(matrixFile));
+    }
+    if (!Riivolution::validateRiivolutionName(matrix.riivolutionName)) {
+        throw Exception(QString("the Riivolution patch name %1 is invalid").arg(matrix.riivolutionName));
+    }
+    if (modpackAxis.isEmpty()) modpackAxis.append(QStringList());
+    if (mapListAxis.isEmpty()) mapListAxis.append(QString());
+    if (formatAxis.isEmpty()) formatAxis.append(Format::Wbfs);
+
+    QSet<QString> names;
+    for (auto &base: baseAxis) {
+        for (auto &modpacks: modpackAxis) {
+            for (auto &mapList: mapListAxis) {
+                QStringList nameParts{namePart({base}, baseAxis.size()), namePart(modpacks, modpackAxis.size()),
+                                      namePart(mapList.isEmpty() ? QStringList() : QStringList{mapList}, mapListAxis.size())};
+                nameParts.removeAll(QString());
+                auto name = nameParts.isEmpty() ? QFileInfo(matrixFile).completeBaseName() : nameParts.join('-');
+                if (names.contains(name)) {
+                    throw Exception(QString("two variants of %1 would be named %2").arg(matrixFile, name));
+                }
+                names.insert(name);
+                for (auto format: formatAxis) {
+                    matrix.variants.append({name, base, modpacks, mapList, format});
+                }
+            }
+        }
+    }
+    return matrix;
+}
+
+static QString findMapList(const QStringList &modpacks) {
+    if (modpacks.isEmpty() || QFileInfo(modpacks.first()).suffix() != "zip") {
+        return QString();
+    }
+    QDirIterator it(ModLoader::extractedModpackRoot(modpacks.first()), {"map[Ll]ist.yaml", "map[Ll]ist.yml"}, QDir::Files, QDirIterator::Subdirectories);
+    return it.hasNext() ? it.next() : QString();
+}
+
+static QString outputPath(const QDir &outputDir, const Variant &variant) {
+    switch (variant.format) {
+    case Format::Wbfs: return outputDir.filePath(variant.name + ".wbfs");
+    case Format::Iso: return outputDir.filePath(variant.name + ".iso");
+    case Format::Folder: return outputDir.filePath(variant.name);
+    case Format::Riivolution: return outputDir.filePath(variant.name + "-riivolution");
+    }
+    return QString();
+}
+
+QStringList build(const Matrix &matrix, const QString &outputDir, int jobs, bool overwrite,
+                  const std::function<void(double)> &progressCallback) {
+    QDir output(outputDir);
+    if (!output.mkpath(".")) {
+        throw Exception(QString("could not create %1").arg(outputDir));
+    }
+    QStringList outputs;
+    for (auto &variant: matrix.variants) {
+        auto path = outputPath(output, variant);
+        if (QFileInfo::exists(path)) {
+            if (!overwrite) {
+                throw Exception(QString("%1 already exists").arg(path));
+            }
+            if (QFileInfo(path).isDir()) {
+                QDir(path).removeRecursively();
+            } else {
+                QFile::remove(path);
+            }
+        }
+        outputs.append(path);
+    }
+
+    // working directories live in the output directory so that the copies to it can be cloned
+    QTemporaryDir workDir(output.filePath("csmm_build_matrix_XXXXXX"));
+    if (!workDir.isValid()) {
+        throw Exception(QString("could not create a working directory in %1").arg(outputDir));
+    }
+    QDir work(workDir.path());
+
+    QHash<QString, QString> baseDirs;
+    QHash<QString, ModListType> modLists;
+    QHash<QString, std::vector<MapDescriptor>> vanillaDescriptors;
+    QHash<QString, QString> importDirs;
+    QHash<QString, std::vector<MapDescriptor>> loadedDescriptors;
+    QVector<QFuture<QString>> packs;
+
+    auto waitForPacks = [&](int maxRunning) {
+        while (packs.size() > maxRunning) {
+            await(packs.takeFirst());
+        }
+    };
+
+    try {
+        for (int start = 0; start < matrix.variants.size();) {
+            // variants which only differ in the format share the saved game directory
+            auto &first = matrix.variants[start];
+            int end = start;
+            while (end < matrix.variants.size() && matrix.variants[end].name == first.name) {
+                ++end;
+            }
+            progressCallback((double)start / matrix.variants.size());
+            qInfo() << "Building" << first.name;
+            Tracing::Span variantSpan("matrix", first.name);
+
+            if (!baseDirs.contains(first.base)) {
+                // the variants are copied from a private copy of the base, which is completed from the image once
+                auto baseDir = work.filePath(QString("base-%1").arg(baseDirs.size()));
+                if (QFileInfo(first.base).isDir()) {
+                    qInfo() << "Copying" << first.base;
+                    FileCopy::copyTree(first.base, baseDir);
+                    await(ExeWrapper::extractMissingFiles(baseDir));
+                } else {
+                    qInfo() << "Extracting" << first.base;
+                    await(ExeWrapper::extractWbfsIso(first.base, baseDir));
+                }
+                baseDirs[first.base] = baseDir;
+            }
+            auto baseDir = baseDirs[first.base];
+
+            auto modsKey = first.modpacks.join('\n');
+            if (!modLists.contains(modsKey)) {
+                modLists[modsKey] = ModLoader::importModpackCollection(first.modpacks);
+            }
+            auto &mods = modLists[modsKey];
+
+            auto vanillaKey = first.base + '\n' + modsKey;
+            if (!vanillaDescriptors.contains(vanillaKey)) {
+                auto gameInstance = GameInstance::fromGameDirectory(baseDir, "");
+                CSMMModpack modpack(gameInstance, mods.begin(), mods.end());
+                modpack.load(baseDir);
+                vanillaDescriptors[vanillaKey] = gameInstance.mapDescriptors();
+            }
+
+            auto mapList = first.mapList.isEmpty() ? findMapList(first.modpacks) : first.mapList;
+            if (!importDirs.contains(mapList)) {
+                importDirs[mapList] = work.filePath(QString("import-%1").arg(importDirs.size()));
+                work.mkpath(importDirs[mapList]);
+            }
+            auto importDir = importDirs[mapList];
+            // variants which share the base, the modpacks and the map list share the imported descriptors
+            auto loadedKey = vanillaKey + '\n' + mapList;
+            if (!loadedDescriptors.contains(loadedKey)) {
+                auto descriptors = vanillaDescriptors[vanillaKey];
+                if (!mapList.isEmpty()) {
+                    Configuration::load(mapList, descriptors, importDir);
+                }
+                loadedDescriptors[loadedKey] = descriptors;
+            }
+            auto &descriptors = loadedDescriptors[loadedKey];
+
+            // a copy of the base rather than links to it, as the mods modify files in place; the copy clones the
+            // files where the file system supports reflinks, so it only takes space for the files which are saved
+            auto variantDir = work.filePath(QString("variant-%1").arg(start));
+            FileCopy::copyTree(baseDir, variantDir);
+            auto gameInstance = GameInstance::fromGameDirectory(variantDir, importDir, descriptors);
+            CSMMModpack modpack(gameInstance, mods.begin(), mods.end());
+            modpack.save(variantDir);
+
+            bool patchWiimmfi = std::any_of(mods.begin(), mods.end(), [](const auto &mod) { return mod->modId() == "wifiFix"; });
+            for (int i = start; i < end; ++i) {
+                auto &variant = matrix.variants[i];
+                switch (variant.format) {
+                case Format::Wbfs:
+                case Format::Iso:
+                    waitForPacks(jobs - 1);
+                    qInfo() << "Packing" << outputs[i];
+                    packs.append(ExeWrapper::createWbfsIso(variantDir, outputs[i], matrix.markerCode, matrix.separateSaveGame, patchWiimmfi));
+                    break;
+                case Format::Folder: {
+                    qInfo() << "Copying" << variant.name << "to" << outputs[i];
+                    FileCopy::copyTree(variantDir, outputs[i]);
+                    break;
+                }
+                case Format::Riivolution:
+                    qInfo() << "Writing Riivolution patch" << outputs[i];
+                    QDir().mkpath(outputs[i]);
+                    FileCopy::copyTree(variantDir, QDir(outputs[i]).filePath(matrix.riivolutionName));
+                    Riivolution::write(baseDir, outputs[i], gameInstance.addressMapper(), matrix.riivolutionName);
+                    break;
+                }
+            }
+            start = end;
+        }
+        waitForPacks(0);
+    } catch (...) {
+        // the packs read from the working directory, which is removed on return
+        for (auto &pack: packs) {
+            pack.waitForFinished();
+        }
+        throw;
+    }
+    progressCallback(1);
+    return outputs;
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef BUILDMATRIX_H
+#define BUILDMATRIX_H
+
+#include <QException>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+#include <stdexcept>
+
+/**
+ * Builds several variants of a game in one run from a matrix file like
+ *
+ *     base: [ST7E01.wbfs, ST7P01.wbfs]       # disc images or game directories
+ *     modpacks:                               # each entry is a modpack zip or a list of zips; default mods if omitted
+ *       - modpack.zip
+ *       - [modpack.zip, extras.zip]
+ *     mapLists: [maps.yaml]                   # the map list in the modpack if omitted
+ *     formats: [wbfs, iso, folder, riivolution]
+ *     markerCode: "02"
+ *     separateSaveGame: false
+ *     riivolutionName: csmm
+ *
+ * where every combination of base, modpacks, map list and format is one variant. Paths are relative to the matrix
+ * file. Each base is extracted or copied once into the working directory, which the variants are copied from (cloned
+ * where the file system supports reflinks), and the mods, the loaded vanilla maps and the maps loaded from each map
+ * list are shared between the variants that use them. Variants which only differ in the format are saved once.
+ */
+namespace BuildMatrix {
+
+enum class Format {
+    Wbfs,
+    Iso,
+    Folder,
+    Riivolution
+};
+
+struct Variant {
+    QString name;
+    QString base;
+    QStringList modpacks;
+    QString mapList;
+    Format format;
+};
+
+struct Matrix {
+    QVector<Variant> variants;
+    QString markerCode = "02";
+    bool separateSaveGame = false;
+    QString riivolutionName = "csmm";
+};
+
+Matrix parse(const QString &matrixFile);
+
+/**
+ * @brief build Builds the variants of the matrix into outputDir.
+ * The mods of one variant are saved while the disc images of the previous variants are still being packed.
+ * @param jobs the maximum number of disc images packed at the same time
+ * @param overwrite whether existing outputs are replaced instead of failing the build
+ * @return the paths of the outputs, in the order of the variants
+ */
+QStringList build(const Matrix &matrix, const QString &outputDir, int jobs, bool overwrite,
+                  const std::function<void(double)> &progressCallback = [](double) {});
+
+QString formatToString(Format format);
+
+class Exception : public QException, public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+    const char *what() const noexcept override { return std::runtime_error::what(); }
+    Exception(const QString &str) : std::runtime_error(str.toStdString()) {}
+    void raise() const override { throw *this; }
+    Exception *clone() const override { return new Exception(*this); }
+};
+
+}
+
+#endif // BUILDMATRIX_H
@@ -0,0 +1,58 @@
+#include "cancellation.h"
+
+#include <QTimer>
+#include "lib/progresscanceled.h"
+
+namespace Cancellation {
+
+// how often watch() polls the token; keeps canceling a running process well below a second
+static constexpr int WATCH_INTERVAL_MS = 100;
+
+static thread_local const Token *currentToken = nullptr;
+
+void Token::cancel() {
+    canceled->store(true);
+}
+
+bool Token::isCanceled() const {
+    return canceled->load();
+}
+
+Scope::Scope(const Token &token) : previous(currentToken), token(token) {
+    currentToken = &this->token;
+}
+
+Scope::~Scope() {
+    currentToken = previous;
+}
+
+const Token *current() {
+    return currentToken;
+}
+
+bool isCanceled() {
+    return currentToken && currentToken->isCanceled();
+}
+
+void checkpoint() {
+    if (isCanceled()) {
+        throw ProgressCanceled("Canceled");
+    }
+}
+
+void watch(QObject *context, const std::function<void()> &onCanceled) {
+    if (!currentToken) {
+        return;
+    }
+    auto token = *currentToken;
+    auto timer = new QTimer(context);
+    QObject::connect(timer, &QTimer::timeout, context, [=]() {
+        if (token.isCanceled()) {
+            timer->stop();
+            onCanceled();
+        }
+    });
+    timer->start(WATCH_INTERVAL_MS);
+}
+
+}
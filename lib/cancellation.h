@@ -0,0 +1,64 @@
+#ifndef CANCELLATION_H
+#define CANCELLATION_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <atomic>
+#include <functional>
+
+/**
+ * Cooperative cancellation of long running jobs. A job runs with a token installed for its thread and calls
+ * checkpoint() between units of work (mods, archive jobs, downloads), which throws ProgressCanceled once the
+ * token has been canceled from any thread.
+ */
+namespace Cancellation {
+
+/**
+ * @brief A thread safe cancellation flag; copies share the flag.
+ */
+class Token {
+public:
+    void cancel();
+    bool isCanceled() const;
+private:
+    QSharedPointer<std::atomic<bool>> canceled = QSharedPointer<std::atomic<bool>>::create(false);
+};
+
+/**
+ * @brief Installs token as the current thread's token for the lifetime of the scope.
+ */
+class Scope {
+public:
+    explicit Scope(const Token &token);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+private:
+    const Token *previous;
+    Token token;
+};
+
+/**
+ * @return the current thread's token, or nullptr if the thread runs without one
+ */
+const Token *current();
+
+/**
+ * @return whether the current thread's token has been canceled
+ */
+bool isCanceled();
+
+/**
+ * @brief checkpoint Throws ProgressCanceled if the current thread's token has been canceled.
+ */
+void checkpoint();
+
+/**
+ * @brief Calls onCanceled once on context's thread when the current thread's token is canceled while context
+ * is alive. Does nothing if the current thread runs without a token.
+ */
+void watch(QObject *context, const std::function<void()> &onCanceled);
+
+}
+
+#endif // CANCELLATION_H
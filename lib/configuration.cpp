@@ -6,9 +6,13 @@
 #include <fstream>
 #include <filesystem>
 #include <QRegularExpression>
+#include <QThread>
+#include <QThreadPool>
 #include "importexportutils.h"
+#include "lib/binarymaplist.h"
 #include "lib/asyncfuture/asyncfuture.h"
 #include "lib/await.h"
+#include "lib/cancellation.h"
 #include "lib/csmmnetworkmanager.h"
 #include "lib/progresscanceled.h"
 
@@ -43,7 +47,7 @@ QString ConfigFile::toCsv() {
     return result;
 }
 
-QString ConfigFile::toYaml()
+QString ConfigFile::toYaml(const QString &backgroundsFile)
 {
     YAML::Emitter emitter;
     emitter << YAML::BeginDoc;
@@ -53,7 +57,11 @@ QString ConfigFile::toYaml()
         mapSets.insert(entry.mapSet);
         zones.insert(entry.mapZone);
     }
-    emitter << YAML::Comment("optional: add the backgrounds key to point to a list of backgrounds in cswt yaml format");
+    if (backgroundsFile.isEmpty()) {
+        emitter << YAML::Comment("optional: add the backgrounds key to point to a list of backgrounds in cswt yaml format");
+    } else {
+        emitter << YAML::Key << "backgrounds" << YAML::Value << backgroundsFile.toStdString();
+    }
     for (int mapSet: mapSets) {
         emitter << YAML::Key << mapSet << YAML::Comment("Map Set");
         emitter << YAML::Value;
@@ -69,7 +77,11 @@ QString ConfigFile::toYaml()
                             << YAML::Comment("Path relative to this file to the descriptor yaml, or !default<mapid>_<internalname> if left as default");
                     emitter << YAML::Value;
                     emitter << YAML::BeginMap;
-                    emitter << YAML::Key << "urls" << YAML::Value << std::vector<std::string>() << YAML::Comment("Can be omitted, list of urls to download board from");
+                    std::vector<std::string> urls;
+                    for (auto &url: entry.mapDescriptorUrls) {
+                        urls.push_back(url.toStdString());
+                    }
+                    emitter << YAML::Key << "urls" << YAML::Value << urls << YAML::Comment("Can be omitted, list of urls to download board from");
                     emitter << YAML::Key << "mapId" << YAML::Value << entry.mapId << YAML::Comment("Omit to deduce map id from order in file");
                     emitter << YAML::Key << "mapOrder" << YAML::Value << entry.mapOrder << YAML::Comment("Omit to deduce map order in mapSet/zone from order in file");
                     emitter << YAML::Key << "practiceBoard" << YAML::Value << (bool)entry.practiceBoard << YAML::Comment("Defaults to false");
@@ -197,8 +209,11 @@ static ConfigFile parseYaml(const QString &fileName) {
 
 // open and parse the config file
 static ConfigFile parse(const QString &fileName) {
-    if (QFileInfo(fileName).suffix() == "csv") {
+    auto suffix = QFileInfo(fileName).suffix();
+    if (suffix == "csv") {
         return parseLegacy(fileName);
+    } else if (suffix == BinaryMapList::SUFFIX) {
+        return BinaryMapList::Reader(fileName).toConfigFile();
     } else {
         return parseYaml(fileName);
     }
@@ -267,11 +282,15 @@ int ConfigFile::maxOrder(int mapSet, int zone) {
 
 void save(const QString &fileName, const std::vector<MapDescriptor> &descriptors)
 {
+    ConfigFile config = parse(descriptors, fileName);
+    if (QFileInfo(fileName).suffix() == BinaryMapList::SUFFIX) {
+        BinaryMapList::write(fileName, config, QFileInfo(fileName).dir(), false);
+        return;
+    }
     QSaveFile file(fileName);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         throw std::runtime_error("Could not open file for saving");
     }
-    ConfigFile config = parse(descriptors, fileName);
     QTextStream out(&file);
     out << config.toYaml();
     if (!file.commit()) {
@@ -279,9 +298,88 @@ void save(const QString &fileName, const std::vector<MapDescriptor> &descriptors
     }
 }
 
+void convert(const QString &fromFileName, const QString &toFileName, bool embedFiles)
+{
+    ConfigFile config = parse(fromFileName);
+    QDir fromDir = QFileInfo(fromFileName).dir(), toDir = QFileInfo(toFileName).dir();
+    // keep the paths pointing to the same files when converting into another directory
+    for (auto &entry: config.entries) {
+        if (!entry.mapDescriptorRelativePath.isEmpty()) {
+            entry.mapDescriptorRelativePath = toDir.relativeFilePath(fromDir.filePath(entry.mapDescriptorRelativePath));
+        }
+    }
+    if (QFileInfo(toFileName).suffix() == BinaryMapList::SUFFIX) {
+        BinaryMapList::write(toFileName, config, toDir, embedFiles);
+        return;
+    }
+    if (QFileInfo(fromFileName).suffix() == BinaryMapList::SUFFIX) {
+        // the embedded files are written where the yaml map list expects them
+        BinaryMapList::Reader reader(fromFileName);
+        for (int i = 0; i < reader.entryCount(); ++i) {
+            reader.extractEmbeddedFiles(i, fromDir);
+        }
+    }
+    if (QFileInfo(toFileName).suffix() == "csv") {
+        // the legacy format has no place for download urls
+        if (!config.backgroundPaths.isEmpty()
+                || std::any_of(config.entries.begin(), config.entries.end(), [](auto &entry) { return !entry.mapDescriptorUrls.empty(); })) {
+            qWarning() << "The download urls of" << fromFileName << "are not kept in" << toFileName;
+        }
+        QSaveFile file(toFileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            throw std::runtime_error("Could not open file for saving");
+        }
+        QTextStream out(&file);
+        out << config.toCsv();
+        out.flush();
+        if (!file.commit()) {
+            throw std::runtime_error("There was an error writing the file");
+        }
+        return;
+    }
+    QString backgroundsFile;
+    if (!config.backgroundPaths.isEmpty()) {
+        backgroundsFile = QFileInfo(toFileName).completeBaseName() + ".backgrounds.yaml";
+        YAML::Emitter emitter;
+        emitter << YAML::BeginSeq;
+        for (auto it = config.backgroundPaths.begin(); it != config.backgroundPaths.end(); ++it) {
+            std::vector<std::string> urls;
+            for (auto &url: it.value()) {
+                urls.push_back(url.toStdString());
+            }
+            emitter << YAML::BeginMap;
+            emitter << YAML::Key << "background" << YAML::Value << it.key().toStdString();
+            emitter << YAML::Key << "download" << YAML::Value << urls;
+            emitter << YAML::EndMap;
+        }
+        emitter << YAML::EndSeq;
+        QSaveFile bgFile(toDir.filePath(backgroundsFile));
+        if (!bgFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            throw std::runtime_error("Could not open file for saving");
+        }
+        bgFile.write(emitter.c_str());
+        if (!bgFile.commit()) {
+            throw std::runtime_error("There was an error writing the file");
+        }
+    }
+    QSaveFile file(toFileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        throw std::runtime_error("Could not open file for saving");
+    }
+    QTextStream out(&file);
+    out << config.toYaml(backgroundsFile);
+    out.flush();
+    if (!file.commit()) {
+        throw std::runtime_error("There was an error writing the file");
+    }
+}
+
 // creates/updates the configuration file with the given arguments
 void import(const QString &fileName, const std::optional<QFileInfo>& mapDescriptorFile, const std::optional<int>& mapId, const std::optional<int>& mapSet, const std::optional<int>& zone, const std::optional<int>& order, const std::optional<int>& practiceBoard)
 {
+    if (QFileInfo(fileName).suffix() == BinaryMapList::SUFFIX) {
+        throw std::runtime_error("Binary map lists cannot be edited, convert the map list to yaml first");
+    }
     ConfigFile config = parse(fileName);
     QFileInfo fileInfo(fileName);
     QDir dir(fileInfo.dir());
@@ -359,6 +457,7 @@ void load(const QString &fileName, std::vector<MapDescriptor> &descriptors, cons
              it != configFile.backgroundPaths.end();
              ++it) {
 
+            Cancellation::checkpoint();
             qInfo() << "Downloading background:" << it.key();
             for (auto &url: it.value()) {
                 auto dest = dir.filePath(it.key() + ".background.zip");
@@ -377,14 +476,31 @@ void load(const QString &fileName, std::vector<MapDescriptor> &descriptors, cons
             ++i;
         }
     }
+    // binary map lists may carry the descriptors and .frb files of their entries
+    std::unique_ptr<BinaryMapList::Reader> binaryList;
+    if (fileInfo.suffix() == BinaryMapList::SUFFIX) {
+        binaryList = std::make_unique<BinaryMapList::Reader>(fileName);
+    }
+    // download the boards and their music first, then unzip and parse them in parallel since that is i/o and zip
+    // bound; the parallel stage neither touches the network nor the files in tmpDir
+    QVector<MapDescriptor> imported(configFile.entries.size());
+    QVector<QVector<ImportExportUtils::StagedFile>> staged(configFile.entries.size());
+    QVector<QString> descPaths(configFile.entries.size());
+    QVector<QString> errors(configFile.entries.size());
     for(int i=0; i<configFile.entries.size(); ++i) {
+        Cancellation::checkpoint();
         auto &entry = configFile.entries[i];
-        descriptors[entry.mapId].mapSet = entry.mapSet;
-        descriptors[entry.mapId].zone = entry.mapZone;
-        descriptors[entry.mapId].order = entry.mapOrder;
-        descriptors[entry.mapId].isPracticeBoard = entry.practiceBoard;
+        auto &descriptor = imported[i];
+        descriptor = descriptors[entry.mapId];
+        descriptor.mapSet = entry.mapSet;
+        descriptor.zone = entry.mapZone;
+        descriptor.order = entry.mapOrder;
+        descriptor.isPracticeBoard = entry.practiceBoard;
         if(!entry.mapDescriptorRelativePath.isEmpty()) {
             auto descPath = dir.filePath(entry.mapDescriptorRelativePath);
+            if (binaryList) {
+                binaryList->extractEmbeddedFiles(i, dir);
+            }
             if (!entry.mapDescriptorUrls.empty()) {
                 qInfo() << "Downloading board:" << entry.name;
                 for (auto &url: entry.mapDescriptorUrls) {
@@ -399,14 +515,86 @@ void load(const QString &fileName, std::vector<MapDescriptor> &descriptors, cons
                     }
                 }
             }
-            ImportExportUtils::importYaml(descPath, descriptors[entry.mapId],
-                    tmpDir,
-                    [=](double progress) {
-                double taskProgress = (i + progress) / configFile.entries.size();
-                progressCallback(0.5 + taskProgress * 0.5);
-            }, dir.path());
+            try {
+                ImportExportUtils::downloadYamlDependencies(descPath);
+                descPaths[i] = descPath;
+            } catch (const ProgressCanceled &e) {
+                throw e;
+            } catch (const std::exception &e) {
+                errors[i] = e.what();
+            }
+        }
+    }
+
+    std::atomic<bool> canceled = false;
+    std::atomic<int> done = 0;
+    {
+        // the imports may need the GIL; it is released before the pool so that it is only taken back once the pool
+        // has waited for its tasks, also when the progress callback throws
+        std::unique_ptr<pybind11::gil_scoped_release> release;
+        if (Py_IsInitialized() && PyGILState_Check()) {
+            release = std::make_unique<pybind11::gil_scoped_release>();
+        }
+        QThreadPool pool;
+        pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+        auto token = Cancellation::current() ? *Cancellation::current() : Cancellation::Token();
+        for(int i=0; i<configFile.entries.size(); ++i) {
+            if (descPaths[i].isEmpty()) {
+                ++done;
+                continue;
+            }
+            pool.start([&, i, token]() {
+                Cancellation::Scope scope(token);
+                try {
+                    Cancellation::checkpoint();
+                    // only the asset store is written here; the files are placed into tmpDir in map list order below
+                    staged[i] = ImportExportUtils::stageYaml(descPaths[i], imported[i], tmpDir, [](double) {}, dir.path(), false);
+                } catch (const ProgressCanceled &) {
+                    canceled = true;
+                } catch (const std::exception &e) {
+                    errors[i] = e.what();
+                }
+                ++done;
+            });
         }
+        // report progress from this thread, the callback need not be thread safe
+        while (!pool.waitForDone(100)) {
+            progressCallback(0.5 + 0.5 * done / configFile.entries.size());
+        }
+    }
+    if (canceled) {
+        throw ProgressCanceled("Canceled");
+    }
+    // maps may share file names, e.g. a .brstm; placing them in map list order lets the later map win like it did
+    // when the maps were imported one after another
+    for(int i=0; i<configFile.entries.size(); ++i) {
+        if (descPaths[i].isEmpty() || !errors[i].isEmpty()) {
+            continue;
+        }
+        try {
+            ImportExportUtils::placeStagedFiles(tmpDir, staged[i]);
+        } catch (const std::exception &e) {
+            errors[i] = e.what();
+        }
+    }
+    QStringList errorMessages;
+    for(int i=0; i<configFile.entries.size(); ++i) {
+        if (!errors[i].isEmpty()) {
+            errorMessages.append(QString("%1: %2").arg(configFile.entries[i].name, errors[i]));
+        }
+    }
+    if (!errorMessages.isEmpty()) {
+        ImportExportUtils::autoClearCache();
+        throw std::runtime_error(QString("Could not import %1 of %2 maps:\n%3")
+                                 .arg(errorMessages.size()).arg(configFile.entries.size()).arg(errorMessages.join('\n')).toStdString());
+    }
+    // apply in map list order so that entries sharing a map id resolve like they did sequentially
+    for(int i=0; i<configFile.entries.size(); ++i) {
+        descriptors[configFile.entries[i].mapId] = imported[i];
     }
+    // files of a previous load which were replaced now only take up space in the asset store
+    ImportExportUtils::collectAssetGarbage(tmpDir);
+    progressCallback(1);
 }
 
 QString status(const QString &fileName)
@@ -29,10 +29,18 @@ struct ConfigFile {
     int maxZone(int mapSet);
     int maxOrder(int mapSet, int zone);
     QString toCsv();
-    QString toYaml();
+    /**
+     * @param backgroundsFile the file the backgrounds key points to, if any
+     */
+    QString toYaml(const QString &backgroundsFile = "");
 };
 
 void save(const QString &fileName, const std::vector<MapDescriptor> &descriptors);
+/**
+ * @brief convert Converts a map list between the csv, yaml and binary (*.csml) formats.
+ * @param embedFiles whether a binary map list should embed the map descriptors and .frb files it refers to
+ */
+void convert(const QString &fromFileName, const QString &toFileName, bool embedFiles = false);
 void import(const QString &fileName,
             const std::optional<QFileInfo> &mapDescriptorFile,
             const std::optional<int> &mapId,
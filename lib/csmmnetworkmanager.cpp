@@ -7,36 +7,48 @@
 #include <QNetworkReply>
 #include "lib/asyncfuture/asyncfuture.h"
 #include "lib/await.h"
+#include "lib/cancellation.h"
 #include "lib/progresscanceled.h"
+#include "lib/tracing.h"
 #include <QtConcurrent>
 #include <QSettings>
+#include <QThread>
+#include <memory>
 
 namespace CSMMNetworkManager {
 
+static QNetworkAccessManager *createInstance(QObject *parent) {
+    auto theInstance = new QNetworkAccessManager(parent);
+    QObject::connect(theInstance, &QNetworkAccessManager::sslErrors, [=](QNetworkReply *reply, const QList<QSslError> &errors) {
+        for (const QSslError &error : errors) {
+            qWarning() << "SSL error:" << error.errorString();
+        }
+    });
+    return theInstance;
+}
+
 QNetworkAccessManager *instance() {
-    static QNetworkAccessManager *theInstance = nullptr;
-    static QNetworkDiskCache *theCache = nullptr;
-    auto enable_cache = shouldEnableNetworkCache();
-    if (!theInstance) {
-        theInstance = new QNetworkAccessManager(QApplication::instance());
-        if(enable_cache){
-            theCache = createNetworkCache(theInstance);
-            theInstance->setCache(theCache);
+    // a QNetworkAccessManager can only be used from the thread it lives in, so worker threads get their own
+    static QNetworkAccessManager *mainInstance = nullptr;
+    thread_local std::unique_ptr<QNetworkAccessManager> workerInstance;
+    QNetworkAccessManager *theInstance;
+    if (QThread::currentThread() == QCoreApplication::instance()->thread()) {
+        if (!mainInstance) {
+            mainInstance = createInstance(QApplication::instance());
         }
-        QObject::connect(theInstance, &QNetworkAccessManager::sslErrors, [=](QNetworkReply *reply, const QList<QSslError> &errors) {
-            for (const QSslError &error : errors) {
-                qWarning() << "SSL error:" << error.errorString();
-            }
-        });
+        theInstance = mainInstance;
     } else {
-        if(enable_cache && theCache == nullptr){
-            theCache = createNetworkCache(theInstance);
-            theInstance->setCache(theCache);
-        }
-        if(!enable_cache && theCache != nullptr){
-            theCache = nullptr;
-            theInstance->setCache(theCache);
+        if (!workerInstance) {
+            workerInstance.reset(createInstance(nullptr));
         }
+        theInstance = workerInstance.get();
+    }
+    auto enable_cache = shouldEnableNetworkCache();
+    if (enable_cache && theInstance->cache() == nullptr) {
+        theInstance->setCache(createNetworkCache(theInstance));
+    }
+    if (!enable_cache && theInstance->cache() != nullptr) {
+        theInstance->setCache(nullptr);
     }
     return theInstance;
 }
@@ -96,11 +108,15 @@ void clearNetworkCache() {
 bool downloadFileIfUrl(const QUrl &toDownloadFrom, const QString &dest,
                                 const std::function<void(double)> &progressCallback) {
     if (!toDownloadFrom.isLocalFile()) {
+        Cancellation::checkpoint();
         auto file = QSharedPointer<QSaveFile>::create(dest);
         if (file->open(QFile::WriteOnly)) {
             QNetworkRequest request(toDownloadFrom);
             request.setRawHeader("User-Agent", "CSMM (github.com/FortuneStreetModding/csmm-qt)");
+            Tracing::Span span("download", toDownloadFrom.fileName());
+            span.arg("url", toDownloadFrom.toString());
             auto reply = instance()->get(request);
+            Cancellation::watch(reply, [reply]() { reply->abort(); });
             QObject::connect(reply, &QNetworkReply::readyRead, instance(), [=]() {
                 file->write(reply->readAll());
             });
@@ -112,6 +128,7 @@ bool downloadFileIfUrl(const QUrl &toDownloadFrom, const QString &dest,
                 }
             });
             await(AsyncFuture::observe(reply, &QNetworkReply::finished).future());
+            span.arg("bytesWritten", file->size());
             if (reply->error() != QNetworkReply::NoError) {
                 auto errStr = reply->errorString();
                 if (reply->error() == QNetworkReply::OperationCanceledError) {
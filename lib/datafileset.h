@@ -4,6 +4,10 @@
 #include "fslocale.h"
 
 static const QString CSMM_VERSION_FILE = "files/csmm_version.txt";
+// records the disc image a partially extracted game directory was extracted from
+static const QString SOURCE_IMAGE_FILE = "csmm_source_image.txt";
+// records the map files CopyMapFiles placed in a game directory
+static const QString MAP_FILES_MANIFEST = "csmm_map_files.bin";
 static const QString MAIN_DOL = "sys/main.dol";
 static const QString MAIN_DOL_TEMP_BACKUP = "sys/main.dol.temp.bak";
 static const QString MAIN_DOL_VANILLA_BACKUP = "sys/main.dol.orig.bak";
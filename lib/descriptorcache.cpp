@@ -0,0 +1,239 @@
+#include "descriptorcache.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include "lib/tracing.h"
+
+namespace DescriptorCache {
+
+static constexpr quint32 CACHE_MAGIC = 0x43534443; // "CSDC"
+// bump whenever MapDescriptor::fromYaml or the fields it sets change
+static constexpr quint32 CACHE_VERSION = 2;
+
+/**
+ * fromYaml keeps some fields as they are if the document does not set them, so their values before parsing are
+ * part of the key.
+ */
+static QString cacheKey(const QByteArray &yaml, const MapDescriptor &descriptor) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(CACHE_VERSION) + "|" + QCoreApplication::applicationVersion().toUtf8() + "\n");
+    hash.addData(QString("%1|%2|%3|%4|%5\n").arg(descriptor.loopingModeRadius).arg(descriptor.loopingModeHorizontalPadding)
+                 .arg(descriptor.loopingModeVerticalSquareCount).arg(descriptor.mapIcon).arg((quint32)descriptor.bgmId).toUtf8());
+    hash.addData(yaml);
+    return hash.result().toHex();
+}
+
+static QString cachePath(const QString &key) {
+    QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    cacheDir.mkpath("descriptors");
+    return cacheDir.filePath("descriptors/" + key);
+}
+
+// a locale table is written as the number of locales it has, followed by the index and value of each
+template<class T>
+static void writeLocales(QDataStream &stream, const LocaleTable<T> &table) {
+    stream << (quint32)table.size();
+    for (auto it = table.begin(); it != table.end(); ++it) {
+        stream << (quint8)it.locale();
+        if constexpr (std::is_same_v<T, QString>) {
+            stream << it->second;
+        } else {
+            stream << QVector<QString>(it->second.begin(), it->second.end());
+        }
+    }
+}
+
+template<class T>
+static void readLocales(QDataStream &stream, LocaleTable<T> &table) {
+    quint32 count;
+    stream >> count;
+    table.clear();
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        quint8 locale;
+        stream >> locale;
+        if (locale >= FS_LOCALE_COUNT) {
+            stream.setStatus(QDataStream::ReadCorruptData);
+            return;
+        }
+        if constexpr (std::is_same_v<T, QString>) {
+            stream >> table[FsLocale(locale)];
+        } else {
+            QVector<QString> values;
+            stream >> values;
+            table[FsLocale(locale)].assign(values.begin(), values.end());
+        }
+    }
+}
+
+// writes the fields MapDescriptor::fromYaml sets
+static void writeFields(QDataStream &stream, const MapDescriptor &descriptor) {
+    writeLocales(stream, descriptor.names);
+    writeLocales(stream, descriptor.descs);
+    stream << (quint32)descriptor.ruleSet << (quint32)descriptor.theme
+           << descriptor.initialCash << descriptor.tourInitialCash << descriptor.targetAmount
+           << descriptor.baseSalary << descriptor.salaryIncrement << descriptor.maxDiceRoll
+           << QVector<QString>(descriptor.frbFiles.begin(), descriptor.frbFiles.end());
+    stream << (quint32)descriptor.switchRotationOrigins.size();
+    for (auto &origin: descriptor.switchRotationOrigins) {
+        stream << origin.x << origin.y;
+    }
+    stream << (quint32)descriptor.loopingMode << descriptor.loopingModeRadius
+           << descriptor.loopingModeHorizontalPadding << descriptor.loopingModeVerticalSquareCount
+           << descriptor.tourBankruptcyLimit << descriptor.tourClearRank;
+    for (auto character: descriptor.tourCharacters) {
+        stream << (quint32)character;
+    }
+    stream << descriptor.background << descriptor.mapIcon << (quint32)descriptor.bgmId;
+    stream << (quint32)descriptor.music.size();
+    for (auto &musicEnt: descriptor.music) {
+        stream << (quint32)musicEnt.first << (quint32)musicEnt.second.size();
+        for (auto &entry: musicEnt.second) {
+            stream << entry.brstmBaseFilename << entry.volume << entry.brsarIndex << entry.brstmFileSize;
+        }
+    }
+    stream << (quint32)descriptor.mutators.size();
+    for (auto &mutator: descriptor.mutators) {
+        QByteArray bytes;
+        if (mutator.second) {
+            QDataStream mutatorStream(&bytes, QIODevice::WriteOnly);
+            mutator.second->toBytes(mutatorStream);
+        }
+        stream << mutator.first << bytes;
+    }
+    for (bool ventureCard: descriptor.ventureCards) {
+        stream << ventureCard;
+    }
+    writeLocales(stream, descriptor.districtNames);
+    stream << QVector<QString>(descriptor.authors.begin(), descriptor.authors.end());
+    writeLocales(stream, descriptor.shopNames);
+}
+
+static void readFields(QDataStream &stream, MapDescriptor &descriptor) {
+    quint32 ruleSet, theme, loopingMode, bgmId, count;
+    QVector<QString> frbFiles, authors;
+    readLocales(stream, descriptor.names);
+    readLocales(stream, descriptor.descs);
+    stream >> ruleSet >> theme
+           >> descriptor.initialCash >> descriptor.tourInitialCash >> descriptor.targetAmount
+           >> descriptor.baseSalary >> descriptor.salaryIncrement >> descriptor.maxDiceRoll
+           >> frbFiles;
+    descriptor.ruleSet = (RuleSet)ruleSet;
+    descriptor.theme = (BoardTheme)theme;
+    descriptor.frbFiles.assign(frbFiles.begin(), frbFiles.end());
+    stream >> count;
+    descriptor.switchRotationOrigins.clear();
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        OriginPoint origin;
+        stream >> origin.x >> origin.y;
+        descriptor.switchRotationOrigins.push_back(origin);
+    }
+    stream >> loopingMode >> descriptor.loopingModeRadius
+           >> descriptor.loopingModeHorizontalPadding >> descriptor.loopingModeVerticalSquareCount
+           >> descriptor.tourBankruptcyLimit >> descriptor.tourClearRank;
+    descriptor.loopingMode = (LoopingMode)loopingMode;
+    for (auto &character: descriptor.tourCharacters) {
+        quint32 value;
+        stream >> value;
+        character = (Character)value;
+    }
+    stream >> descriptor.background >> descriptor.mapIcon >> bgmId >> count;
+    descriptor.bgmId = (BgmId)bgmId;
+    descriptor.music.clear();
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        quint32 musicType, entryCount;
+        stream >> musicType >> entryCount;
+        auto &entries = descriptor.music[(MusicType)musicType];
+        for (quint32 j = 0; j < entryCount && stream.status() == QDataStream::Ok; ++j) {
+            MusicEntry entry;
+            stream >> entry.brstmBaseFilename >> entry.volume >> entry.brsarIndex >> entry.brstmFileSize;
+            entries.push_back(entry);
+        }
+    }
+    stream >> count;
+    descriptor.mutators.clear();
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString mutatorStr;
+        QByteArray bytes;
+        stream >> mutatorStr >> bytes;
+        QSharedPointer<Mutator> mutator;
+        if (!bytes.isEmpty()) {
+            QDataStream mutatorStream(bytes);
+            // Mutator::toBytes writes single precision floats
+            mutatorStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+            mutator = Mutator::fromBytes(mutatorStream);
+        }
+        descriptor.mutators.emplace(mutatorStr, mutator);
+    }
+    for (auto &ventureCard: descriptor.ventureCards) {
+        stream >> ventureCard;
+    }
+    readLocales(stream, descriptor.districtNames);
+    stream >> authors;
+    descriptor.authors.assign(authors.begin(), authors.end());
+    readLocales(stream, descriptor.shopNames);
+}
+
+static bool read(const QString &path, MapDescriptor &descriptor) {
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    quint32 magic, version;
+    QByteArray checksum, fields;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        return false;
+    }
+    stream >> checksum >> fields;
+    // the fields are read straight into the descriptor (copying it would need the GIL), so they must be intact
+    if (stream.status() != QDataStream::Ok || checksum != QCryptographicHash::hash(fields, QCryptographicHash::Sha1)) {
+        qDebug() << "the cached descriptor" << path << "is corrupt";
+        return false;
+    }
+    QDataStream fieldStream(fields);
+    readFields(fieldStream, descriptor);
+    return fieldStream.status() == QDataStream::Ok;
+}
+
+static void write(const QString &path, const MapDescriptor &descriptor) {
+    QByteArray fields;
+    {
+        QDataStream fieldStream(&fields, QIODevice::WriteOnly);
+        writeFields(fieldStream, descriptor);
+    }
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream << CACHE_MAGIC << CACHE_VERSION << QCryptographicHash::hash(fields, QCryptographicHash::Sha1) << fields;
+    if (!file.commit()) {
+        qDebug() << "could not write the cached descriptor" << path;
+    }
+}
+
+bool fromYaml(const QByteArray &yaml, MapDescriptor &descriptor) {
+    Tracing::Span span("parse", "descriptor");
+    auto path = cachePath(cacheKey(yaml, descriptor));
+    if (read(path, descriptor)) {
+        span.arg("cached", true);
+        return true;
+    }
+    auto node = YAML::Load(yaml.toStdString());
+    if (!descriptor.fromYaml(node)) {
+        return false;
+    }
+    // extraData holds Python objects, such descriptors are always parsed
+    if (!node["extraData"]) {
+        write(path, descriptor);
+    }
+    return true;
+}
+
+}
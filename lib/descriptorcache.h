@@ -0,0 +1,22 @@
+#ifndef DESCRIPTORCACHE_H
+#define DESCRIPTORCACHE_H
+
+#include <QByteArray>
+#include "lib/mapdescriptor.h"
+
+/**
+ * Caches the result of parsing map descriptor files, keyed by the hash of their contents, so that loading a map
+ * list again does not need to parse and validate unchanged map descriptors with yaml-cpp.
+ */
+namespace DescriptorCache {
+
+/**
+ * @brief fromYaml Equivalent to descriptor.fromYaml(YAML::Load(yaml)), but reads the fields from the cache if the
+ * same document has been parsed before.
+ * @return whether the document is a valid map descriptor
+ */
+bool fromYaml(const QByteArray &yaml, MapDescriptor &descriptor);
+
+}
+
+#endif // DESCRIPTORCACHE_H
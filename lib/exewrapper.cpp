@@ -1,36 +1,47 @@
 #include "exewrapper.h"
 
 #include "lib/asyncfuture/asyncfuture.h"
+#include "lib/cancellation.h"
+#include "lib/datafileset.h"
+#include "lib/filecopy.h"
+#include "lib/progresscanceled.h"
+#include "lib/textureencoder.h"
+#include "lib/tracing.h"
 #include "qdir.h"
 #include <QApplication>
 #include <QDataStream>
+#include <QDebug>
+#include <QDirIterator>
+#include <QFileInfo>
 #include <QProcess>
+#include <QRegularExpression>
 #include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtConcurrent>
+#include <QTimer>
 
 namespace ExeWrapper {
 
-static const QString &getWitPath() {
-    static QString witPath;
-    if (witPath.isEmpty()) {
-        witPath = QDir(QApplication::applicationDirPath()).filePath("wit/bin/wit");
-    }
-    return witPath;
+static QString toolsDirectory;
+
+void setToolsDirectory(const QString &dir) {
+    toolsDirectory = dir;
 }
 
-static const QString &getWszstPath() {
-    static QString wszstPath;
-    if (wszstPath.isEmpty()) {
-        wszstPath = QDir(QApplication::applicationDirPath()).filePath("szs/bin/wszst");
-    }
-    return wszstPath;
+static QString getToolPath(const QString &relativePath) {
+    return QDir(toolsDirectory.isEmpty() ? QApplication::applicationDirPath() : toolsDirectory).filePath(relativePath);
 }
 
-static const QString &getWimgtPath() {
-    static QString wimgtPath;
-    if (wimgtPath.isEmpty()) {
-        wimgtPath = QDir(QApplication::applicationDirPath()).filePath("szs/bin/wimgt");
-    }
-    return wimgtPath;
+static QString getWitPath() {
+    return getToolPath("wit/bin/wit");
+}
+
+static QString getWszstPath() {
+    return getToolPath("szs/bin/wszst");
+}
+
+static QString getWimgtPath() {
+    return getToolPath("szs/bin/wimgt");
 }
 
 static const QStringList &getWiimmsEnv() {
@@ -45,32 +56,141 @@ static const QStringList &getWiimmsEnv() {
     return witEnv;
 }
 
-static QFuture<QString> observeProcess(QProcess *proc) {
-    auto program = proc->program();
-    if (proc->error() == QProcess::FailedToStart) {
-        throw Exception(QString("Process '%1' failed to start").arg(program));
+/**
+ * @brief Parses a line of tool output to a progress in [0,1], or returns a negative number if the line is no progress line.
+ */
+typedef std::function<double(const QString &)> ProgressParser;
+
+static double parseWitProgress(const QString &line) {
+    // e.g. "  42% copied in   0:07 (  95.2 MiB/sec) -> ETA   0:10"
+    static const QRegularExpression re("^\\s*(\\d{1,3})%");
+    auto match = re.match(line);
+    return match.hasMatch() ? match.captured(1).toInt() / 100.0 : -1;
+}
+
+/**
+ * @brief Splits the bytes of buffer into lines and passes the complete lines to lineCallback.
+ * Lines may be terminated by \r as well since the Wiimms tools redraw their progress lines with it.
+ * @param flush whether to also pass the trailing incomplete line
+ */
+static void consumeLines(QByteArray &buffer, bool flush, const std::function<void(const QString &)> &lineCallback) {
+    qsizetype start = 0;
+    for (qsizetype i = 0; i < buffer.size(); ++i) {
+        if (buffer[i] == '\n' || buffer[i] == '\r') {
+            if (i > start) {
+                lineCallback(QString::fromUtf8(buffer.constData() + start, i - start));
+            }
+            start = i + 1;
+        }
+    }
+    if (flush && start < buffer.size()) {
+        lineCallback(QString::fromUtf8(buffer.constData() + start, buffer.size() - start));
+        start = buffer.size();
     }
+    buffer.remove(0, start);
+}
+
+/**
+ * @brief The exit code of a finished process and its output without the progress lines.
+ */
+struct ProcessResult {
+    int exitCode;
+    QString output;
+};
+
+/**
+ * @brief Starts proc and observes it like observeProcess, but leaves the exit code to the caller, for tools which
+ * report a result by their exit code. Still throws if the process crashes or is canceled.
+ */
+static QFuture<ProcessResult> observeProcessResult(QProcess *proc, const std::function<void(double)> &progressCallback = [](double) {},
+                                                   const ProgressParser &progressParser = {}) {
+    auto program = proc->program();
 
-    QObject::connect(proc, &QProcess::readyReadStandardError, [proc]() {
-        qWarning() << proc->readAllStandardError();
+    // output is handled line by line as it arrives; progress lines are not kept
+    auto output = QSharedPointer<QString>::create();
+    auto stdoutBuffer = QSharedPointer<QByteArray>::create();
+    auto stderrBuffer = QSharedPointer<QByteArray>::create();
+    auto canceled = QSharedPointer<bool>::create(false);
+    auto cancel = [=]() {
+        if (*canceled) return;
+        *canceled = true;
+        proc->terminate();
+        // the Wiimms tools do not handle WM_CLOSE on Windows, so make sure they go away
+        QTimer::singleShot(3000, proc, [proc]() { proc->kill(); });
+    };
+
+    auto handleLine = [=](const QString &line) {
+        if (progressParser) {
+            double progress = progressParser(line);
+            if (progress >= 0) {
+                if (!*canceled) {
+                    try {
+                        progressCallback(progress);
+                    } catch (const ProgressCanceled &) {
+                        cancel();
+                    }
+                }
+                return;
+            }
+        }
+        output->append(line);
+        output->append('\n');
+    };
+    auto warnLine = [program](const QString &line) {
+        qWarning().noquote() << QFileInfo(program).fileName() + ":" << line;
+    };
+
+    QObject::connect(proc, &QProcess::readyReadStandardOutput, proc, [=]() {
+        stdoutBuffer->append(proc->readAllStandardOutput());
+        consumeLines(*stdoutBuffer, false, handleLine);
+    });
+    QObject::connect(proc, &QProcess::readyReadStandardError, proc, [=]() {
+        stderrBuffer->append(proc->readAllStandardError());
+        consumeLines(*stderrBuffer, false, warnLine);
     });
 
     using Args = std::tuple<int, QProcess::ExitStatus>;
     QFuture<Args> future = QtFuture::connect(proc, &QProcess::finished);
 
+    auto span = QSharedPointer<Tracing::Span>::create("process", QFileInfo(program).fileName() + " " + proc->arguments().value(0));
+    span->arg("arguments", proc->arguments().join(' '));
     proc->start();
+    // a process which fails to start never finishes
+    if (!proc->waitForStarted()) {
+        delete proc;
+        throw Exception(QString("Process '%1' failed to start").arg(program));
+    }
+    Cancellation::watch(proc, cancel);
 
     return AsyncFuture::observe(future)
         .subscribe([=](Args args) {
             const auto code = std::get<0>(args);
-            const auto status = std::get<1>(args);
-            if (code != 0) {
-                throw Exception(QString("Process '%1' returned nonzero exit code %2").arg(program).arg(code));
-            }
-            QTextStream stream(proc);
-            QString line = stream.readAll();
+            span->arg("exitCode", code);
+            span->end();
+            stdoutBuffer->append(proc->readAllStandardOutput());
+            consumeLines(*stdoutBuffer, true, handleLine);
+            stderrBuffer->append(proc->readAllStandardError());
+            consumeLines(*stderrBuffer, true, warnLine);
             proc->deleteLater();
-            return line.trimmed();
+            if (*canceled) {
+                throw ProgressCanceled("Canceled");
+            }
+            if (std::get<1>(args) != QProcess::NormalExit) {
+                throw Exception(QString("Process '%1' crashed").arg(program));
+            }
+            return ProcessResult{code, output->trimmed()};
+        }).future();
+}
+
+static QFuture<QString> observeProcess(QProcess *proc, const std::function<void(double)> &progressCallback = [](double) {},
+                                       const ProgressParser &progressParser = {}) {
+    auto program = proc->program();
+    return AsyncFuture::observe(observeProcessResult(proc, progressCallback, progressParser))
+        .subscribe([=](ProcessResult result) {
+            if (result.exitCode != 0) {
+                throw Exception(QString("Process '%1' returned nonzero exit code %2").arg(program).arg(result.exitCode));
+            }
+            return result.output;
         }).future();
 }
 
@@ -137,7 +257,7 @@ QFuture<QString> packTurnlotFolderToArc(const QString &dFolder, const QString &a
     QProcess *proc = new QProcess();
     proc->setEnvironment(getWiimmsEnv());
     proc->setProgram(getWszstPath());
-    proc->setArguments({"CREATE", "--overwrite", "--u8", "--no-compress", "--pt-dir=REMOVE", "--transform", "TPL.CMPR", "--n-mipmaps", "0", dFolder, "--dest", arcFile});
+    proc->setArguments(QStringList{"CREATE", "--overwrite"} + TURNLOT_ARC_OPTIONS + QStringList{dFolder, "--dest", arcFile});
     return observeProcess(proc);
 }
 QFuture<QString> extractBrresFile(const QString &brresFile, const QString &dFolder) {
@@ -154,35 +274,186 @@ QFuture<QString> packDfolderToBrres(const QString &dFolder, const QString &brres
     proc->setArguments({"CREATE", "--overwrite", dFolder, "--dest", brresFile});
     return observeProcess(proc);
 }
-QFuture<QString> convertPngToTpl(const QString &pngFile, const QString &tplFile, const QString &tplFormat) {
+static QFuture<QString> encodeWithWimgt(const QString &pngFile, const QString &destFile, const QString &format) {
     QProcess *proc = new QProcess();
     proc->setEnvironment(getWiimmsEnv());
     proc->setProgram(getWimgtPath());
-    proc->setArguments({"ENCODE", "--overwrite", pngFile, "--dest", tplFile, "--transform", tplFormat});
+    // wimgt overwrites in place; removing the old file first keeps other hard links to it intact
+    QFile::remove(destFile);
+    QStringList args{"ENCODE", "--overwrite", pngFile, "--dest", destFile};
+    if (!format.isEmpty()) {
+        args << "--transform" << format;
+    }
+    proc->setArguments(args);
     return observeProcess(proc);
 }
-QFuture<QString> convertPngToTex(const QString &pngFile, const QString &texFile) {
+QFuture<QString> convertPngToTpl(const QString &pngFile, const QString &tplFile, const QString &tplFormat,
+                                 TextureEncoder::Quality quality) {
+    // an empty format is picked by the encoder
+    auto format = TextureEncoder::findFormat(tplFormat);
+    if (!format && !tplFormat.isEmpty()) {
+        return encodeWithWimgt(pngFile, tplFile, tplFormat);
+    }
+    // the pool thread runs without a token of its own
+    auto token = Cancellation::current() ? *Cancellation::current() : Cancellation::Token();
+    return QtConcurrent::run([=]() {
+        Cancellation::Scope scope(token);
+        Cancellation::checkpoint();
+        TextureEncoder::encodeTplFile(pngFile, tplFile, format, quality);
+        return QString();
+    });
+}
+QFuture<QString> convertPngToTex(const QString &pngFile, const QString &texFile, const QString &texFormat,
+                                 TextureEncoder::Quality quality) {
+    auto format = TextureEncoder::findFormat(texFormat);
+    if (!format && !texFormat.isEmpty()) {
+        return encodeWithWimgt(pngFile, texFile, texFormat);
+    }
+    auto token = Cancellation::current() ? *Cancellation::current() : Cancellation::Token();
+    return QtConcurrent::run([=]() {
+        Cancellation::Scope scope(token);
+        Cancellation::checkpoint();
+        TextureEncoder::encodeTex0File(pngFile, texFile, format, quality);
+        return QString();
+    });
+}
+static bool isWholeGame(const QSet<QString> &workingSet) {
+    return workingSet.isEmpty() || workingSet.contains("*");
+}
+static QStringList fileFilterArgs(const QSet<QString> &workingSet) {
+    // only allow rules -> files which match none of them are excluded
+    // the system files are small and needed for the directory to be recognized as a game
+    QStringList result{"--files", "+/sys/*", "--files", "+/disc/*"};
+    for (auto &path: workingSet) {
+        result << "--files" << "+/" + path;
+    }
+    return result;
+}
+static constexpr int MAX_PRESENT_FILE_RULES = 400;
+/**
+ * @return deny rules for the files already present in the game directory, so that only the missing files are
+ * extracted, or no rules if there are too many of them for a command line
+ */
+static QStringList presentFileFilterArgs(const QString &extractDir) {
+    QDir dir(extractDir);
+    QStringList result;
+    for (auto topLevel: {"sys", "files", "disc"}) {
+        QDirIterator it(dir.filePath(topLevel), QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            result << "--files" << "-/" + dir.relativeFilePath(it.next());
+            if (result.size() > 2 * MAX_PRESENT_FILE_RULES) {
+                return {};
+            }
+        }
+    }
+    return result;
+}
+QFuture<QString> extractWbfsIso(const QString &wbfsFile, const QString &extractDir, const QSet<QString> &workingSet,
+                                const std::function<void(double)> &progressCallback) {
     QProcess *proc = new QProcess();
     proc->setEnvironment(getWiimmsEnv());
-    proc->setProgram(getWimgtPath());
-    proc->setArguments({"ENCODE", "--overwrite", pngFile, "--dest", texFile});
-    return observeProcess(proc);
+    proc->setProgram(getWitPath());
+    if (isWholeGame(workingSet)) {
+        proc->setArguments({"COPY", "--psel", "data", "--preserve", "--overwrite", "--progress", "--fst", wbfsFile, extractDir});
+        return observeProcess(proc, progressCallback, parseWitProgress);
+    }
+    proc->setArguments(QStringList{"COPY", "--psel", "data", "--preserve", "--overwrite", "--progress", "--fst"}
+                       + fileFilterArgs(workingSet) + QStringList{wbfsFile, extractDir});
+    auto sourceImage = QFileInfo(wbfsFile).absoluteFilePath();
+    return AsyncFuture::observe(observeProcess(proc, progressCallback, parseWitProgress))
+        .subscribe([=](QString output) {
+            QFile sourceImageFile(QDir(extractDir).filePath(SOURCE_IMAGE_FILE));
+            if (!sourceImageFile.open(QFile::WriteOnly)) {
+                throw Exception(QString("Could not record the source image in %1").arg(extractDir));
+            }
+            sourceImageFile.write(sourceImage.toUtf8());
+            return output;
+        }).future();
 }
-QFuture<QString> extractWbfsIso(const QString &wbfsFile, const QString &extractDir) {
+QFuture<QString> extractMissingFiles(const QString &extractDir, const QSet<QString> &workingSet,
+                                     const std::function<void(double)> &progressCallback) {
+    QFile sourceImageFile(QDir(extractDir).filePath(SOURCE_IMAGE_FILE));
+    if (!sourceImageFile.open(QFile::ReadOnly)) {
+        return QtFuture::makeReadyFuture(QString());
+    }
+    auto sourceImage = QString::fromUtf8(sourceImageFile.readAll()).trimmed();
+    sourceImageFile.close();
+    if (!QFileInfo::exists(sourceImage)) {
+        throw Exception(QString("The disc image %1 that %2 was extracted from no longer exists").arg(sourceImage, extractDir));
+    }
+
+    // wit cannot add single files to an existing directory, so the files are extracted next to the game
+    // directory and only the missing ones are moved over, keeping the files which were modified since.
+    // The deny rules for the present files come first, as wit applies the first rule a file matches.
+    auto extractTmp = QSharedPointer<QTemporaryDir>::create(QDir(extractDir).filePath("csmm_extract_XXXXXX"));
+    if (!extractTmp->isValid()) {
+        throw Exception(QString("Could not create a temporary directory in %1").arg(extractDir));
+    }
+    auto tmpGameDir = QDir(extractTmp->path()).filePath("game");
     QProcess *proc = new QProcess();
     proc->setEnvironment(getWiimmsEnv());
     proc->setProgram(getWitPath());
-    proc->setArguments({"COPY", "--psel", "data", "--preserve", "--overwrite", "--fst", wbfsFile, extractDir});
-    return observeProcess(proc);
+    QStringList args{"COPY", "--psel", "data", "--preserve", "--progress", "--fst"};
+    bool complete = isWholeGame(workingSet);
+    args << presentFileFilterArgs(extractDir);
+    if (!complete) {
+        args << fileFilterArgs(workingSet);
+    }
+    args << sourceImage << tmpGameDir;
+    proc->setArguments(args);
+    auto sourceImageFilePath = sourceImageFile.fileName();
+    return AsyncFuture::observe(observeProcess(proc, progressCallback, parseWitProgress))
+        .subscribe([=](QString output) {
+            auto moved = FileCopy::moveMissingFiles(tmpGameDir, extractDir);
+            qDebug() << "extracted" << moved.size() << "missing files from" << sourceImage << "to" << extractDir;
+            extractTmp->remove();
+            if (complete) {
+                QFile::remove(sourceImageFilePath);
+            }
+            return output;
+        }).future();
 }
-QFuture<QString> createWbfsIso(const QString &sourceDir, const QString &wbfsFile, const QString &markerCode, bool separateSaveGame) {
+static QFuture<QString> packGameDirectory(const QString &sourceDir, const QString &wbfsFile, const QString &markerCode, bool separateSaveGame, bool patchWiimmfi,
+                                         const std::function<void(double)> &progressCallback) {
     QProcess *proc = new QProcess();
     proc->setEnvironment(getWiimmsEnv());
     QString discId = separateSaveGame ? "K" : ".";
-    QStringList args{"COPY", "--id", QString("%1...%2").arg(discId, markerCode), "--overwrite", sourceDir, wbfsFile};
+    QStringList args{"COPY", "--id", QString("%1...%2").arg(discId, markerCode), "--overwrite", "--progress"};
+    if (patchWiimmfi) {
+        args << "--wiimmfi";
+    }
+    args << sourceDir << wbfsFile;
     proc->setProgram(getWitPath());
     proc->setArguments(args);
-    return observeProcess(proc);
+    auto span = QSharedPointer<Tracing::Span>::create("disc", "pack " + QFileInfo(wbfsFile).fileName());
+    return AsyncFuture::observe(observeProcess(proc, progressCallback, parseWitProgress))
+        .subscribe([=](QString output) {
+            span->arg("bytesWritten", QFileInfo(wbfsFile).size());
+            span->end();
+            return output;
+        }).future();
+}
+QFuture<QString> createWbfsIso(const QString &sourceDir, const QString &wbfsFile, const QString &markerCode, bool separateSaveGame, bool patchWiimmfi,
+                               const std::function<void(double)> &progressCallback) {
+    if (!QFileInfo::exists(QDir(sourceDir).filePath(SOURCE_IMAGE_FILE))) {
+        return packGameDirectory(sourceDir, wbfsFile, markerCode, separateSaveGame, patchWiimmfi, progressCallback);
+    }
+    // wit only packs complete directories: the partially extracted directory is mirrored next to the image with
+    // hard links and completed there from the image it was extracted from, so sourceDir itself is left partial
+    auto stageTmp = QSharedPointer<QTemporaryDir>::create(QFileInfo(wbfsFile).absoluteDir().filePath("csmm_pack_XXXXXX"));
+    if (!stageTmp->isValid()) {
+        throw Exception(QString("Could not create a temporary directory next to %1").arg(wbfsFile));
+    }
+    auto stageDir = QDir(stageTmp->path()).filePath("game");
+    FileCopy::linkTree(sourceDir, stageDir);
+    return AsyncFuture::observe(extractMissingFiles(stageDir, {}, [=](double progress) { progressCallback(progress / 2); }))
+        .subscribe([=](QString) {
+            return packGameDirectory(stageDir, wbfsFile, markerCode, separateSaveGame, patchWiimmfi,
+                                     [=](double progress) { progressCallback(0.5 + progress / 2); });
+        }).subscribe([=](QString output) {
+            stageTmp->remove();
+            return output;
+        }).future();
 }
 QFuture<QString> patchWiimmfi(const QString &wbfsFile) {
     QProcess *proc = new QProcess();
@@ -192,6 +463,18 @@ QFuture<QString> patchWiimmfi(const QString &wbfsFile) {
     proc->setArguments(args);
     return observeProcess(proc);
 }
+QFuture<bool> compareWbfsIso(const QString &wbfsFile0, const QString &wbfsFile1) {
+    QProcess *proc = new QProcess();
+    proc->setEnvironment(getWiimmsEnv());
+    proc->setProgram(getWitPath());
+    proc->setArguments({"DIFF", "--quiet", wbfsFile0, wbfsFile1});
+
+    return AsyncFuture::observe(observeProcessResult(proc))
+        .subscribe([](ProcessResult result) {
+            // wit DIFF exits with a nonzero code when the images differ
+            return result.exitCode == 0;
+        }).future();
+}
 QFuture<QString> getId6(const QString &inputFile) {
     QProcess *proc = new QProcess();
     proc->setEnvironment(getWiimmsEnv());
@@ -200,4 +483,107 @@ QFuture<QString> getId6(const QString &inputFile) {
     return observeProcess(proc);
 }
 
+// keeps the command lines well below the Windows limit of 32767 characters
+static constexpr int MAX_FILES_PER_INVOCATION = 64;
+
+/**
+ * @return a wszst destination which maps a source path relative to the working directory to the same path below destRoot
+ */
+static QString mirroredDestination(const QString &destRoot, const QString &destSuffix = "") {
+    return QDir(destRoot).absolutePath() + "/%P/%F" + destSuffix;
+}
+
+QFuture<void> SzsBatch::extract(const QString &sourceRoot, const QString &path, const QString &destRoot) {
+    QDir(destRoot).mkpath(path);
+    return enqueue(sourceRoot, {"EXTRACT", "--overwrite", "--dest", mirroredDestination(destRoot)}, path);
+}
+QFuture<void> SzsBatch::pack(const QString &sourceRoot, const QString &path, const QString &destRoot,
+                             const QString &destSuffix, const QStringList &options) {
+    QFileInfo(QDir(destRoot).filePath(path)).dir().mkpath(".");
+    // wszst overwrites in place; removing the old file first keeps other hard links to it intact
+    QFile::remove(QDir(destRoot).filePath(path + destSuffix));
+    return enqueue(sourceRoot, QStringList{"CREATE", "--overwrite"} + options
+                   + QStringList{"--dest", mirroredDestination(destRoot, destSuffix)}, path);
+}
+QFuture<void> SzsBatch::enqueue(const QString &workingDirectory, const QStringList &arguments, const QString &path) {
+    auto &invocation = invocations[QStringList{workingDirectory} + arguments];
+    invocation.workingDirectory = workingDirectory;
+    invocation.arguments = arguments;
+    auto promise = QSharedPointer<QPromise<void>>::create();
+    promise->start();
+    invocation.jobs.append({path, promise});
+    return promise->future();
+}
+void SzsBatch::run() {
+    for (auto &invocation: invocations) {
+        for (int first = 0; first < invocation.jobs.size(); first += MAX_FILES_PER_INVOCATION) {
+            start(invocation.workingDirectory, invocation.arguments, invocation.jobs.mid(first, MAX_FILES_PER_INVOCATION));
+        }
+    }
+    invocations.clear();
+}
+void SzsBatch::start(const QString &workingDirectory, const QStringList &arguments, const QVector<Job> &jobs) {
+    auto failJobs = [jobs](std::exception_ptr exception) {
+        for (auto &job: jobs) {
+            job.promise->setException(exception);
+            job.promise->finish();
+        }
+    };
+    if (Cancellation::isCanceled()) {
+        // fail the remaining jobs without starting wszst
+        try {
+            Cancellation::checkpoint();
+        } catch (...) {
+            failJobs(std::current_exception());
+        }
+        return;
+    }
+    auto onFailed = [=]() {
+        auto exception = std::current_exception();
+        try {
+            std::rethrow_exception(exception);
+        } catch (const ProgressCanceled &) {
+            failJobs(exception);
+        } catch (const std::exception &e) {
+            if (jobs.size() > 1) {
+                // one bad file fails the whole invocation; retry the files one by one so that only the bad ones fail
+                for (auto &job: jobs) {
+                    start(workingDirectory, arguments, {job});
+                }
+            } else {
+                failJobs(std::make_exception_ptr(Exception(QString("Could not process %1: %2")
+                                                           .arg(QDir(workingDirectory).filePath(jobs[0].path), e.what()))));
+            }
+        }
+    };
+
+    QProcess *proc = new QProcess();
+    proc->setEnvironment(getWiimmsEnv());
+    proc->setProgram(getWszstPath());
+    proc->setWorkingDirectory(workingDirectory);
+    auto processArguments = arguments;
+    for (auto &job: jobs) {
+        processArguments << job.path;
+    }
+    proc->setArguments(processArguments);
+
+    QFuture<QString> future;
+    try {
+        future = observeProcess(proc);
+    } catch (...) {
+        onFailed();
+        return;
+    }
+    future.then([jobs](const QString &) {
+        for (auto &job: jobs) {
+            job.promise->finish();
+        }
+    }).onFailed(onFailed).onCanceled([jobs]() {
+        for (auto &job: jobs) {
+            job.promise->future().cancel();
+            job.promise->finish();
+        }
+    });
+}
+
 }
@@ -2,7 +2,14 @@
 #define EXEWRAPPER_H
 
 #include <QFuture>
+#include <QMap>
+#include <QPromise>
+#include <QSet>
+#include <QSharedPointer>
+#include <QStringList>
+#include <functional>
 #include "addressmapping.h"
+#include "textureencoder.h"
 
 #ifdef Q_OS_WIN
 #define WIT_NAME "wit.exe"
@@ -15,19 +22,112 @@
 #endif
 
 namespace ExeWrapper {
+    /**
+     * @brief setToolsDirectory Runs the Wiimms tools from dir (as dir/wit/bin/wit, dir/szs/bin/wszst and
+     * dir/szs/bin/wimgt) instead of from next to the executable, e.g. for benchmarking with stand-in tools.
+     * Not thread safe; only call it while no tool is started.
+     * @param dir the tools directory, or an empty string for the directory of the executable
+     */
+    void setToolsDirectory(const QString &dir);
     QFuture<QVector<AddressSection>> readSections(const QString &inputFile);
     QFuture<QString> extractArcFile(const QString &arcFile, const QString &dFolder);
     QFuture<QString> packDfolderToArc(const QString &dFolder, const QString &arcFile);
+    /**
+     * @brief The wszst CREATE options for packing turnlot folders.
+     */
+    inline const QStringList TURNLOT_ARC_OPTIONS{"--u8", "--no-compress", "--pt-dir=REMOVE", "--transform", "TPL.CMPR", "--n-mipmaps", "0"};
     QFuture<QString> packTurnlotFolderToArc(const QString &dFolder, const QString &arcFile);
     QFuture<QString> extractBrresFile(const QString &brresFile, const QString &dFolder);
     QFuture<QString> packDfolderToBrres(const QString &dFolder, const QString &brresFile);
-    QFuture<QString> convertPngToTpl(const QString &pngFile, const QString &tplFile, const QString &tplFormat = "RGB5A3");
-    QFuture<QString> convertPngToTex(const QString &pngFile, const QString &texFile);
-    QFuture<QString> extractWbfsIso(const QString &wbfsFile, const QString &extractDir);
-    QFuture<QString> createWbfsIso(const QString &sourceDir, const QString &wbfsFile, const QString &markerCode, bool separateSaveGame);
+    /**
+     * @brief convertPngToTpl Encodes an image to a TPL file. RGB5A3, RGBA8 and CMPR are encoded in-process on the
+     * thread pool (see TextureEncoder), other wimgt formats by wimgt.
+     * @param tplFormat the wimgt format name; if empty, CMPR or RGB5A3 is picked like wimgt does (see TextureEncoder::autoFormat)
+     * @param quality the CMPR encoding quality; ignored by wimgt
+     */
+    QFuture<QString> convertPngToTpl(const QString &pngFile, const QString &tplFile, const QString &tplFormat = "RGB5A3",
+                                     TextureEncoder::Quality quality = TextureEncoder::Quality::Normal);
+    /**
+     * @brief convertPngToTex Encodes an image to a TEX0 file like convertPngToTpl.
+     * @param texFormat the wimgt format name; if empty, CMPR or RGB5A3 is picked like wimgt does
+     */
+    QFuture<QString> convertPngToTex(const QString &pngFile, const QString &texFile, const QString &texFormat = "",
+                                     TextureEncoder::Quality quality = TextureEncoder::Quality::Normal);
+    /**
+     * @brief extractWbfsIso Extracts the data partition of a disc image.
+     * @param workingSet if non-empty, only these files (relative to the game root, wildcards allowed) are extracted
+     * and the disc image is recorded in the extracted directory so that the remaining files can be extracted later
+     * @param progressCallback called with a number in [0,1] as wit reports progress; throw ProgressCanceled to abort
+     */
+    QFuture<QString> extractWbfsIso(const QString &wbfsFile, const QString &extractDir, const QSet<QString> &workingSet = {},
+                                    const std::function<void(double)> &progressCallback = [](double) {});
+    /**
+     * @brief extractMissingFiles Extracts files which are missing from a partially extracted game directory
+     * from the disc image it was extracted from. Does nothing if the game directory was fully extracted.
+     * Files which are already present are kept, even if they differ from the disc image.
+     * @param workingSet the files to extract if missing; if empty, the game directory is completed
+     * @param progressCallback called with a number in [0,1] as wit reports progress; throw ProgressCanceled to abort
+     */
+    QFuture<QString> extractMissingFiles(const QString &extractDir, const QSet<QString> &workingSet = {},
+                                         const std::function<void(double)> &progressCallback = [](double) {});
+    /**
+     * @brief createWbfsIso Packs a game directory to a disc image.
+     * A partially extracted game directory (see extractWbfsIso) is left as it is: wit can only pack complete
+     * directories, so it is mirrored into a temporary directory next to the disc image with hard links and the
+     * missing files are extracted there from the recorded disc image before packing.
+     * @param patchWiimmfi whether to apply the Wiimmfi patch while packing, so that the image is only written once
+     * @param progressCallback called with a number in [0,1] as wit reports progress; throw ProgressCanceled to abort
+     */
+    QFuture<QString> createWbfsIso(const QString &sourceDir, const QString &wbfsFile, const QString &markerCode, bool separateSaveGame, bool patchWiimmfi = false,
+                                   const std::function<void(double)> &progressCallback = [](double) {});
     QFuture<QString> patchWiimmfi(const QString &wbfsFile);
+    /**
+     * @return whether both disc images have the same content
+     */
+    QFuture<bool> compareWbfsIso(const QString &wbfsFile0, const QString &wbfsFile1);
     QFuture<QString> getId6(const QString &inputFile);
 
+    /**
+     * @brief Queues wszst jobs and runs them in as few invocations as possible: jobs which only differ in the file
+     * they process share one wszst process, in chunks to keep the command lines short. Every job has its own
+     * future, which finishes once run() has been called and the invocation the job belongs to has finished.
+     */
+    class SzsBatch {
+    public:
+        /**
+         * @brief extract Queues extracting sourceRoot/path (e.g. an .arc or .brres file) to the directory destRoot/path.
+         */
+        QFuture<void> extract(const QString &sourceRoot, const QString &path, const QString &destRoot);
+        /**
+         * @brief pack Queues packing the directory sourceRoot/path to the file destRoot/path followed by destSuffix.
+         * @param options additional options for wszst CREATE
+         */
+        QFuture<void> pack(const QString &sourceRoot, const QString &path, const QString &destRoot,
+                           const QString &destSuffix = "", const QStringList &options = {});
+        /**
+         * @brief run Starts all queued jobs; the batch is empty afterwards.
+         */
+        void run();
+    private:
+        struct Job {
+            QString path;
+            QSharedPointer<QPromise<void>> promise;
+        };
+        struct Invocation {
+            QString workingDirectory;
+            QStringList arguments;
+            QVector<Job> jobs;
+        };
+        QFuture<void> enqueue(const QString &workingDirectory, const QStringList &arguments, const QString &path);
+        /**
+         * @brief start Runs wszst on the files of the jobs; if it fails for several files, they are retried one by one
+         * so that only the jobs of the files wszst fails on fail.
+         */
+        static void start(const QString &workingDirectory, const QStringList &arguments, const QVector<Job> &jobs);
+
+        QMap<QStringList, Invocation> invocations;
+    };
+
     class Exception : public QException, public std::runtime_error {
     public:
         const char *what() const noexcept override { return std::runtime_error::what(); }
@@ -0,0 +1,195 @@
+#include "filecopy.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <filesystem>
+#include "lib/cancellation.h"
+#include "lib/progresscanceled.h"
+#include "lib/tracing.h"
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace FileCopy {
+
+#ifdef Q_OS_LINUX
+/**
+ * @return the number of bytes copied, or -1 if the kernel could not copy the whole file, in which case to is removed
+ */
+static qint64 kernelCopy(const QString &from, const QString &to) {
+    int in = ::open(QFile::encodeName(from).constData(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (::fstat(in, &st) != 0) {
+        ::close(in);
+        return -1;
+    }
+    int out = ::open(QFile::encodeName(to).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 0777);
+    if (out < 0) {
+        ::close(in);
+        return -1;
+    }
+    qint64 copied = 0;
+    if (::ioctl(out, FICLONE, in) == 0) {
+        copied = st.st_size;
+    } else {
+        while (copied < st.st_size) {
+            auto result = ::copy_file_range(in, nullptr, out, nullptr, st.st_size - copied, 0);
+            if (result <= 0) {
+                // EXDEV, ENOSYS, EINVAL etc., or no progress before the end of the file (e.g. on some network and
+                // virtual file systems): let the caller fall back to a user space copy
+                copied = -1;
+                break;
+            }
+            copied += result;
+        }
+    }
+    // keep the modification time, which the incremental stages compare against
+    if (copied >= 0) {
+        struct timespec times[2] = {st.st_atim, st.st_mtim};
+        ::futimens(out, times);
+    }
+    ::close(in);
+    if (::close(out) != 0 || copied < 0) {
+        QFile::remove(to);
+        return -1;
+    }
+    return copied;
+}
+#endif
+
+qint64 copyFile(const QString &from, const QString &to) {
+    Tracing::Span span("copy", QFileInfo(to).fileName());
+    if (QFileInfo::exists(to) && !QFile::remove(to)) {
+        throw Exception(QString("Could not replace %1").arg(to));
+    }
+#ifdef Q_OS_LINUX
+    auto copied = kernelCopy(from, to);
+    if (copied >= 0) {
+        span.arg("bytesWritten", copied);
+        return copied;
+    }
+#endif
+    if (!QFile::copy(from, to)) {
+        throw Exception(QString("Could not copy %1 to %2").arg(from, to));
+    }
+    QFile copiedFile(to);
+    if (copiedFile.open(QFile::ReadWrite)) {
+        copiedFile.setFileTime(QFileInfo(from).lastModified(), QFileDevice::FileModificationTime);
+    }
+    auto size = copiedFile.size();
+    span.arg("bytesWritten", size);
+    return size;
+}
+
+qint64 copyTree(const QString &from, const QString &to, bool overwrite,
+                const std::function<void(double)> &progressCallback) {
+    Tracing::Span span("copy", QDir(to).dirName());
+    QDir fromDir(from), toDir(to);
+    if (!fromDir.exists()) {
+        throw Exception(QString("%1 does not exist").arg(from));
+    }
+    if (!toDir.mkpath(".")) {
+        throw Exception(QString("Could not create %1").arg(to));
+    }
+    QVector<QString> files;
+    qint64 totalBytes = 0;
+    QDirIterator it(from, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        auto path = it.next();
+        auto relativePath = fromDir.relativeFilePath(path);
+        if (it.fileInfo().isDir()) {
+            if (!toDir.mkpath(relativePath)) {
+                throw Exception(QString("Could not create %1").arg(toDir.filePath(relativePath)));
+            }
+        } else {
+            if (!overwrite && QFileInfo::exists(toDir.filePath(relativePath))) {
+                throw Exception(QString("%1 already exists").arg(toDir.filePath(relativePath)));
+            }
+            files.append(relativePath);
+            totalBytes += it.fileInfo().size();
+        }
+    }
+
+    std::atomic<qint64> copiedBytes = 0;
+    std::atomic<bool> canceled = false;
+    QVector<QString> errors(files.size());
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+        auto token = Cancellation::current() ? *Cancellation::current() : Cancellation::Token();
+        for (int i = 0; i < files.size(); ++i) {
+            pool.start([&, i, token]() {
+                if (token.isCanceled()) {
+                    canceled = true;
+                    return;
+                }
+                try {
+                    copiedBytes += copyFile(fromDir.filePath(files[i]), toDir.filePath(files[i]));
+                } catch (const std::exception &e) {
+                    errors[i] = e.what();
+                }
+            });
+        }
+        // report progress from this thread, the callback need not be thread safe
+        while (!pool.waitForDone(100)) {
+            progressCallback(totalBytes > 0 ? double(copiedBytes) / totalBytes : 0);
+        }
+    }
+    if (canceled) {
+        throw ProgressCanceled("Canceled");
+    }
+    for (auto &error: errors) {
+        if (!error.isEmpty()) {
+            throw Exception(error);
+        }
+    }
+    progressCallback(1);
+    span.arg("bytesWritten", qint64(copiedBytes));
+    return copiedBytes;
+}
+
+void linkTree(const QString &from, const QString &to) {
+    std::error_code error;
+    std::filesystem::copy(from.toStdU16String(), to.toStdU16String(),
+                          std::filesystem::copy_options::recursive | std::filesystem::copy_options::create_hard_links, error);
+    if (!error) {
+        return;
+    }
+    QDir(to).removeRecursively();
+    copyTree(from, to);
+}
+
+QStringList moveMissingFiles(const QString &from, const QString &to) {
+    QDir fromDir(from), toDir(to);
+    QStringList moved;
+    QDirIterator it(from, QDir::Files | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        auto path = it.next();
+        auto relativePath = fromDir.relativeFilePath(path);
+        auto destPath = toDir.filePath(relativePath);
+        if (QFileInfo::exists(destPath)) {
+            continue;
+        }
+        if (!toDir.mkpath(QFileInfo(relativePath).path()) || !QFile::rename(path, destPath)) {
+            throw Exception(QString("Could not move %1 to %2").arg(path, destPath));
+        }
+        moved.append(relativePath);
+    }
+    return moved;
+}
+
+}
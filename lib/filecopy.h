@@ -0,0 +1,57 @@
+#ifndef FILECOPY_H
+#define FILECOPY_H
+
+#include <QException>
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <stdexcept>
+
+/**
+ * Copies files and directory trees. On Linux the data is cloned (FICLONE) where the file system supports
+ * reflinks and otherwise copied inside the kernel (copy_file_range); elsewhere QFile::copy is used.
+ */
+namespace FileCopy {
+
+/**
+ * @brief copyFile Copies from to to, keeping the modification time of from. An existing file at to is removed first,
+ * so other hard links to it are never written through.
+ * @return the number of bytes copied
+ */
+qint64 copyFile(const QString &from, const QString &to);
+
+/**
+ * @brief copyTree Copies the directory from with all its contents to to, copying several files at once. The files
+ * keep their modification times (see copyFile).
+ * @param overwrite whether existing files are replaced; if not, an existing file is an error
+ * @param progressCallback called with the fraction of the bytes copied so far
+ * @return the number of bytes copied
+ */
+qint64 copyTree(const QString &from, const QString &to, bool overwrite = false,
+                const std::function<void(double)> &progressCallback = [](double) {});
+
+/**
+ * @brief linkTree Mirrors the directory from to to with hard links, falling back to copyTree where from and to are on
+ * different file systems. Only for trees which are read afterwards, as writing a file in place writes through to from.
+ */
+void linkTree(const QString &from, const QString &to);
+
+/**
+ * @brief moveMissingFiles Moves the files below from which are missing below to into to, keeping the files which
+ * to already has. from and to must be on the same file system.
+ * @return the paths of the moved files, relative to to
+ */
+QStringList moveMissingFiles(const QString &from, const QString &to);
+
+class Exception : public QException, public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+    const char *what() const noexcept override { return std::runtime_error::what(); }
+    Exception(const QString &str) : std::runtime_error(str.toStdString()) {}
+    void raise() const override { throw *this; }
+    Exception *clone() const override { return new Exception(*this); }
+};
+
+}
+
+#endif // FILECOPY_H
@@ -0,0 +1,135 @@
+#include "filemanifest.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDirIterator>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <algorithm>
+#include "lib/cancellation.h"
+#include "lib/datafileset.h"
+#include "lib/importexportutils.h"
+#include "lib/tracing.h"
+
+namespace FileManifest {
+
+static constexpr quint32 MANIFEST_MAGIC = 0x43534d46; // "CSMF"
+static constexpr quint32 MANIFEST_VERSION = 1;
+
+QVector<QString> hashFiles(const QVector<QString> &filePaths) {
+    // the pool threads run without a token of their own
+    auto token = Cancellation::current() ? *Cancellation::current() : Cancellation::Token();
+    return QtConcurrent::blockingMapped<QVector<QString>>(filePaths, [token](const QString &filePath) {
+        Cancellation::Scope scope(token);
+        Cancellation::checkpoint();
+        return ImportExportUtils::fileSha1(filePath);
+    });
+}
+
+static QVector<QString> listFiles(const QDir &dir) {
+    QVector<QString> result;
+    QDirIterator dirIt(dir.path(), QDir::Files | QDir::NoDotAndDotDot | QDir::Hidden, QDirIterator::Subdirectories);
+    while (dirIt.hasNext()) {
+        result.append(dir.relativeFilePath(dirIt.next()));
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+Manifest compute(const QDir &dir) {
+    Tracing::Span span("hash", "manifest " + dir.dirName());
+    auto relativePaths = listFiles(dir);
+    span.arg("files", relativePaths.size());
+    QVector<QString> absolutePaths;
+    absolutePaths.reserve(relativePaths.size());
+    for (auto &relativePath: relativePaths) {
+        absolutePaths.append(dir.filePath(relativePath));
+    }
+    auto hashes = hashFiles(absolutePaths);
+
+    Manifest manifest;
+    manifest.reserve(relativePaths.size());
+    for (int i = 0; i < relativePaths.size(); ++i) {
+        manifest[relativePaths[i]] = {QFileInfo(absolutePaths[i]).size(), hashes[i]};
+    }
+    return manifest;
+}
+
+bool read(const QString &manifestFile, Manifest &manifest) {
+    QFile file(manifestFile);
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+    if (stream.status() != QDataStream::Ok || magic != MANIFEST_MAGIC || version != MANIFEST_VERSION) {
+        return false;
+    }
+    Manifest result;
+    result.reserve(count);
+    for (quint32 i = 0; i < count; ++i) {
+        QString path;
+        Entry entry;
+        stream >> path >> entry;
+        result[path] = entry;
+    }
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+    manifest = result;
+    return true;
+}
+
+void write(const QString &manifestFile, const Manifest &manifest) {
+    QSaveFile file(manifestFile);
+    if (!file.open(QFile::WriteOnly)) {
+        throw Exception("could not open " + manifestFile + " for writing");
+    }
+    QDataStream stream(&file);
+    stream << MANIFEST_MAGIC << MANIFEST_VERSION << quint32(manifest.size());
+    for (auto it = manifest.begin(); it != manifest.end(); ++it) {
+        stream << it.key() << it.value();
+    }
+    if (!file.commit()) {
+        throw Exception("could not write " + manifestFile);
+    }
+}
+
+/**
+ * Identifies a base image by its main.dol and the paths and sizes of its files folder,
+ * which is cheap to compute compared to hashing the whole folder.
+ */
+static QString vanillaFingerprint(const QDir &vanillaDir, const QDir &filesDir) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(ImportExportUtils::fileSha1(vanillaDir.filePath(MAIN_DOL)).toUtf8());
+    for (auto &relativePath: listFiles(filesDir)) {
+        hash.addData(relativePath.toUtf8());
+        hash.addData(QByteArray::number(QFileInfo(filesDir.filePath(relativePath)).size()));
+    }
+    return hash.result().toHex();
+}
+
+Manifest cachedVanillaManifest(const QDir &vanillaDir) {
+    QDir filesDir(vanillaDir.filePath("files"));
+    QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    cacheDir.mkpath("vanillaManifests");
+    auto manifestFile = cacheDir.filePath("vanillaManifests/" + vanillaFingerprint(vanillaDir, filesDir));
+
+    Manifest manifest;
+    if (read(manifestFile, manifest)) {
+        return manifest;
+    }
+    manifest = compute(filesDir);
+    try {
+        write(manifestFile, manifest);
+    } catch (const Exception &ex) {
+        // not being able to cache the manifest only costs time
+        qWarning() << ex.what();
+    }
+    return manifest;
+}
+
+}
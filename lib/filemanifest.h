@@ -0,0 +1,73 @@
+#ifndef FILEMANIFEST_H
+#define FILEMANIFEST_H
+
+#include <QDataStream>
+#include <QDir>
+#include <QHash>
+#include <QException>
+#include <stdexcept>
+
+namespace FileManifest {
+
+struct Entry {
+    qint64 size = -1;
+    QString sha1;
+
+    bool operator==(const Entry &other) const {
+        return size == other.size && sha1 == other.sha1;
+    }
+    bool operator!=(const Entry &other) const {
+        return !(*this == other);
+    }
+};
+
+inline QDataStream &operator<<(QDataStream &stream, const Entry &entry) {
+    return stream << entry.size << entry.sha1;
+}
+inline QDataStream &operator>>(QDataStream &stream, Entry &entry) {
+    return stream >> entry.size >> entry.sha1;
+}
+
+/**
+ * @brief Manifest maps a path relative to the manifest root to its size and SHA-1.
+ */
+typedef QHash<QString, Entry> Manifest;
+
+/**
+ * @brief compute Hashes every file below dir. Files are hashed in parallel.
+ * @param dir the root of the manifest
+ * @return the manifest with paths relative to dir
+ */
+Manifest compute(const QDir &dir);
+
+/**
+ * @brief hashFiles Hashes the given files in parallel.
+ * @param filePaths the files to hash
+ * @return the SHA-1 of each file, in the same order as filePaths
+ */
+QVector<QString> hashFiles(const QVector<QString> &filePaths);
+
+/**
+ * @brief cachedVanillaManifest Returns the manifest of the files folder of a vanilla game directory.
+ * The manifest is cached on disk keyed by the vanilla main.dol and the layout of the files folder,
+ * so it is only computed once per base image.
+ * @param vanillaDir the vanilla game directory
+ * @return the manifest with paths relative to the files folder
+ */
+Manifest cachedVanillaManifest(const QDir &vanillaDir);
+
+bool read(const QString &manifestFile, Manifest &manifest);
+void write(const QString &manifestFile, const Manifest &manifest);
+
+class Exception : public QException, public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+    const char *what() const noexcept override { return std::runtime_error::what(); }
+    Exception(const QString &str) : std::runtime_error(str.toStdString()) {}
+    void raise() const override { throw *this; }
+    Exception *clone() const override { return new Exception(*this); }
+};
+
+}
+
+#endif // FILEMANIFEST_H
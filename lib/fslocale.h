@@ -2,10 +2,33 @@
 #define FSLOCALE_H
 
 #include <QString>
+#include <array>
+#include <bitset>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 static const QString FS_LOCALES[] = {
     "en", "de", "fr", "it", "jp", "su", "uk"
 };
+/**
+ * The index of each locale in FS_LOCALES.
+ */
+enum FsLocale : quint8 {
+    LocaleEn, LocaleDe, LocaleFr, LocaleIt, LocaleJp, LocaleSu, LocaleUk
+};
+static constexpr int FS_LOCALE_COUNT = std::size(FS_LOCALES);
+inline std::optional<FsLocale> toFsLocale(const QString &locale) {
+    for (int i = 0; i < FS_LOCALE_COUNT; ++i) {
+        if (FS_LOCALES[i] == locale) {
+            return FsLocale(i);
+        }
+    }
+    return std::nullopt;
+}
 inline QString localeToYamlKey(const QString &locale) {
     if (locale == "su") {
         return "es";
@@ -27,6 +50,118 @@ inline QString localeToUpper(const QString &locale) {
     }
     return locale.toUpper();
 }
+/**
+ * A per-locale value for each locale in FS_LOCALES, stored inline so that looking a locale up is an array access.
+ * Locales can be absent like in a map; the string keyed part of the interface follows std::map.
+ */
+template<class T>
+class LocaleTable {
+public:
+    template<bool Const>
+    class Iterator {
+        using Table = std::conditional_t<Const, const LocaleTable, LocaleTable>;
+        using Value = std::conditional_t<Const, const T, T>;
+    public:
+        struct Entry {
+            const QString &first;
+            Value &second;
+        };
+        struct Arrow {
+            Entry entry;
+            const Entry *operator->() const { return &entry; }
+        };
+        Iterator(Table *table, int index) : table(table), index(index) { skipAbsent(); }
+        Entry operator*() const { return {FS_LOCALES[index], table->values[index]}; }
+        Arrow operator->() const { return {**this}; }
+        FsLocale locale() const { return FsLocale(index); }
+        Iterator &operator++() { ++index; skipAbsent(); return *this; }
+        bool operator==(const Iterator &other) const { return index == other.index; }
+        bool operator!=(const Iterator &other) const { return index != other.index; }
+    private:
+        void skipAbsent() { while (index < FS_LOCALE_COUNT && !table->present[index]) ++index; }
+        Table *table;
+        int index;
+    };
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    LocaleTable() = default;
+    /**
+     * @brief LocaleTable Converts a map keyed by locale, ignoring keys which are not in FS_LOCALES.
+     */
+    LocaleTable(const std::map<QString, T> &map) {
+        for (auto &entry: map) {
+            if (auto locale = toFsLocale(entry.first)) {
+                (*this)[*locale] = entry.second;
+            }
+        }
+    }
+    std::map<QString, T> toStdMap() const {
+        std::map<QString, T> result;
+        for (auto entry: *this) {
+            result.emplace(entry.first, entry.second);
+        }
+        return result;
+    }
+
+    T &operator[](FsLocale locale) { present[locale] = true; return values[locale]; }
+    T &operator[](const QString &locale) { return (*this)[checkedLocale(locale)]; }
+    T &at(FsLocale locale) { return const_cast<T &>(std::as_const(*this).at(locale)); }
+    const T &at(FsLocale locale) const {
+        if (!present[locale]) {
+            throw std::out_of_range("locale " + FS_LOCALES[locale].toStdString() + " is not set");
+        }
+        return values[locale];
+    }
+    T &at(const QString &locale) { return at(checkedLocale(locale)); }
+    const T &at(const QString &locale) const { return at(checkedLocale(locale)); }
+    size_t count(FsLocale locale) const { return present[locale]; }
+    size_t count(const QString &locale) const { auto fsLocale = toFsLocale(locale); return fsLocale && present[*fsLocale]; }
+    iterator find(FsLocale locale) { return present[locale] ? iterator(this, locale) : end(); }
+    const_iterator find(FsLocale locale) const { return present[locale] ? const_iterator(this, locale) : end(); }
+    iterator find(const QString &locale) { auto fsLocale = toFsLocale(locale); return fsLocale ? find(*fsLocale) : end(); }
+    const_iterator find(const QString &locale) const { auto fsLocale = toFsLocale(locale); return fsLocale ? find(*fsLocale) : end(); }
+    size_t erase(FsLocale locale) {
+        size_t erased = present[locale];
+        present[locale] = false;
+        values[locale] = T();
+        return erased;
+    }
+    size_t erase(const QString &locale) { auto fsLocale = toFsLocale(locale); return fsLocale ? erase(*fsLocale) : 0; }
+    void clear() { *this = LocaleTable(); }
+    bool empty() const { return present.none(); }
+    size_t size() const { return present.count(); }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, FS_LOCALE_COUNT); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, FS_LOCALE_COUNT); }
+
+    // absent locales always hold a default constructed value so the arrays can be compared directly
+    bool operator==(const LocaleTable &other) const { return present == other.present && values == other.values; }
+    bool operator!=(const LocaleTable &other) const { return !(*this == other); }
+    bool operator<(const LocaleTable &other) const {
+        if (present != other.present) {
+            return present.to_ulong() < other.present.to_ulong();
+        }
+        return values < other.values;
+    }
+private:
+    static FsLocale checkedLocale(const QString &locale) {
+        if (auto fsLocale = toFsLocale(locale)) {
+            return *fsLocale;
+        }
+        throw std::out_of_range("unknown locale " + locale.toStdString());
+    }
+
+    std::array<T, FS_LOCALE_COUNT> values{};
+    std::bitset<FS_LOCALE_COUNT> present;
+};
+
+template<class T>
+const T &retrieveStr(const LocaleTable<T> &table, FsLocale locale) {
+    return table.count(locale) ? table.at(locale) : table.at(LocaleEn);
+}
 template<class MapType>
 auto retrieveStr(const MapType &map, const QString &key) -> decltype(map.at(key)) {
     if (map.count(key)) {
@@ -1,21 +1,25 @@
 #include "importexportutils.h"
 
 #include <fstream>
+#include <memory>
 #include <QFileInfo>
-#include <QTemporaryDir>
 #include <QCryptographicHash>
 #include <filesystem>
 #include "lib/progresscanceled.h"
 #include "lib/vanilladatabase.h"
 #include "lib/datafileset.h"
-#include "zip/zip.h"
+#include "lib/zipreader.h"
+#include "lib/assetstore.h"
 #include "bsdiff/bspatchlib.h"
 #include "bsdiff/bsdifflib.h"
 #include "lib/uimessage.h"
 #include "lib/await.h"
 #include "lib/asyncfuture/asyncfuture.h"
 #include "lib/csmmnetworkmanager.h"
+#include "lib/descriptorcache.h"
 #include "lib/exewrapper.h"
+#include "lib/filecopy.h"
+#include "lib/tracing.h"
 
 namespace ImportExportUtils {
 
@@ -39,8 +43,10 @@ QString getSha1OfVanillaFileName(const QString &vanillaFileName) {
 }
 
 QString fileSha1(const QString &fileName) {
+   Tracing::Span span("hash", "sha1");
    QFile f(fileName);
    if (f.open(QFile::ReadOnly)) {
+       span.arg("bytesRead", f.size());
        QCryptographicHash hash(QCryptographicHash::Sha1);
        if (hash.addData(&f)) {
            return hash.result().toHex().toLower();
@@ -59,6 +65,8 @@ QString createBsdiff(const QString &oldfileStr, const QString &newfileStr, const
        return QString("%1 does not exist.").arg(newfileStr);
    }
 
+   Tracing::Span span("bsdiff", "bsdiff " + QFileInfo(newfileStr).fileName());
+   span.arg("bytesRead", oldfile.size() + newFile.size());
    char *errs = bsdiff(oldfileStr.toLatin1().constData(), newfileStr.toLatin1().constData(), patchfileStr.toLatin1().constData());
    if (errs)
        return QString(errs);
@@ -66,6 +74,7 @@ QString createBsdiff(const QString &oldfileStr, const QString &newfileStr, const
 }
 
 QString applyBspatch(const QString &oldfileStr, const QString &newfileStr, const QString &patchfileStr) {
+   Tracing::Span span("bsdiff", "bspatch " + QFileInfo(newfileStr).fileName());
    unsigned char	*in_buf, *out_buf, *patch_buf;
    int				in_sz, out_sz, patch_sz;
    char         	*errs;
@@ -97,6 +106,8 @@ QString applyBspatch(const QString &oldfileStr, const QString &newfileStr, const
        return QString("Could not open %1 for writing.").arg(newfileStr);
    }
    newfile.write((char*) out_buf, out_sz);
+   span.arg("bytesRead", in_sz + patch_sz);
+   span.arg("bytesWritten", out_sz);
    return QString();
 }
 
@@ -112,272 +123,336 @@ void exportYaml(const QDir &dir, const QString &yamlFileDest, const MapDescripto
             if (frbFile.isEmpty()) continue;
             auto frbFileFrom = dir.filePath(PARAM_FOLDER+"/"+frbFile + ".frb");
             auto frbFileTo = QFileInfo(yamlFileDest).dir().filePath(frbFile + ".frb");
-            QFile(frbFileTo).remove();
-            QFile::copy(frbFileFrom, frbFileTo);
+            FileCopy::copyFile(frbFileFrom, frbFileTo);
         }
     }
 }
 
-static void importYamlZip(const QString &yamlZipSrc, MapDescriptor &descriptor, const QDir &importDir,
-                          const std::function<void(double)> &progressCallback,
-                          const QString &backgroundZipDir) {
-    QTemporaryDir intermediateDir;
-    if (!intermediateDir.isValid()) {
-        throw Exception("Could not create an intermediate directory");
+// the asset store inside the import directory; the mods only read the folders below, so they never see it
+static const QString ASSET_STORE_FOLDER = ".csmm_assets";
+
+static Assets::Store assetStore(const QDir &importDir) {
+    return Assets::Store(importDir.filePath(ASSET_STORE_FOLDER));
+}
+
+void collectAssetGarbage(const QDir &importDir) {
+    assetStore(importDir).collectGarbage();
+}
+
+/**
+ * @brief stageFiles Adds the files the descriptor refers to to the asset store of importDir.
+ * @param storeFile adds the file with the given name next to the map descriptor to the store and returns the blob,
+ * throws if there is no such file
+ * @return where in importDir to place which blob
+ */
+static QVector<StagedFile> stageFiles(const MapDescriptor &descriptor,
+                                      const std::function<QString(const QString &fileName)> &storeFile) {
+    QVector<StagedFile> result;
+    // import frb files
+    for (auto &frbFile: descriptor.frbFiles) {
+        if (frbFile.isEmpty()) continue; // skip unused slots
+        result.append({storeFile(frbFile + ".frb"), PARAM_FOLDER+"/"+frbFile + ".frb"});
     }
-    QFileInfo yamlFileZipInfo(yamlZipSrc);
+    // import map icons if needed
+    if (!descriptor.mapIcon.isEmpty() && !VanillaDatabase::hasVanillaTpl(descriptor.mapIcon)) {
+        result.append({storeFile(descriptor.mapIcon + ".png"), PARAM_FOLDER + "/" + descriptor.mapIcon + ".png"});
+    }
+    // import music if needed
+    for (auto &mapEnt: descriptor.music) {
+        for (auto &musicEntry: mapEnt.second) {
+            result.append({storeFile(musicEntry.brstmBaseFilename + ".brstm"), SOUND_STREAM_FOLDER+"/"+musicEntry.brstmBaseFilename + ".brstm"});
+        }
+    }
+    // import background if needed
+    if(!VanillaDatabase::isVanillaBackground(descriptor.background)) {
+        // store the .cmpres file once and link it for every locale
+        auto cmpresBlob = storeFile(descriptor.background + ".cmpres");
+        for (auto &locale: FS_LOCALES) {
+            result.append({cmpresBlob, bgPath(locale, descriptor.background)});
+        }
+        // copy .scene file
+        result.append({storeFile(descriptor.background + ".scene"), SCENE_FOLDER+"/"+descriptor.background + ".scene"});
+        // copy turnlot images
+        for(char extChr='a'; extChr <= 'c'; ++extChr)
+        {
+            result.append({storeFile(turnlotPngFilename(extChr, descriptor.background)), turnlotPng(extChr, descriptor.background)});
+        }
+    }
+    return result;
+}
 
-    if(!yamlFileZipInfo.exists()) {
-        autoClearCache();
-        throw Exception(QString("Could not extract %1 to intermediate directory %2: The archive does not exist.").arg(yamlZipSrc, intermediateDir.path()));
+void placeStagedFiles(const QDir &importDir, const QVector<StagedFile> &files) {
+    auto store = assetStore(importDir);
+    if (!importDir.mkpath(PARAM_FOLDER)) {
+        throw Exception("could not create import param folder");
     }
-    if(yamlFileZipInfo.size() < 100) {
-        autoClearCache();
-        throw Exception(QString("Could not extract %1 to intermediate directory %2: The archive is corrupt or there was an error in the download. Check the logs.").arg(yamlZipSrc, intermediateDir.path()));
+    if (!importDir.mkpath(SOUND_STREAM_FOLDER)) {
+        throw Exception("could not create import sound stream folder");
     }
-    QString extractedYamlFile;
-    int extractResult = zip_extract(yamlZipSrc.toUtf8(), intermediateDir.path().toUtf8(), [](const char *candidate, void *arg) {
-        auto yamlFilePtr = (QString *)arg;
-        QFileInfo fi(candidate);
-        if (fi.suffix() == "yaml" && !fi.completeBaseName().startsWith(".")) {
-            *yamlFilePtr = candidate;
+    if (!importDir.mkpath(SCENE_FOLDER)) {
+        throw Exception("could not create import scene folder");
+    }
+    if (!importDir.mkpath(GAME_FOLDER)) {
+        throw Exception("could not create import game folder");
+    }
+    for (auto &locale: FS_LOCALES) {
+        if (!importDir.mkpath(bgPath(locale))) {
+            throw Exception("could not create import background folder for locale " + locale);
         }
-        return 0;
-    }, &extractedYamlFile);
-    if (extractResult < 0) {
-        autoClearCache();
-        throw Exception(QString("Could not extract %1 to intermediate directory %2: %3").arg(yamlZipSrc, intermediateDir.path(), zip_strerror(extractResult)));
     }
-    if (extractedYamlFile.isEmpty()) {
-        throw Exception("Zip file has no map descriptor");
+    for (auto &file: files) {
+        try {
+            store.materialize(file.blob, importDir.filePath(file.path));
+        } catch (const Assets::Exception &e) {
+            throw Exception(e.what());
+        }
     }
+}
 
-    std::ifstream yamlStream(std::filesystem::path(extractedYamlFile.toStdU16String()));
-    auto node = YAML::Load(yamlStream);
-    if (descriptor.fromYaml(node)) {
-        // check if <BACKGROUNDNAME>-Background.zip also needs to be extracted
-        if(!VanillaDatabase::isVanillaBackground(descriptor.background)) {
-            QString extractedCmpresFile = QFileInfo(extractedYamlFile).dir().filePath(descriptor.background + ".cmpres");
-            // the background.cmpres file is missing -> extract the background zip as well
-            if (!QFileInfo::exists(extractedCmpresFile)) {
-                QString zipBackgroundStr = (backgroundZipDir.isEmpty() ? QFileInfo(yamlZipSrc).dir() : QDir(backgroundZipDir))
-                        .filePath(descriptor.background + ".background.zip");
-                QFileInfo zipBackground(zipBackgroundStr);
-                if(zipBackground.exists()) {
-                    if(zipBackground.size() < 100) {
-                        autoClearCache();
-                        throw Exception(QString("Could not extract %1 to intermediate directory %2: The archive is corrupt or there was an error in the download. Check the logs.").arg(zipBackgroundStr, intermediateDir.path()));
-                    }
-                    QString extractedCmpresFile;
-                    int extractResult = zip_extract(zipBackgroundStr.toUtf8(), intermediateDir.path().toUtf8(), [](const char *candidate, void *arg){
-                        auto cmpresFilePtr = (QString *)arg;
-                        QFileInfo fi(candidate);
-                        if (fi.suffix() == "cmpres" && !fi.completeBaseName().startsWith(".")) {
-                            *cmpresFilePtr = candidate;
-                        }
-                        return 0;
-                    }, &extractedCmpresFile);
-                    if (extractResult < 0) {
-                        autoClearCache();
-                        throw Exception(QString("Could not extract %1 to intermediate directory %2: %3").arg(zipBackgroundStr, intermediateDir.path(), zip_strerror(extractResult)));
-                    }
-                    if (extractedCmpresFile.isEmpty()) {
-                        autoClearCache();
-                        throw Exception(QString("%1 has no cmpres files").arg(zipBackgroundStr));
-                    }
-                } else {
-                    autoClearCache();
-                    throw Exception(QString("%1 was not found.").arg(zipBackgroundStr));
-                }
-            }
+static QString findYamlEntry(const Zip::Reader &archive) {
+    QString yamlEntry;
+    for (auto &entry: archive.entries()) {
+        QFileInfo fi(entry);
+        if (fi.suffix() == "yaml" && !fi.completeBaseName().startsWith(".")) {
+            yamlEntry = entry;
         }
-        // check if <MAPNAME>-Music.zip also needs to be extracted
-        if(!descriptor.music.empty()) {
-            QVector<QString> missingBrstms;
-            for (auto &mapEnt: descriptor.music) {
-                for (auto &musicEntry: mapEnt.second) {
-                    QString extractedBrstmFile = QFileInfo(extractedYamlFile).dir().filePath(musicEntry.brstmBaseFilename + ".brstm");
-                    if(!QFileInfo::exists(extractedBrstmFile)) {
-                        missingBrstms.append(musicEntry.brstmBaseFilename + ".brstm");
-                    }
-                }
-            }
-            QString missingBrstmsStr = "";
-            for(auto &missingBrstmStr: missingBrstms) {
-                missingBrstmsStr += QString("\n- %1").arg(missingBrstmStr);
-            }
-            // not all required brtsm files reside yet in the intermediate directory -> extract the music zip as well
-            if (missingBrstms.size() > 0) {
-                QString zipMusicStr = QFileInfo(yamlZipSrc).dir().filePath(yamlFileZipInfo.baseName() + ".music.zip");
-                QFileInfo zipMusic(zipMusicStr);
-                if(node["music"].IsDefined()
-                        && node["music"]["download"].IsSequence()
-                        && node["music"]["download"].size() > 0) {
-                    qInfo() << "Downloading music:" << yamlFileZipInfo.baseName() + ".music.zip";
-                    auto urlsList = node["music"]["download"].as<std::vector<std::string>>();
-                    for (auto &url: urlsList) {
-                        QString urlStr = QString::fromStdString(url);
-                        try {
-                            CSMMNetworkManager::downloadFileIfUrl(urlStr, zipMusicStr, progressCallback);
-                            break;
-                        } catch (const ProgressCanceled &e) {
-                            throw e;
-                        } catch (const std::runtime_error &e) {
-                            qWarning() << "warning:" << e.what();
-                            // download failed, try next url
-                        }
-                    }
-                }
-                zipMusic = QFileInfo(zipMusicStr);
-                if(zipMusic.exists()) {
-                    if(zipMusic.size() < 100) {
-                        autoClearCache();
-                        throw Exception(QString("Could not extract %1 to intermediate directory %2: The archive is corrupt or there was an error in the download. Check the logs.").arg(zipMusicStr, intermediateDir.path()));
-                    }
-                    QString extractedBrstmFile;
-                    int extractResult = zip_extract(zipMusicStr.toUtf8(), intermediateDir.path().toUtf8(), [](const char *candidate, void *arg){
-                        auto brstmFilePtr = (QString *)arg;
-                        auto fi = QFileInfo(candidate);
-                        if (fi.suffix() == "brstm" && !fi.completeBaseName().startsWith(".")) {
-                            *brstmFilePtr = candidate;
-                        }
-                        return 0;
-                    }, &extractedBrstmFile);
-                    if (extractResult < 0) {
-                        autoClearCache();
-                        throw Exception(QString("Could not extract %1 to intermediate directory %2: %3").arg(zipMusicStr, intermediateDir.path(), zip_strerror(extractResult)));
-                    }
-                    if (extractedBrstmFile.isEmpty()) {
-                        autoClearCache();
-                        throw Exception(QString("%1 has no brstm files.\nThe following .brstm files are still missing:\n%2").arg(zipMusicStr, missingBrstmsStr));
-                    }
-                } else {
-                    autoClearCache();
-                    throw Exception(QString("%1 could not be retrieved.\nThe following .brstm files are still missing:\n%2").arg(zipMusicStr, missingBrstmsStr));
-                }
+    }
+    return yamlEntry;
+}
+
+static QString musicZipPath(const QString &yamlZipSrc) {
+    QFileInfo yamlFileZipInfo(yamlZipSrc);
+    return yamlFileZipInfo.dir().filePath(yamlFileZipInfo.baseName() + ".music.zip");
+}
+
+/**
+ * @brief downloadMusicZip Downloads <MAPNAME>.music.zip from the first working url in the music/download key.
+ */
+static void downloadMusicZip(const QString &yamlZipSrc, const YAML::Node &node, const std::function<void(double)> &progressCallback) {
+    if(node["music"].IsDefined()
+            && node["music"]["download"].IsSequence()
+            && node["music"]["download"].size() > 0) {
+        QString zipMusicStr = musicZipPath(yamlZipSrc);
+        qInfo() << "Downloading music:" << QFileInfo(zipMusicStr).fileName();
+        auto urlsList = node["music"]["download"].as<std::vector<std::string>>();
+        for (auto &url: urlsList) {
+            QString urlStr = QString::fromStdString(url);
+            try {
+                CSMMNetworkManager::downloadFileIfUrl(urlStr, zipMusicStr, progressCallback);
+                break;
+            } catch (const ProgressCanceled &e) {
+                throw e;
+            } catch (const std::runtime_error &e) {
+                qWarning() << "warning:" << e.what();
+                // download failed, try next url
             }
         }
-        importYaml(extractedYamlFile, descriptor, importDir);
-    } else {
-        throw Exception(QString("File %1 could not be parsed").arg(extractedYamlFile));
     }
 }
 
-void importYaml(const QString &yamlFileSrc, MapDescriptor &descriptor, const QDir &importDir,
-                const std::function<void(double)> &progressCallback,
-                const QString &backgroundZipDir) {
-    if(descriptor.names["en"] != ""){
-        qInfo() << "Importing:" <<  descriptor.names["en"];
+void downloadYamlDependencies(const QString &yamlFileSrc, const std::function<void(double)> &progressCallback) {
+    if (QFileInfo(yamlFileSrc).suffix() != "zip" || !QFileInfo::exists(yamlFileSrc)) {
+        return;
     }
-
-    if (QFileInfo(yamlFileSrc).suffix() == "zip") {
-        importYamlZip(yamlFileSrc, descriptor, importDir, progressCallback, backgroundZipDir);
-    } else {
-        if (!importDir.mkpath(PARAM_FOLDER)) {
-            throw Exception("could not create import param folder");
+    Zip::Reader mapArchive(yamlFileSrc);
+    auto yamlEntry = findYamlEntry(mapArchive);
+    if (yamlEntry.isEmpty()) {
+        return;
+    }
+    QSet<QString> mapFiles;
+    auto yamlDir = QFileInfo(yamlEntry).path();
+    for (auto &entry: mapArchive.entries()) {
+        QFileInfo fi(entry);
+        if (fi.path() == yamlDir) {
+            mapFiles.insert(fi.fileName());
+        }
+    }
+    auto node = YAML::Load(mapArchive.read(yamlEntry).toStdString());
+    // the same brstm names MapDescriptor::fromYaml reads
+    bool missingBrstms = false;
+    for (auto it=node["music"].begin(); it!=node["music"].end(); ++it) {
+        auto musicTypeStr = QString::fromStdString(it->first.as<std::string>());
+        if (it->second.IsNull() || !Music::isMusicType(musicTypeStr)) {
+            continue;
+        }
+        if (it->second.IsSequence()) {
+            for (auto &val: it->second) {
+                missingBrstms |= !mapFiles.contains(QString::fromStdString(val.as<std::string>()) + ".brstm");
+            }
+        } else {
+            missingBrstms |= !mapFiles.contains(QString::fromStdString(it->second.as<std::string>()) + ".brstm");
         }
-        if (!importDir.mkpath(SOUND_STREAM_FOLDER)) {
-            throw Exception("could not create import sound stream folder");
+    }
+    if (missingBrstms) {
+        downloadMusicZip(yamlFileSrc, node, progressCallback);
+    }
+}
+
+/**
+ * @brief stageYamlZip Stages a zipped map by streaming the files the descriptor refers to straight out of the
+ * map zip (and its background and music zips if needed) into the asset store; other entries are never extracted.
+ */
+static QVector<StagedFile> stageYamlZip(const QString &yamlZipSrc, MapDescriptor &descriptor, const QDir &importDir,
+                                        const std::function<void(double)> &progressCallback,
+                                        const QString &backgroundZipDir, bool online) {
+    auto clearCache = [online]() { if (online) autoClearCache(); };
+    auto checkArchive = [&](const QString &zipFile) {
+        QFileInfo zipFileInfo(zipFile);
+        if (!zipFileInfo.exists()) {
+            clearCache();
+            throw Exception(QString("Could not extract %1: The archive does not exist.").arg(zipFile));
         }
-        if (!importDir.mkpath(SCENE_FOLDER)) {
-            throw Exception("could not create import scene folder");
+        if (zipFileInfo.size() < 100) {
+            clearCache();
+            throw Exception(QString("Could not extract %1: The archive is corrupt or there was an error in the download. Check the logs.").arg(zipFile));
         }
-        if (!importDir.mkpath(GAME_FOLDER)) {
-            throw Exception("could not create import game folder");
+    };
+    std::vector<std::unique_ptr<Zip::Reader>> archives;
+    auto openArchive = [&](const QString &zipFile) -> Zip::Reader & {
+        checkArchive(zipFile);
+        try {
+            archives.push_back(std::make_unique<Zip::Reader>(zipFile));
+        } catch (const Zip::Exception &e) {
+            clearCache();
+            throw Exception(e.what());
         }
-        for (auto &locale: FS_LOCALES) {
-            if (!importDir.mkpath(bgPath(locale))) {
-                throw Exception("could not create import background folder for locale " + locale);
+        return *archives.back();
+    };
+    // file name -> archive and entry the file is read from; the map zip takes precedence
+    QHash<QString, QPair<Zip::Reader *, QString>> files;
+    auto addFiles = [&](Zip::Reader &archive, const std::function<bool(const QFileInfo &)> &filter) {
+        for (auto &entry: archive.entries()) {
+            QFileInfo fi(entry);
+            if (filter(fi) && !files.contains(fi.fileName())) {
+                files[fi.fileName()] = {&archive, entry};
             }
         }
+    };
 
-        std::ifstream yamlStream(std::filesystem::path(yamlFileSrc.toStdU16String()));
-        auto node = YAML::Load(yamlStream);
-        if (descriptor.fromYaml(node)) {
-            // import frb files
-            for (auto &frbFile: descriptor.frbFiles) {
-                if (frbFile.isEmpty()) continue; // skip unused slots
-
-                auto frbFileFrom = QFileInfo(yamlFileSrc).dir().filePath(frbFile + ".frb");
-                QFileInfo frbFileFromInfo(frbFileFrom);
-                if (!frbFileFromInfo.exists() || !frbFileFromInfo.isFile()) {
-                    autoClearCache();
-                    throw Exception(QString("File %1 does not exist").arg(frbFileFrom));
-                }
-                auto frbFileTo = importDir.filePath(PARAM_FOLDER+"/"+frbFile + ".frb");
-                QFile(frbFileTo).remove();
-                QFile::copy(frbFileFrom, frbFileTo);
-            }
-            // import map icons if needed
-            if (!descriptor.mapIcon.isEmpty() && !VanillaDatabase::hasVanillaTpl(descriptor.mapIcon)) {
-                auto mapIconFileFrom = QFileInfo(yamlFileSrc).dir().filePath(descriptor.mapIcon + ".png");
-                auto mapIconFileTo = importDir.filePath(PARAM_FOLDER + "/" + descriptor.mapIcon + ".png");
-                QFileInfo mapIconFileFromInfo(mapIconFileFrom);
-                if (!mapIconFileFromInfo.exists() || !mapIconFileFromInfo.isFile()) {
-                    autoClearCache();
-                    throw Exception(QString("File %1 does not exist").arg(mapIconFileFrom));
-                }
-                QFile(mapIconFileTo).remove();
-                QFile::copy(mapIconFileFrom, mapIconFileTo);
-            }
-            // import music if needed
-            for (auto &mapEnt: descriptor.music) {
-                for (auto &musicEntry: mapEnt.second) {
-                    auto brstmFileFrom = QFileInfo(yamlFileSrc).dir().filePath(musicEntry.brstmBaseFilename + ".brstm");
-                    QFileInfo brstmFileInfo(brstmFileFrom);
-                    if (!brstmFileInfo.exists() || !brstmFileInfo.isFile()) {
-                        autoClearCache();
-                        throw Exception(QString("File %1 does not exist").arg(brstmFileFrom));
-                    }
-                    auto frbFileTo = importDir.filePath(SOUND_STREAM_FOLDER+"/"+musicEntry.brstmBaseFilename + ".brstm");
-                    QFile(frbFileTo).remove();
-                    QFile::copy(brstmFileFrom, frbFileTo);
-                }
-            }
-            // import background if needed
-            if(!VanillaDatabase::isVanillaBackground(descriptor.background)) {
-                // copy .cmpres file
-                auto cmpresFileFrom = QFileInfo(yamlFileSrc).dir().filePath(descriptor.background + ".cmpres");
-                QFileInfo cmpresFileInfo(cmpresFileFrom);
-                if (!cmpresFileInfo.exists() || !cmpresFileInfo.isFile()) {
-                    autoClearCache();
-                    throw Exception(QString("File %1 does not exist").arg(cmpresFileFrom));
-                }
-                for (auto &locale: FS_LOCALES) {
-                    auto cmpresFileTo = importDir.filePath(bgPath(locale, descriptor.background));
-                    QFile(cmpresFileTo).remove();
-                    QFile::copy(cmpresFileFrom, cmpresFileTo);
-                }
-                // copy .scene file
-                auto sceneFileFrom = QFileInfo(yamlFileSrc).dir().filePath(descriptor.background + ".scene");
-                QFileInfo sceneFileInfo(sceneFileFrom);
-                if (!sceneFileInfo.exists() || !sceneFileInfo.isFile()) {
-                    autoClearCache();
-                    throw Exception(QString("File %1 does not exist").arg(sceneFileFrom));
-                }
-                auto sceneFileTo = importDir.filePath(SCENE_FOLDER+"/"+descriptor.background + ".scene");
-                QFile(sceneFileTo).remove();
-                QFile::copy(sceneFileFrom, sceneFileTo);
-                // copy turnlot images
-                for(char extChr='a'; extChr <= 'c'; ++extChr)
-                {
-                    QString turnlotPngFrom = QFileInfo(yamlFileSrc).dir().filePath(turnlotPngFilename(extChr, descriptor.background));
-                    QFileInfo turnlotPngInfo(turnlotPngFrom);
-                    if (!turnlotPngInfo.exists() || !turnlotPngInfo.isFile()) {
-                        autoClearCache();
-                        throw Exception(QString("File %1 does not exist").arg(turnlotPngFrom));
-                    }
-                    QString turnlotPngTo = importDir.filePath(turnlotPng(extChr, descriptor.background));
-                    QFile(turnlotPngTo).remove();
-                    QFile::copy(turnlotPngFrom, turnlotPngTo);
+    auto &mapArchive = openArchive(yamlZipSrc);
+    QString yamlEntry = findYamlEntry(mapArchive);
+    if (yamlEntry.isEmpty()) {
+        throw Exception("Zip file has no map descriptor");
+    }
+    auto yamlDir = QFileInfo(yamlEntry).path();
+    addFiles(mapArchive, [&](const QFileInfo &fi) { return fi.path() == yamlDir; });
+
+    QByteArray yaml;
+    try {
+        yaml = mapArchive.read(yamlEntry);
+    } catch (const Zip::Exception &e) {
+        clearCache();
+        throw Exception(e.what());
+    }
+    if (!DescriptorCache::fromYaml(yaml, descriptor)) {
+        throw Exception(QString("File %1 in %2 could not be parsed").arg(yamlEntry, yamlZipSrc));
+    }
+
+    // check if <BACKGROUNDNAME>.background.zip is also needed
+    QString cmpresFile = descriptor.background + ".cmpres";
+    if (!VanillaDatabase::isVanillaBackground(descriptor.background) && !files.contains(cmpresFile)) {
+        QString zipBackgroundStr = (backgroundZipDir.isEmpty() ? QFileInfo(yamlZipSrc).dir() : QDir(backgroundZipDir))
+                .filePath(descriptor.background + ".background.zip");
+        if (!QFileInfo::exists(zipBackgroundStr)) {
+            clearCache();
+            throw Exception(QString("%1 was not found.").arg(zipBackgroundStr));
+        }
+        addFiles(openArchive(zipBackgroundStr), [](const QFileInfo &fi) { return !fi.completeBaseName().startsWith("."); });
+        if (!files.contains(cmpresFile)) {
+            clearCache();
+            throw Exception(QString("%1 has no %2").arg(zipBackgroundStr, cmpresFile));
+        }
+    }
+    // check if <MAPNAME>.music.zip is also needed
+    auto missingBrstms = [&]() {
+        QString missingBrstmsStr;
+        for (auto &mapEnt: descriptor.music) {
+            for (auto &musicEntry: mapEnt.second) {
+                if (!files.contains(musicEntry.brstmBaseFilename + ".brstm")) {
+                    missingBrstmsStr += QString("\n- %1").arg(musicEntry.brstmBaseFilename + ".brstm");
                 }
             }
-            // set internal name
-            descriptor.internalName = QFileInfo(yamlFileSrc).baseName();
-        } else {
-            throw Exception(QString("File %1 could not be parsed").arg(yamlFileSrc));
         }
+        return missingBrstmsStr;
+    };
+    if (!missingBrstms().isEmpty()) {
+        QString zipMusicStr = musicZipPath(yamlZipSrc);
+        if (online) {
+            downloadMusicZip(yamlZipSrc, YAML::Load(yaml.toStdString()), progressCallback);
+        }
+        if (!QFileInfo::exists(zipMusicStr)) {
+            clearCache();
+            throw Exception(QString("%1 could not be retrieved.\nThe following .brstm files are still missing:\n%2").arg(zipMusicStr, missingBrstms()));
+        }
+        addFiles(openArchive(zipMusicStr), [](const QFileInfo &fi) { return fi.suffix() == "brstm" && !fi.completeBaseName().startsWith("."); });
+        if (!missingBrstms().isEmpty()) {
+            clearCache();
+            throw Exception(QString("%1 is missing .brstm files.\nThe following .brstm files are still missing:\n%2").arg(zipMusicStr, missingBrstms()));
+        }
+    }
+
+    auto store = assetStore(importDir);
+    auto staged = stageFiles(descriptor, [&](const QString &fileName) {
+        if (!files.contains(fileName)) {
+            clearCache();
+            throw Exception(QString("File %1 does not exist in %2").arg(fileName, yamlZipSrc));
+        }
+        auto &source = files[fileName];
+        try {
+            QString tmp = store.temporaryFile();
+            source.first->extract(source.second, tmp);
+            return store.take(tmp);
+        } catch (const Zip::Exception &e) {
+            clearCache();
+            throw Exception(e.what());
+        } catch (const Assets::Exception &e) {
+            throw Exception(e.what());
+        }
+    });
+    descriptor.internalName = QFileInfo(yamlEntry).baseName();
+    return staged;
+}
+
+QVector<StagedFile> stageYaml(const QString &yamlFileSrc, MapDescriptor &descriptor, const QDir &importDir,
+                              const std::function<void(double)> &progressCallback,
+                              const QString &backgroundZipDir, bool online) {
+    auto clearCache = [online]() { if (online) autoClearCache(); };
+    if(descriptor.names["en"] != ""){
+        qInfo() << "Importing:" <<  descriptor.names["en"];
     }
+
+    if (QFileInfo(yamlFileSrc).suffix() == "zip") {
+        return stageYamlZip(yamlFileSrc, descriptor, importDir, progressCallback, backgroundZipDir, online);
+    }
+    QFile yamlFile(yamlFileSrc);
+    if (!yamlFile.open(QFile::ReadOnly)) {
+        throw Exception(QString("Could not open %1").arg(yamlFileSrc));
+    }
+    if (!DescriptorCache::fromYaml(yamlFile.readAll(), descriptor)) {
+        throw Exception(QString("File %1 could not be parsed").arg(yamlFileSrc));
+    }
+    auto staged = stageFiles(descriptor, [&](const QString &fileName) {
+        auto fileFrom = QFileInfo(yamlFileSrc).dir().filePath(fileName);
+        QFileInfo fileFromInfo(fileFrom);
+        if (!fileFromInfo.exists() || !fileFromInfo.isFile()) {
+            clearCache();
+            throw Exception(QString("File %1 does not exist").arg(fileFrom));
+        }
+        try {
+            return assetStore(importDir).add(fileFrom);
+        } catch (const Assets::Exception &e) {
+            throw Exception(e.what());
+        }
+    });
+    // set internal name
+    descriptor.internalName = QFileInfo(yamlFileSrc).baseName();
+    return staged;
+}
+
+void importYaml(const QString &yamlFileSrc, MapDescriptor &descriptor, const QDir &importDir,
+                const std::function<void(double)> &progressCallback,
+                const QString &backgroundZipDir, bool online) {
+    placeStagedFiles(importDir, stageYaml(yamlFileSrc, descriptor, importDir, progressCallback, backgroundZipDir, online));
 }
 
 bool isMainDolVanilla(const QDir &dir) {
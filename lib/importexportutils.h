@@ -22,10 +22,48 @@ namespace ImportExportUtils {
      * @param descriptor the descriptor to modify
      * @param importDir the directory to place .frb files before saving, etc.
      * @param progressCallback called with a number in [0,1] to indicate import progress
+     * @param online whether to download the music zip and clear the network cache on errors; pass false when the
+     * dependencies were downloaded with downloadYamlDependencies beforehand
      * @return whether the import was successful
      */
     void importYaml(const QString &yamlFileSrc, MapDescriptor &descriptor, const QDir &importDir,
-                    const std::function<void(double)> &progressCallback = [](double) {}, const QString &backgroundZipDir = "");
+                    const std::function<void(double)> &progressCallback = [](double) {}, const QString &backgroundZipDir = "",
+                    bool online = true);
+
+    /**
+     * @brief StagedFile A file of an imported map which is in the asset store but not yet placed into the import
+     * directory.
+     */
+    struct StagedFile {
+        QString blob;
+        // the path relative to the import directory
+        QString path;
+    };
+
+    /**
+     * @brief stageYaml Like importYaml, but only adds the files to the asset store of importDir without placing them
+     * into importDir. Maps can be staged in parallel and then placed one after another with placeStagedFiles, so
+     * that maps sharing a file name resolve in a fixed order.
+     * @return the files to place
+     */
+    QVector<StagedFile> stageYaml(const QString &yamlFileSrc, MapDescriptor &descriptor, const QDir &importDir,
+                                  const std::function<void(double)> &progressCallback = [](double) {},
+                                  const QString &backgroundZipDir = "", bool online = true);
+
+    /**
+     * @brief placeStagedFiles Places the files of a map staged with stageYaml into importDir.
+     */
+    void placeStagedFiles(const QDir &importDir, const QVector<StagedFile> &files);
+
+    /**
+     * @brief downloadYamlDependencies Downloads the music zip of a zipped map if the map zip lacks its .brstm files.
+     */
+    void downloadYamlDependencies(const QString &yamlFileSrc, const std::function<void(double)> &progressCallback = [](double) {});
+
+    /**
+     * @brief collectAssetGarbage Frees the imported assets which are no longer used by any file in importDir.
+     */
+    void collectAssetGarbage(const QDir &importDir);
 
     QString getSha1OfVanillaFileName(const QString &vanillaFileName);
 
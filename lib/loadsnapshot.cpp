@@ -0,0 +1,195 @@
+#include "loadsnapshot.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDirIterator>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <algorithm>
+
+namespace LoadSnapshot {
+
+static constexpr quint32 SNAPSHOT_MAGIC = 0x43534c53; // "CSLS"
+static constexpr quint32 SNAPSHOT_VERSION = 1;
+
+static QString snapshotPath(const QDir &gameDir) {
+    return gameDir.filePath("csmm_load_snapshot.bin");
+}
+
+/**
+ * @return whether the file is one CSMM keeps in the game directory besides the game files, which loading does not read
+ */
+static bool isCsmmStateFile(const QString &relativePath) {
+    return relativePath == "csmm_load_snapshot.bin" || relativePath == "csmm_pending_changes.yaml"
+            || relativePath.startsWith("csmm_extract_");
+}
+
+/**
+ * @brief expandPattern Expands a file dependency to the files of the game directory it matches. As with wit, a
+ * wildcard in the file name also matches the files in subdirectories; a wildcard in a directory matches the whole tree.
+ * @return the matching files relative to gameDir; a pattern without wildcards is returned as is, even if missing
+ */
+static QStringList expandPattern(const QDir &gameDir, const QString &pattern) {
+    static const QRegularExpression wildcard("[*?\\[]");
+    if (!pattern.contains(wildcard)) {
+        return {pattern};
+    }
+    QString dir = QFileInfo(pattern).path();
+    QString namePattern = QFileInfo(pattern).fileName();
+    if (dir.contains(wildcard)) {
+        dir = ".";
+        namePattern = "*";
+    }
+    QStringList result;
+    QDirIterator it(QDir::cleanPath(gameDir.filePath(dir)), {namePattern}, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        auto relativePath = gameDir.relativeFilePath(it.next());
+        if (!isCsmmStateFile(relativePath)) {
+            result.append(relativePath);
+        }
+    }
+    return result;
+}
+
+static void addFiles(QCryptographicHash &hash, const QDir &gameDir, const QSet<QString> &patterns) {
+    QSet<QString> files;
+    for (auto &pattern: patterns) {
+        for (auto &file: expandPattern(gameDir, pattern)) {
+            files.insert(file);
+        }
+    }
+    auto sortedFiles = files.values();
+    std::sort(sortedFiles.begin(), sortedFiles.end());
+    for (auto &file: sortedFiles) {
+        QFileInfo info(gameDir.filePath(file));
+        hash.addData(QString("%1|%2|%3\n").arg(file).arg(info.exists() ? info.size() : -1)
+                     .arg(info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1).toUtf8());
+    }
+}
+
+QByteArray treeStamp(const QDir &gameDir) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    addFiles(hash, gameDir, {"*"});
+    return hash.result();
+}
+
+QByteArray fingerprint(const QDir &gameDir, const QSet<QString> &files, const QString &modpackFile) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    // the mods themselves may change how the game is loaded
+    hash.addData(QCoreApplication::applicationVersion().toUtf8() + "\n");
+    if (!modpackFile.isEmpty()) {
+        QFileInfo modpackInfo(modpackFile);
+        hash.addData(QString("%1|%2|%3\n").arg(modpackInfo.absoluteFilePath()).arg(modpackInfo.size())
+                     .arg(modpackInfo.lastModified().toMSecsSinceEpoch()).toUtf8());
+    }
+    addFiles(hash, gameDir, files);
+    return hash.result();
+}
+
+static void writeDescriptor(QDataStream &stream, const MapDescriptor &descriptor) {
+    stream << descriptor.toYaml();
+    // the fields which are not part of the yaml, or which the yaml does not determine
+    stream << descriptor.mapSet << descriptor.zone << descriptor.order << descriptor.isPracticeBoard
+           << descriptor.unlockId << descriptor.nameMsgId << descriptor.descMsgId
+           << descriptor.internalName << descriptor.mapDescriptorFilePath
+           << QVector<quint32>(descriptor.districtNameIds.begin(), descriptor.districtNameIds.end())
+           << descriptor.shopNameStartId << (quint32)descriptor.bgmId << descriptor.mapIcon
+           << descriptor.tourInitialCash;
+}
+
+static void readDescriptor(QDataStream &stream, MapDescriptor &descriptor) {
+    QString yaml;
+    stream >> yaml;
+    if (stream.status() != QDataStream::Ok || !descriptor.fromYaml(YAML::Load(yaml.toStdString()))) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return;
+    }
+    QVector<quint32> districtNameIds;
+    quint32 bgmId;
+    stream >> descriptor.mapSet >> descriptor.zone >> descriptor.order >> descriptor.isPracticeBoard
+           >> descriptor.unlockId >> descriptor.nameMsgId >> descriptor.descMsgId
+           >> descriptor.internalName >> descriptor.mapDescriptorFilePath
+           >> districtNameIds
+           >> descriptor.shopNameStartId >> bgmId >> descriptor.mapIcon
+           >> descriptor.tourInitialCash;
+    descriptor.districtNameIds.assign(districtNameIds.begin(), districtNameIds.end());
+    descriptor.bgmId = (BgmId)bgmId;
+}
+
+static bool readDescriptors(QIODevice *device, const QByteArray &fingerprint, std::vector<MapDescriptor> &descriptors) {
+    QDataStream stream(device);
+    quint32 magic, version;
+    QByteArray snapshotFingerprint;
+    quint32 count;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+        return false;
+    }
+    stream >> snapshotFingerprint >> count;
+    if (stream.status() != QDataStream::Ok || snapshotFingerprint != fingerprint) {
+        return false;
+    }
+    std::vector<MapDescriptor> result(count);
+    try {
+        for (auto &descriptor: result) {
+            readDescriptor(stream, descriptor);
+            if (stream.status() != QDataStream::Ok) {
+                return false;
+            }
+        }
+    } catch (const std::exception &exception) {
+        qDebug() << "could not read the load snapshot:" << exception.what();
+        return false;
+    }
+    if (!stream.atEnd()) {
+        return false;
+    }
+    descriptors = std::move(result);
+    return true;
+}
+
+bool read(const QDir &gameDir, const QByteArray &fingerprint, std::vector<MapDescriptor> &descriptors) {
+    QFile file(snapshotPath(gameDir));
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+    if (!readDescriptors(&file, fingerprint, descriptors)) {
+        qDebug() << "the load snapshot of" << gameDir.path() << "is out of date, loading the game directory";
+        return false;
+    }
+    return true;
+}
+
+void write(const QDir &gameDir, const QByteArray &fingerprint, const std::vector<MapDescriptor> &descriptors) {
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadWrite);
+    {
+        QDataStream stream(&buffer);
+        stream << SNAPSHOT_MAGIC << SNAPSHOT_VERSION << fingerprint << (quint32)descriptors.size();
+        for (auto &descriptor: descriptors) {
+            writeDescriptor(stream, descriptor);
+        }
+    }
+
+    // consistency check: only keep the snapshot if it reproduces the loaded descriptors
+    buffer.seek(0);
+    std::vector<MapDescriptor> readBack;
+    if (!readDescriptors(&buffer, fingerprint, readBack) || !std::equal(descriptors.begin(), descriptors.end(), readBack.begin(), readBack.end())) {
+        qDebug() << "the descriptors of" << gameDir.path() << "cannot be snapshotted, they will be loaded every time";
+        QFile::remove(snapshotPath(gameDir));
+        return;
+    }
+
+    QSaveFile file(snapshotPath(gameDir));
+    if (!file.open(QFile::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qWarning() << "could not write the load snapshot of" << gameDir.path();
+    }
+}
+
+}
@@ -0,0 +1,45 @@
+#ifndef LOADSNAPSHOT_H
+#define LOADSNAPSHOT_H
+
+#include <QDir>
+#include <QSet>
+#include <vector>
+#include "lib/mapdescriptor.h"
+
+/**
+ * Keeps a snapshot of the map descriptors loaded from a game directory next to its pending changes, so that
+ * the CLI does not need to read main.dol and the message files again as long as they have not changed.
+ */
+namespace LoadSnapshot {
+
+/**
+ * @brief fingerprint Identifies the state a game directory is loaded from.
+ * @param gameDir the game directory
+ * @param files the files the mods load from, relative to gameDir (see CSMMModpack::fileDependencies). Wildcards are
+ * expanded; "*" stands for every file of the game directory.
+ * @param modpackFile the modpack the mods were imported from, or an empty string for the default modlist
+ * @return a hash over the paths, sizes and modification times of the files and over the modpack
+ */
+QByteArray fingerprint(const QDir &gameDir, const QSet<QString> &files, const QString &modpackFile);
+
+/**
+ * @return a hash over the paths, sizes and modification times of every file of the game directory, except the
+ * files CSMM keeps there besides the game, such as the snapshot and the pending changes
+ */
+QByteArray treeStamp(const QDir &gameDir);
+
+/**
+ * @brief read Reads the snapshot of the game directory.
+ * @return whether a consistent snapshot with the given fingerprint was read into descriptors
+ */
+bool read(const QDir &gameDir, const QByteArray &fingerprint, std::vector<MapDescriptor> &descriptors);
+
+/**
+ * @brief write Writes a snapshot of the descriptors loaded from the game directory. Nothing is written if the
+ * descriptors do not survive being read back unchanged.
+ */
+void write(const QDir &gameDir, const QByteArray &fingerprint, const std::vector<MapDescriptor> &descriptors);
+
+}
+
+#endif // LOADSNAPSHOT_H
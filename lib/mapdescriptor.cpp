@@ -333,14 +333,19 @@ void MapDescriptor::shopNamesFromYaml(const YAML::Node &yaml) {
 bool MapDescriptor::fromYaml(const YAML::Node &yaml) {
     names.clear();
     descs.clear();
+    // locales the game does not have are ignored
     for (auto it=yaml["name"].begin(); it!=yaml["name"].end(); ++it) {
-        names[yamlKeyToLocale(QString::fromStdString(it->first.as<std::string>()))] = QString::fromStdString(it->second.as<std::string>());
+        if (auto locale = toFsLocale(yamlKeyToLocale(QString::fromStdString(it->first.as<std::string>())))) {
+            names[*locale] = QString::fromStdString(it->second.as<std::string>());
+        }
     }
     for (auto it=yaml["desc"].begin(); it!=yaml["desc"].end(); ++it) {
-        descs[yamlKeyToLocale(QString::fromStdString(it->first.as<std::string>()))] = QString::fromStdString(it->second.as<std::string>());
+        if (auto locale = toFsLocale(yamlKeyToLocale(QString::fromStdString(it->first.as<std::string>())))) {
+            descs[*locale] = QString::fromStdString(it->second.as<std::string>());
+        }
     }
-    names.erase("uk");
-    descs.erase("uk");
+    names.erase(LocaleUk);
+    descs.erase(LocaleUk);
 
     ruleSet = yaml["ruleSet"].as<std::string>() == "Easy" ? Easy : Standard;
     theme = yaml["theme"].as<std::string>() == "Mario" ? Mario : DragonQuest;
@@ -472,10 +477,11 @@ bool MapDescriptor::fromYaml(const YAML::Node &yaml) {
         auto dnNode = yaml["districtNames"];
         districtNames.clear();
         for (auto it=dnNode.begin(); it!=dnNode.end(); ++it) {
-            auto key = yamlKeyToLocale(QString::fromStdString(it->first.as<std::string>()));
+            auto locale = toFsLocale(yamlKeyToLocale(QString::fromStdString(it->first.as<std::string>())));
+            if (!locale) continue;
             for (const auto &val: it->second) {
                 auto convVal = QString::fromStdString(val.as<std::string>());
-                districtNames[key].push_back(convVal);
+                districtNames[*locale].push_back(convVal);
             }
         }
     } else {
@@ -495,7 +501,11 @@ bool MapDescriptor::fromYaml(const YAML::Node &yaml) {
     shopNames = VanillaDatabase::getVanillaShopNames();
     shopNamesFromYaml(yaml);
 
-    if (yaml["extraData"]) extraData = pybind11::dict(nodeToCustomData(yaml["extraData"]));
+    if (yaml["extraData"]) {
+        // map lists are imported on several threads at once
+        pybind11::gil_scoped_acquire gil;
+        extraData = pybind11::dict(nodeToCustomData(yaml["extraData"]));
+    }
 
     return true;
 }
@@ -8,6 +8,7 @@
 #include <QVector>
 #include <yaml-cpp/yaml.h>
 #include "fortunestreetdata.h"
+#include "fslocale.h"
 #include "lib/python/pyobjcopywrapper.h"
 #include "music.h"
 #include "mutator/mutator.h"
@@ -87,18 +88,18 @@ struct MapDescriptor {
     quint32 tourClearRank = 2;
     quint32 nameMsgId = 0;
     quint32 descMsgId = 0;
-    std::map<QString, QString> names;
-    std::map<QString, QString> descs;
+    LocaleTable<QString> names;
+    LocaleTable<QString> descs;
     QString internalName;
     QString mapDescriptorFilePath;
-    std::map<QString, std::vector<QString>> districtNames;
+    LocaleTable<std::vector<QString>> districtNames;
     std::vector<quint32> districtNameIds;
     std::map<QString, QSharedPointer<Mutator>> mutators;
     std::vector<QString> authors;
     /**
      * shopNames[locale][shopModel - 1] == shopName
      */
-    std::map<QString, std::vector<QString>> shopNames;
+    LocaleTable<std::vector<QString>> shopNames;
     quint32 shopNameStartId;
 
     PyObjCopyWrapper<pybind11::dict> extraData;
@@ -4,21 +4,18 @@
 #include "lib/datafileset.h"
 #include "lib/exewrapper.h"
 
-static QString getFileCopy(const QString &fileName, const QDir &dir) {
-    // copy the file to dir
-    QFileInfo fileInfo(fileName);
-    auto fileFrom = fileName;
-    auto fileTo = dir.filePath(fileInfo.fileName());
-    if(QFile::exists(fileTo))
-        return fileTo;
-    if(!QFile::copy(fileFrom, fileTo))
-        throw ModException(QString("Could not copy file %1 to %2").arg(fileFrom, fileTo));
-    QFile file(fileTo);
-    // if the file is not writable or readable, set the permissions
-    if(!file.isWritable() || !file.isReadable()) {
-        file.setPermissions(QFile::WriteUser | QFile::ReadUser);
+/**
+ * @brief Encodes the icons in parallel.
+ * @param tplToPng a mapping from the tpl path relative to the extracted arc directory to the source png
+ */
+static void convertIcons(const QMap<QString, QString> &tplToPng, const QString &tmpDir) {
+    QVector<QFuture<QString>> conversions;
+    for (auto it = tplToPng.begin(); it != tplToPng.end(); ++it) {
+        conversions.append(ExeWrapper::convertPngToTpl(it.value(), QDir(tmpDir).filePath(it.key())));
+    }
+    for (auto &conversion: conversions) {
+        await(conversion);
     }
-    return fileTo;
 }
 
 QMap<QString, ArcFileInterface::ModifyArcFunction> DefaultMinimapIcons::modifyArcFile()
@@ -32,43 +29,30 @@ QMap<QString, ArcFileInterface::ModifyArcFunction> DefaultMinimapIcons::modifyAr
             langDir = QString("lang%1/").arg(uppercasedLocale);
         }
 
-        auto minimapTemp = QSharedPointer<QTemporaryDir>::create();
-        if (!minimapTemp->isValid()) {
-            throw ModException(QString("could not create temporary directory %1").arg(minimapTemp->path()));
-        }
-
-        auto icon2 = getFileCopy(QString(":/files/minimap/%1ui_minimap_icon2_ja.png").arg(langDir), minimapTemp->path());
-        auto icon2_w = getFileCopy(QString(":/files/minimap/%1ui_minimap_icon2_w_ja.png").arg(langDir), minimapTemp->path());
-        auto icon = getFileCopy(QString(":/files/minimap/%1ui_minimap_icon_ja.png").arg(langDir), minimapTemp->path());
-        auto icon_w = getFileCopy(QString(":/files/minimap/%1ui_minimap_icon_w_ja.png").arg(langDir), minimapTemp->path());
-        auto mark_eventsquare = getFileCopy(QString(":/files/ui_mark_eventsquare.png"), minimapTemp->path());
+        // the encoder reads the pngs straight from the resources
+        auto icon2 = QString(":/files/minimap/%1ui_minimap_icon2_ja.png").arg(langDir);
+        auto icon2_w = QString(":/files/minimap/%1ui_minimap_icon2_w_ja.png").arg(langDir);
+        auto icon = QString(":/files/minimap/%1ui_minimap_icon_ja.png").arg(langDir);
+        auto icon_w = QString(":/files/minimap/%1ui_minimap_icon_w_ja.png").arg(langDir);
+        auto mark_eventsquare = QString(":/files/ui_mark_eventsquare.png");
 
         result[gameSequenceArc(locale)] = [=](const QString &, GameInstance *, const ModListType &, const QString &tmpDir) {
-            (void)minimapTemp; // keep alive
-
-            QFile::remove(QDir(tmpDir).filePath("arc/timg/ui_minimap_icon2_ja.tpl"));
-            await(ExeWrapper::convertPngToTpl(icon2, QDir(tmpDir).filePath("arc/timg/ui_minimap_icon2_ja.tpl")));
-            QFile::remove(QDir(tmpDir).filePath("arc/timg/ui_minimap_icon2_w_ja.tpl"));
-            await(ExeWrapper::convertPngToTpl(icon2_w, QDir(tmpDir).filePath("arc/timg/ui_minimap_icon2_w_ja.tpl")));
-            QFile::remove(QDir(tmpDir).filePath("arc/timg/ui_minimap_icon_ja.tpl"));
-            await(ExeWrapper::convertPngToTpl(icon, QDir(tmpDir).filePath("arc/timg/ui_minimap_icon_ja.tpl")));
-            QFile::remove(QDir(tmpDir).filePath("arc/timg/ui_minimap_icon_w_ja.tpl"));
-            await(ExeWrapper::convertPngToTpl(icon_w, QDir(tmpDir).filePath("arc/timg/ui_minimap_icon_w_ja.tpl")));
+            convertIcons({
+                {"arc/timg/ui_minimap_icon2_ja.tpl", icon2},
+                {"arc/timg/ui_minimap_icon2_w_ja.tpl", icon2_w},
+                {"arc/timg/ui_minimap_icon_ja.tpl", icon},
+                {"arc/timg/ui_minimap_icon_w_ja.tpl", icon_w},
+            }, tmpDir);
         };
 
         result[gameBoardArc(locale)] = [=](const QString &, GameInstance *, const ModListType &, const QString &tmpDir) {
-            (void)minimapTemp; // keep alive
-
-            QFile::remove(QDir(tmpDir).filePath("arc/timg/ui_minimap_icon2_ja.tpl"));
-            await(ExeWrapper::convertPngToTpl(icon2, QDir(tmpDir).filePath("arc/timg/ui_minimap_icon2_ja.tpl")));
-            QFile::remove(QDir(tmpDir).filePath("arc/timg/ui_minimap_icon2_w_ja.tpl"));
-            await(ExeWrapper::convertPngToTpl(icon2_w, QDir(tmpDir).filePath("arc/timg/ui_minimap_icon2_w_ja.tpl")));
-            QFile::remove(QDir(tmpDir).filePath("arc/timg/ui_minimap_icon_ja.tpl"));
-            await(ExeWrapper::convertPngToTpl(icon, QDir(tmpDir).filePath("arc/timg/ui_minimap_icon_ja.tpl")));
-            QFile::remove(QDir(tmpDir).filePath("arc/timg/ui_minimap_icon_w_ja.tpl"));
-            await(ExeWrapper::convertPngToTpl(icon_w, QDir(tmpDir).filePath("arc/timg/ui_minimap_icon_w_ja.tpl")));
-            QFile::remove(QDir(tmpDir).filePath("arc/timg/ui_mark_eventsquare.tpl"));
-            await(ExeWrapper::convertPngToTpl(mark_eventsquare, QDir(tmpDir).filePath("arc/timg/ui_mark_eventsquare.tpl")));
+            convertIcons({
+                {"arc/timg/ui_minimap_icon2_ja.tpl", icon2},
+                {"arc/timg/ui_minimap_icon2_w_ja.tpl", icon2_w},
+                {"arc/timg/ui_minimap_icon_ja.tpl", icon},
+                {"arc/timg/ui_minimap_icon_w_ja.tpl", icon_w},
+                {"arc/timg/ui_mark_eventsquare.tpl", mark_eventsquare},
+            }, tmpDir);
         };
     }
     return result;
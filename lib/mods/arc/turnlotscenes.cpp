@@ -24,8 +24,9 @@ void TurnlotScenes::saveFiles(const QString &root, GameInstance *gameInstance, c
         return;
     }
 
+    // convert turnlot images; the CMPR encodes run in parallel
+    QVector<QFuture<QString>> conversions;
     for (auto &background : uniqueNonVanillaBackgrounds) {
-        // convert turnlot images
         for(char extChr='a'; extChr <= 'c'; ++extChr)
         {
             QString turnlotPngPath = QDir(gameInstance->getImportDir()).filePath(turnlotPng(extChr, background));
@@ -37,12 +38,22 @@ void TurnlotScenes::saveFiles(const QString &root, GameInstance *gameInstance, c
             }
             if (turnlotPngInfo.exists() && turnlotPngInfo.isFile()) {
                 QFile(turnlotTplPath).remove();
-                await(ExeWrapper::convertPngToTpl(turnlotPngPath, turnlotTplPath, "CMPR"));
+                conversions.append(ExeWrapper::convertPngToTpl(turnlotPngPath, turnlotTplPath, "CMPR"));
             }
         }
     }
+    for (auto &conversion : conversions) {
+        await(conversion);
+    }
 
+    ExeWrapper::SzsBatch batch;
+    QVector<QFuture<void>> packs;
     for (auto &background : uniqueNonVanillaBackgrounds) {
-        await(ExeWrapper::packTurnlotFolderToArc(QDir(root).filePath(turnlotArcDir(background)), QDir(root).filePath(turnlotArc(background))));
+        // game_turnlot_<background> -> game_turnlot_<background>.arc
+        packs.append(batch.pack(root, turnlotArcDir(background), root, ".arc", ExeWrapper::TURNLOT_ARC_OPTIONS));
+    }
+    batch.run();
+    for (auto &pack : packs) {
+        await(pack);
     }
 }
@@ -2,6 +2,7 @@
 #define CSMMMOD_H
 
 #include <QtConcurrent>
+#include "lib/brres.h"
 #include "lib/gameinstance.h"
 #include "lib/uimessage.h"
 #include "lib/python/pythonbindings.h"
@@ -31,11 +32,25 @@ public:
     typedef std::function<void(const QString &, GameInstance *, const ModListType &, const QString &)> ModifyBrresFunction;
 
     /**
-     * @brief Used to modify .brres files on save.
+     * @brief Used to modify .brres files on save. The directory holds the sub-files of the in-memory archive (see
+     * modifyBrresArchive), which are read back afterwards; only if sub-files are added or removed is the .brres file
+     * packed from the directory with wszst, after which it can no longer be modified through modifyBrresArchive.
      * @return a mapping from the .brres file path relative to the game root to the function used to modify the .brres
      */
     virtual QMap<QString, ModifyBrresFunction> modifyBrresFile() { return {}; };
 
+    /**
+     * @brief Typedef for functions that modify the sub-files of .brres files in memory; takes the archive as the last argument.
+     */
+    typedef std::function<void(const QString &, GameInstance *, const ModListType &, Brres::Archive *)> ModifyBrresArchiveFunction;
+
+    /**
+     * @brief Used to modify .brres files on save without extracting them to a directory.
+     * A .brres file can be modified by both modifyBrresFile and modifyBrresArchive.
+     * @return a mapping from the .brres file path relative to the game root to the function used to modify the .brres
+     */
+    virtual QMap<QString, ModifyBrresArchiveFunction> modifyBrresArchive() { return {}; };
+
     virtual ~BrresFileInterface() {}
 };
 
@@ -57,6 +72,13 @@ public:
      */
     virtual void saveFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) {};
 
+    /**
+     * @brief Declares the existing game files that loadFiles/saveFiles read or modify, so that CSMM only needs
+     * to extract those files from a disc image. Mods that only create new files do not need to declare anything.
+     * @return paths relative to the game root; wildcards are allowed, and a lone wildcard stands for the whole game
+     */
+    virtual QSet<QString> fileDependencies() { return {}; }
+
     virtual ~GeneralInterface() {}
 };
 
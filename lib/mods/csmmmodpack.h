@@ -3,11 +3,14 @@
 
 #include "csmmmod.h"
 #include "lib/await.h"
+#include "lib/cancellation.h"
 #include "lib/exewrapper.h"
+#include "lib/filecopy.h"
 #include "lib/mods/csmmmod.h"
 #include "lib/python/pythonbindings.h"
 #include "lib/importexportutils.h"
 #include "lib/datafileset.h"
+#include "lib/tracing.h"
 #include "lib/importexportutils.h"
 
 class CSMMModpack {
@@ -77,7 +80,50 @@ public:
         }
     }
 
+    /**
+     * @return the existing game files (relative to the game root, wildcards allowed) which loading and saving with
+     * the given mods needs, e.g. for extracting only those files from a disc image
+     */
+    template<class InputIterator>
+    static QSet<QString> fileDependencies(InputIterator modsStart, InputIterator modsEnd) {
+        // main.dol and Itast.brsar are always backed up on save, and the CSMM version is written on save
+        QSet<QString> result{MAIN_DOL, ITAST_BRSAR, CSMM_VERSION_FILE};
+        for (auto it = modsStart; it != modsEnd; ++it) {
+            CSMMModHolder mod = *it;
+            auto generalInterface = mod.getCapability<GeneralInterface>();
+            if (generalInterface) {
+                result += generalInterface->fileDependencies();
+            }
+            auto uiMessageInterface = mod.getCapability<UiMessageInterface>();
+            if (uiMessageInterface) {
+                for (auto &messageFile: uiMessageInterface->loadUiMessages().keys()) {
+                    result.insert(messageFile);
+                }
+                for (auto &messageFile: uiMessageInterface->saveUiMessages().keys()) {
+                    result.insert(messageFile);
+                }
+            }
+            auto arcFileInterface = mod.getCapability<ArcFileInterface>();
+            if (arcFileInterface) {
+                for (auto &arcFile: arcFileInterface->modifyArcFile().keys()) {
+                    result.insert(arcFile);
+                }
+            }
+            auto brresFileInterface = mod.getCapability<BrresFileInterface>();
+            if (brresFileInterface) {
+                for (auto &brresFile: brresFileInterface->modifyBrresFile().keys()) {
+                    result.insert(brresFile);
+                }
+                for (auto &brresFile: brresFileInterface->modifyBrresArchive().keys()) {
+                    result.insert(brresFile);
+                }
+            }
+        }
+        return result;
+    }
+
     void load(const QString &root) {
+        Tracing::Span loadSpan("modpack", "load");
         QHash<QString, UiMessage> messageFiles;
         QHash<QString, QMap<QString, UiMessageInterface::LoadMessagesFunction>> modToLoaders;
 
@@ -101,7 +147,9 @@ public:
         }
 
         for (auto &mod: modList) {
+            Cancellation::checkpoint();
             qDebug() << "loading mod" << mod->modId();
+            Tracing::Span modSpan("mod", "load " + mod->modId());
 
             auto generalFileInterface = mod.getCapability<GeneralInterface>();
             if (generalFileInterface) {
@@ -193,7 +241,7 @@ public:
                 itastBrsarFile.rename(itastBrsarTempStr);
                 // restore the Itast.brsar.csmm.bak -> Itast.brsar
                 qInfo() << "Restoring the Itast.brsar from Itast.brsar.csmm.bak to use as base for the patching process";
-                itastBrsarCsmmFile.copy(itastBrsarStr);
+                FileCopy::copyFile(itastBrsarCsmmStr, itastBrsarStr);
             }
             if(mainDolVanillaInfo.exists()) {
                 qInfo() << "Restoring the original main.dol from main.dol.orig.bak to use as base for the patching process";
@@ -201,12 +249,12 @@ public:
                 //   (main.dol -> main.dol.temp.bak)
                 //   (main.dol.orig.bak -> main.dol)
                 mainDolFile.rename(mainDolTempStr);
-                mainDolVanillaFile.copy(mainDolStr);
+                FileCopy::copyFile(mainDolVanillaStr, mainDolStr);
             } else {
                 qInfo() << "Backing up the original main.dol to main.dol.orig.bak";
                 // backup the original main.dol
                 //  (main.dol -> main.dol.orig.bak)
-                mainDolFile.copy(mainDolVanillaStr);
+                FileCopy::copyFile(mainDolStr, mainDolVanillaStr);
             }
         } else {
             qInfo() << "Making backup of CSMM modified main.dol to main.dol.csmm.bak";
@@ -214,14 +262,14 @@ public:
             //  (main.dol -> main.dol.csmm.bak)
             if(mainDolCsmmInfo.exists())
                 mainDolCsmmFile.remove();
-            mainDolFile.copy(mainDolCsmmStr);
+            FileCopy::copyFile(mainDolStr, mainDolCsmmStr);
 
             qInfo() << "Making backup of CSMM modified Itast.brsar to Itast.brsar.csmm.bak";
             // backup the csmm modified Itast.brsar
             //  (Itast.brsar -> Itast.brsar.csmm.bak)
             if(itastBrsarCsmmInfo.exists())
                 itastBrsarCsmmFile.remove();
-            itastBrsarFile.copy(itastBrsarCsmmStr);
+            FileCopy::copyFile(itastBrsarStr, itastBrsarCsmmStr);
 
             // apply the saved main.dol changes that happened since last time CSMM touched it
             //   (bspatch main.dol)
@@ -252,14 +300,18 @@ public:
     }
 
     void save(const QString &root, const std::function<void(double)> &progressCallback = [](double) {}) {
+        Tracing::Span saveSpan("modpack", "save");
         QHash<QString, QMap<QString, UiMessageInterface::SaveMessagesFunction>> messageSavers;
         QHash<QString, QMap<QString, ArcFileInterface::ModifyArcFunction>> arcModifiers;
         QHash<QString, QMap<QString, BrresFileInterface::ModifyBrresFunction>> brresModifiers;
+        QHash<QString, QMap<QString, BrresFileInterface::ModifyBrresArchiveFunction>> brresArchiveModifiers;
         QMap<QString, UiMessage> messageFiles;
         QTemporaryDir arcFilesDir;
         QSet<QString> arcFiles;
         QTemporaryDir brresFilesDir;
-        QSet<QString> brresFiles;
+        QMap<QString, Brres::Archive> brresArchives;
+        // the .brres files whose sub-files a modifier added or removed, which are packed from brresFilesDir with wszst
+        QSet<QString> brresDirectories;
         if (!arcFilesDir.isValid()) {
             throw ModException(QString("error creating temporary directory: %1").arg(arcFilesDir.errorString()));
         }
@@ -268,7 +320,6 @@ public:
         }
 
         backupAndRestore(arcFilesDir, root, false);
-        backupAndRestore(brresFilesDir, root, false);
 
         if(ImportExportUtils::isMainDolVanilla(QDir(root))) {
             qInfo() << "Detected vanilla main.dol";
@@ -303,11 +354,21 @@ public:
             }
             auto brresFileInterface = mod.getCapability<BrresFileInterface>();
             if (brresFileInterface) {
+                // the modifiers of extracted directories work on the sub-files of the in-memory archive as well
                 auto modBrresModifiers = brresFileInterface->modifyBrresFile();
                 for (auto it=modBrresModifiers.begin(); it!=modBrresModifiers.end(); ++it) {
-                    brresFiles.insert(it.key());
+                    if (!brresArchives.contains(it.key())) {
+                        brresArchives.insert(it.key(), Brres::Archive::fromFile(QDir(root).filePath(it.key())));
+                    }
                 }
                 brresModifiers[mod->modId()] = std::move(modBrresModifiers);
+                auto modBrresArchiveModifiers = brresFileInterface->modifyBrresArchive();
+                for (auto it=modBrresArchiveModifiers.begin(); it!=modBrresArchiveModifiers.end(); ++it) {
+                    if (!brresArchives.contains(it.key())) {
+                        brresArchives.insert(it.key(), Brres::Archive::fromFile(QDir(root).filePath(it.key())));
+                    }
+                }
+                brresArchiveModifiers[mod->modId()] = std::move(modBrresArchiveModifiers);
             }
         }
 
@@ -320,26 +381,28 @@ public:
         }
 
         {
-            int i=0;
+            // extract all files with as few wszst invocations as possible
+            Tracing::Span extractSpan("modpack", "extract arc files");
+            extractSpan.arg("files", arcFiles.size());
+            ExeWrapper::SzsBatch batch;
+            QVector<QFuture<void>> extractions;
             for (auto &arcFile: arcFiles) {
                 qInfo() << "extracting arc file" << arcFile;
-                progressCallback((double)i / arcFiles.size() / 3);
-                QDir(arcFilesDir.path()).mkpath(arcFile);
-                await(ExeWrapper::extractArcFile(QDir(root).filePath(arcFile), arcFilesDir.filePath(arcFile)));
-                ++i;
-            }
-            for (auto &brresFile: brresFiles) {
-                qInfo() << "extracting brres file" << brresFile;
-                progressCallback((double)i / brresFiles.size() / 3);
-                QDir(brresFilesDir.path()).mkpath(brresFile);
-                await(ExeWrapper::extractBrresFile(QDir(root).filePath(brresFile), brresFilesDir.filePath(brresFile)));
-                ++i;
+                extractions.append(batch.extract(root, arcFile, arcFilesDir.path()));
+            }
+            batch.run();
+            for (int i=0; i<extractions.size(); ++i) {
+                Cancellation::checkpoint();
+                progressCallback((double)i / extractions.size() / 3);
+                await(extractions[i]);
             }
         }
 
         for (int i=0; i<modList.size(); ++i) {
+            Cancellation::checkpoint();
             auto &mod = modList[i];
             qInfo() << "saving mod" << mod->modId();
+            Tracing::Span modSpan("mod", "save " + mod->modId());
 
             auto remFreeSpaceModStart = gameInstance.get().freeSpaceManager().calculateTotalRemainingFreeSpace();
 
@@ -373,17 +436,38 @@ public:
                 qInfo() << "saving brres files for" << mod->modId();
                 auto &modifiers = brresModifiers[mod->modId()];
                 for (auto it=modifiers.begin(); it!=modifiers.end(); ++it) {
-                    it.value()(root, &gameInstance.get(), modList, brresFilesDir.filePath(it.key()));
+                    auto brresDir = brresFilesDir.filePath(it.key());
+                    auto &archive = brresArchives.find(it.key()).value();
+                    if (!brresDirectories.contains(it.key())) {
+                        QDir(brresDir).removeRecursively();
+                        archive.extractTo(brresDir);
+                    }
+                    it.value()(root, &gameInstance.get(), modList, brresDir);
+                    if (!brresDirectories.contains(it.key()) && !archive.updateFrom(brresDir)) {
+                        qInfo() << "packing brres file" << it.key() << "with wszst as its sub-files were added or removed";
+                        brresDirectories.insert(it.key());
+                    }
+                }
+            }
+            if (brresArchiveModifiers.contains(mod->modId())) {
+                qInfo() << "modifying brres archives for" << mod->modId();
+                auto &modifiers = brresArchiveModifiers[mod->modId()];
+                for (auto it=modifiers.begin(); it!=modifiers.end(); ++it) {
+                    if (brresDirectories.contains(it.key())) {
+                        throw ModException(QString("%1 cannot be modified in memory after sub-files were added or removed").arg(it.key()));
+                    }
+                    it.value()(root, &gameInstance.get(), modList, &brresArchives.find(it.key()).value());
                 }
             }
 
             auto remFreeSpaceModEnd = gameInstance.get().freeSpaceManager().calculateTotalRemainingFreeSpace();
 
             qDebug() << "Free space usage for mod" << mod->modId() << ":" << (remFreeSpaceModStart - remFreeSpaceModEnd);
+            modSpan.arg("freeSpaceUsed", remFreeSpaceModStart - remFreeSpaceModEnd);
         }
 
+        // backupAndRestore must run exactly once per save, otherwise the user's main.dol changes are re-applied twice
         backupAndRestore(arcFilesDir, root, true);
-        backupAndRestore(brresFilesDir, root, true);
 
         for (auto it=messageFiles.begin(); it!=messageFiles.end(); ++it) {
             QFile file(QDir(root).filePath(it.key()));
@@ -394,18 +478,29 @@ public:
         }
 
         {
-            int i = 0;
+            Tracing::Span packSpan("modpack", "pack arc and brres files");
+            packSpan.arg("files", arcFiles.size() + brresArchives.size());
+            ExeWrapper::SzsBatch batch;
+            QVector<QFuture<void>> packs;
             for (auto &arcFile: arcFiles) {
                 qInfo() << "saving arc file" << arcFile;
-                progressCallback((2 + (double)i / arcFiles.size()) / 3);
-                await(ExeWrapper::packDfolderToArc(arcFilesDir.filePath(arcFile), QDir(root).filePath(arcFile)));
-                ++i;
+                packs.append(batch.pack(arcFilesDir.path(), arcFile, root));
             }
-            for (auto &brresFile: brresFiles) {
+            for (auto &brresFile: brresDirectories) {
                 qInfo() << "saving brres file" << brresFile;
-                progressCallback((2 + (double)i / brresFiles.size()) / 3);
-                await(ExeWrapper::packDfolderToBrres(brresFilesDir.filePath(brresFile), QDir(root).filePath(brresFile)));
-                ++i;
+                packs.append(batch.pack(brresFilesDir.path(), brresFile, root));
+            }
+            batch.run();
+            for (int i=0; i<packs.size(); ++i) {
+                Cancellation::checkpoint();
+                progressCallback((2 + (double)i / packs.size()) / 3);
+                await(packs[i]);
+            }
+            for (auto it=brresArchives.begin(); it!=brresArchives.end(); ++it) {
+                if (!brresDirectories.contains(it.key()) && it->isModified()) {
+                    qInfo() << "saving brres file" << it.key();
+                    it->toFile(QDir(root).filePath(it.key()));
+                }
             }
         }
 
@@ -89,10 +89,11 @@ QMap<QString, UiMessageInterface::LoadMessagesFunction> CustomShopNames::loadUiM
     QMap<QString, UiMessageInterface::LoadMessagesFunction> result;
     for (auto &locale : FS_LOCALES) {
         if (locale == "uk") continue;
+        auto fsLocale = *toFsLocale(locale);
         result[uiMessageCsv(locale)] = [=](const QString &, GameInstance *gameInstance,
                 const ModListType &, const UiMessage *messages) {
             for (auto &descriptor: gameInstance->mapDescriptors()) {
-                auto &shopNames = descriptor.shopNames[locale];
+                auto &shopNames = descriptor.shopNames[fsLocale];
                 shopNames.clear();
                 for (int i=0; i<100; i++) {
                     shopNames.push_back((*messages).at(descriptor.shopNameStartId+i));
@@ -106,7 +107,7 @@ QMap<QString, UiMessageInterface::LoadMessagesFunction> CustomShopNames::loadUiM
 void CustomShopNames::allocateUiMessages(const QString &root, GameInstance *gameInstance, const ModListType &modList)
 {
     // reuse shop name start id if they are all equivalent in all languages
-    std::map< std::map<QString, std::vector<QString>> , int> uiMessageIdReuse;
+    std::map<LocaleTable<std::vector<QString>>, int> uiMessageIdReuse;
     for (auto &descriptor : gameInstance->mapDescriptors()) {
         // Check if the shopNames are already in the uiMessageIdReuse map
         auto it = uiMessageIdReuse.find(descriptor.shopNames);
@@ -130,9 +131,9 @@ QMap<QString, UiMessageInterface::SaveMessagesFunction> CustomShopNames::saveUiM
 {
     QMap<QString, UiMessageInterface::SaveMessagesFunction> result;
     for (auto &locale : FS_LOCALES) {
+        auto theLocale = locale == "uk" ? LocaleEn : *toFsLocale(locale);
         result[uiMessageCsv(locale)] = [=](const QString &, GameInstance *gameInstance,
                 const ModListType &, UiMessage *messages) {
-            auto theLocale = locale == "uk" ? "en" : locale;
             for (auto &descriptor: gameInstance->mapDescriptors()) {
                 auto &shopNames = retrieveStr(descriptor.shopNames, theLocale);
                 for (int i=0; i<100; ++i) {
@@ -169,9 +170,14 @@ void CustomShopNames::loadFiles(const QString &root, GameInstance *gameInstance,
 void CustomShopNames::saveFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList)
 {
     DolIOTable::saveFiles(root, gameInstance, modList);
-    QFile addrFile(QDir(root).filePath(tableAddrFileName()));
+    QSaveFile addrFile(QDir(root).filePath(tableAddrFileName()));
     if (addrFile.open(QFile::WriteOnly)) {
         QDataStream stream(&addrFile);
         stream << tableAddr;
+        addrFile.commit();
     }
 }
+
+QSet<QString> CustomShopNames::fileDependencies() {
+    return DolIOTable::fileDependencies() + QSet<QString>{tableAddrFileName()};
+}
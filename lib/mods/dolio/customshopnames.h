@@ -15,6 +15,7 @@ public:
     QMap<QString, SaveMessagesFunction> saveUiMessages() override;
     void loadFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) override;
     void saveFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) override;
+    QSet<QString> fileDependencies() override;
 protected:
     void writeAsm(QDataStream &stream, const AddressMapper &addressMapper, const std::vector<MapDescriptor> &mapDescriptors) override;
     void readAsm(QDataStream &stream, std::vector<MapDescriptor> &mapDescriptors, const AddressMapper &addressMapper, bool isVanilla) override;
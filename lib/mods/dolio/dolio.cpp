@@ -25,6 +25,10 @@ void DolIO::saveFiles(const QString &root, GameInstance *gameInstance, const Mod
     modListPtr = nullptr;
 }
 
+QSet<QString> DolIO::fileDependencies() {
+    return {MAIN_DOL};
+}
+
 quint32 DolIO::allocate(const QByteArray &data, const QString &purpose, bool reuse) {
     return fsmPtr->allocateUnusedSpace(data, *streamPtr, *mapperPtr, purpose, reuse);
 }
@@ -13,6 +13,7 @@ class DolIO : public virtual CSMMMod, public virtual GeneralInterface {
 public:
     void loadFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) override;
     void saveFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) override;
+    QSet<QString> fileDependencies() override;
     void write(QDataStream &stream, const AddressMapper &addressMapper, const std::vector<MapDescriptor> &mapDescriptors, FreeSpaceManager &freeSpaceManager);
     virtual void readAsm(QDataStream &stream, const AddressMapper &addressMapper, std::vector<MapDescriptor> &mapDescriptors) = 0;
     virtual ~DolIO();
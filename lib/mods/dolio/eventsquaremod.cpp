@@ -491,3 +491,7 @@ void EventSquareMod::saveFiles(const QString &root, GameInstance *gameInstance,
         addrFile.commit();
     }
 }
+
+QSet<QString> EventSquareMod::fileDependencies() {
+    return DolIO::fileDependencies() + QSet<QString>{FORCE_VENTURE_CARD_ADDRESS_FILE.data()};
+}
@@ -15,6 +15,7 @@ public:
     QMap<QString, SaveMessagesFunction> saveUiMessages() override;
     void loadFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) override;
     void saveFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) override;
+    QSet<QString> fileDependencies() override;
     void readAsm(QDataStream &stream, const AddressMapper &addressMapper, std::vector<MapDescriptor> &mapDescriptors) override;
     quint32 forceVentureCardVariable;
 protected:
@@ -20,6 +20,10 @@ void ForceSimulatedButtonPress::saveFiles(const QString &root, GameInstance *gam
     }
 }
 
+QSet<QString> ForceSimulatedButtonPress::fileDependencies() {
+    return DolIO::fileDependencies() + QSet<QString>{ADDRESS_FILE.data()};
+}
+
 void ForceSimulatedButtonPress::readAsm(QDataStream &, const AddressMapper &, std::vector<MapDescriptor> &) {}
 
 void ForceSimulatedButtonPress::writeAsm(QDataStream &stream, const AddressMapper &addressMapper, const std::vector<MapDescriptor> &) {
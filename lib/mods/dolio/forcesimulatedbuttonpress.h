@@ -11,6 +11,7 @@ public:
     QString modId() const override { return MODID.data(); }
     void loadFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) override;
     void saveFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) override;
+    QSet<QString> fileDependencies() override;
     void readAsm(QDataStream &stream, const AddressMapper &addressMapper, std::vector<MapDescriptor> &mapDescriptors) override;
 protected:
     void writeAsm(QDataStream &stream, const AddressMapper &addressMapper, const std::vector<MapDescriptor> &mapDescriptors) override;
@@ -44,6 +44,10 @@ void InternalNameTable::saveFiles(const QString &root, GameInstance *gameInstanc
     }
 }
 
+QSet<QString> InternalNameTable::fileDependencies() {
+    return DolIOTable::fileDependencies() + QSet<QString>{ADDRESS_FILE.data(), NAME_LIST.data()};
+}
+
 quint32 InternalNameTable::writeTable(const std::vector<MapDescriptor> &descriptors) {
     QVector<quint32> table;
     for (auto &descriptor: descriptors) table.append(allocate(descriptor.internalName));
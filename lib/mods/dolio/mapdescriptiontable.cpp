@@ -71,9 +71,10 @@ QMap<QString, UiMessageInterface::LoadMessagesFunction> MapDescriptionTable::loa
     QMap<QString, UiMessageInterface::LoadMessagesFunction> result;
     for (auto &locale: FS_LOCALES) {
         if (locale == "uk") continue;
-        result[uiMessageCsv(locale)] = [&](const QString &, GameInstance *instance, const ModListType &, const UiMessage *messages) {
+        auto fsLocale = *toFsLocale(locale);
+        result[uiMessageCsv(locale)] = [fsLocale](const QString &, GameInstance *instance, const ModListType &, const UiMessage *messages) {
             for (auto &descriptor: instance->mapDescriptors()) {
-                descriptor.descs[locale] = messages->at(descriptor.descMsgId);
+                descriptor.descs[fsLocale] = messages->at(descriptor.descMsgId);
             }
         };
     }
@@ -89,8 +90,8 @@ void MapDescriptionTable::allocateUiMessages(const QString &, GameInstance *game
 QMap<QString, UiMessageInterface::SaveMessagesFunction> MapDescriptionTable::saveUiMessages() {
     QMap<QString, UiMessageInterface::SaveMessagesFunction> result;
     for (auto &locale: FS_LOCALES) {
-        result[uiMessageCsv(locale)] = [&](const QString &, GameInstance *instance, const ModListType &, UiMessage *messages) {
-            QString theLocale = locale == "uk" ? "en" : locale;
+        auto theLocale = locale == "uk" ? LocaleEn : *toFsLocale(locale);
+        result[uiMessageCsv(locale)] = [this, theLocale](const QString &, GameInstance *instance, const ModListType &, UiMessage *messages) {
             bool addAuthorToDesc = true;
             if (!modpackDir().isEmpty()) {
                 auto cfg = QDir(modpackDir()).filePath("mapDescriptionTable.yaml");
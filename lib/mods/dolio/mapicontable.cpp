@@ -304,17 +304,24 @@ QMap<QString, ArcFileInterface::ModifyArcFunction> MapIconTable::modifyArcFile()
                 }
             }
 
+            QVector<QFuture<QString>> conversions;
+            QSet<QString> convertedIcons;
             for (auto &mapDescriptor: gameInstance->mapDescriptors()) {
-                if (mapDescriptor.mapIcon.isEmpty() || VanillaDatabase::hasVanillaTpl(mapDescriptor.mapIcon)) {
+                if (mapDescriptor.mapIcon.isEmpty() || VanillaDatabase::hasVanillaTpl(mapDescriptor.mapIcon)
+                        || convertedIcons.contains(mapDescriptor.mapIcon)) {
                     continue;
                 }
+                convertedIcons.insert(mapDescriptor.mapIcon);
                 QString mapIconPng = QDir(gameInstance->getImportDir()).filePath(PARAM_FOLDER + "/" + mapDescriptor.mapIcon + ".png");
                 QFileInfo mapIconPngInfo(mapIconPng);
                 if (mapIconPngInfo.exists() && mapIconPngInfo.isFile()) {
                     auto mapIconTpl = QDir(tmpDir).filePath("arc/timg/" + mapIconToTplName[mapDescriptor.mapIcon]);
-                    await(ExeWrapper::convertPngToTpl(mapIconPng, mapIconTpl));
+                    conversions.append(ExeWrapper::convertPngToTpl(mapIconPng, mapIconTpl));
                 }
             }
+            for (auto &conversion: conversions) {
+                await(conversion);
+            }
 
             // convert the brlyt files to xmlyt, inject the map icons and convert it back
             auto brlytFile = QDir(tmpDir).filePath("arc/blyt/ui_menu_19_00a.brlyt");
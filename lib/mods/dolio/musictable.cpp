@@ -262,6 +262,11 @@ void MusicTable::loadFiles(const QString &root, GameInstance *gameInstance, cons
 
 }
 
+QSet<QString> MusicTable::fileDependencies() {
+    // the sizes of the brstm files of the map descriptors are needed when saving
+    return DolIO::fileDependencies() + QSet<QString>{ITAST_BRSAR, SOUND_STREAM_FOLDER + "/*", ADDRESS_FILE.data()};
+}
+
 void MusicTable::saveFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) {
     for (auto &descriptor: gameInstance->mapDescriptors()) {
         for (auto &mapEnt: descriptor.music) {
@@ -147,6 +147,10 @@ void MutatorTable::saveFiles(const QString &root, GameInstance *gameInstance, co
     }
 }
 
+QSet<QString> MutatorTable::fileDependencies() {
+    return DolIOTable::fileDependencies() + QSet<QString>{ADDRESS_FILE.data()};
+}
+
 quint32 MutatorTable::readTableAddr(QDataStream &stream, const AddressMapper &addressMapper, bool vanilla) {
     if (vanilla) {
         return 0;
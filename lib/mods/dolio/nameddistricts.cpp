@@ -78,9 +78,11 @@ QMap<QString, UiMessageInterface::LoadMessagesFunction> NamedDistricts::loadUiMe
     QMap<QString, UiMessageInterface::LoadMessagesFunction> result;
     for (auto &locale: FS_LOCALES) {
         if (locale == "uk") continue;
-        result[uiMessageCsv(locale)] = [&](const QString &, GameInstance *instance, const ModListType &, const UiMessage *messages) {
+        auto fsLocale = *toFsLocale(locale);
+        result[uiMessageCsv(locale)] = [&locale, fsLocale](const QString &, GameInstance *instance, const ModListType &, const UiMessage *messages) {
             for (auto &descriptor: instance->mapDescriptors()) {
-                descriptor.districtNames[locale].clear();
+                auto &districtNames = descriptor.districtNames[fsLocale];
+                districtNames.clear();
                 for (int distNameId: std::as_const(descriptor.districtNameIds)) {
                     auto distName = messages->at(distNameId);
                     // add district word in front of vanilla district names
@@ -89,7 +91,7 @@ QMap<QString, UiMessageInterface::LoadMessagesFunction> NamedDistricts::loadUiMe
                         distWord.replace("\\s", " ");
                         distName = distWord + distName;
                     }
-                    descriptor.districtNames[locale].push_back(distName);
+                    districtNames.push_back(distName);
                 }
             }
         };
@@ -100,7 +102,7 @@ QMap<QString, UiMessageInterface::LoadMessagesFunction> NamedDistricts::loadUiMe
 void NamedDistricts::allocateUiMessages(const QString &, GameInstance *gameInstance, const ModListType &) {
     for (auto &descriptor: gameInstance->mapDescriptors()) {
         descriptor.districtNameIds.clear();
-        for (int i=0; i<descriptor.districtNames["en"].size(); ++i) {
+        for (int i=0; i<descriptor.districtNames[LocaleEn].size(); ++i) {
             int newId = gameInstance->nextUiMessageId();
             descriptor.districtNameIds.push_back(newId);
         }
@@ -110,11 +112,9 @@ void NamedDistricts::allocateUiMessages(const QString &, GameInstance *gameInsta
 QMap<QString, UiMessageInterface::SaveMessagesFunction> NamedDistricts::saveUiMessages() {
     QMap<QString, UiMessageInterface::SaveMessagesFunction> result;
     for (auto &locale: FS_LOCALES) {
-        result[uiMessageCsv(locale)] = [&](const QString &, GameInstance *instance, const ModListType &, UiMessage *messages) {
-                QString theLocale = locale;
-                if (locale == "uk") {
-                    theLocale = "en";
-                }
+        auto fsLocale = locale == "uk" ? LocaleEn : *toFsLocale(locale);
+        result[uiMessageCsv(locale)] = [fsLocale](const QString &, GameInstance *instance, const ModListType &, UiMessage *messages) {
+                QString theLocale = FS_LOCALES[fsLocale];
 
                 auto districtWord = VanillaDatabase::localeToDistrictWord().at(theLocale);
                 auto districtReplaceRegex = re(districtWord + "<area>");
@@ -135,11 +135,11 @@ QMap<QString, UiMessageInterface::SaveMessagesFunction> NamedDistricts::saveUiMe
                 }
 
                 for (auto &descriptor: instance->mapDescriptors()) {
+                    auto &localeNames = descriptor.districtNames[fsLocale];
+                    auto &enNames = descriptor.districtNames[LocaleEn];
                     for (int i=0; i<descriptor.districtNameIds.size(); ++i) {
                         (*messages)[descriptor.districtNameIds[i]]
-                                = (i < descriptor.districtNames[theLocale].size()
-                                   ? descriptor.districtNames[theLocale][i]
-                                     : descriptor.districtNames["en"][i]);
+                                = (i < localeNames.size() ? localeNames[i] : enNames[i]);
                     }
                 }
             };
@@ -52,9 +52,10 @@ QMap<QString, UiMessageInterface::LoadMessagesFunction> StageNameIDTable::loadUi
     QMap<QString, UiMessageInterface::LoadMessagesFunction> result;
     for (auto &locale: FS_LOCALES) {
         if (locale == "uk") continue;
-        result[uiMessageCsv(locale)] = [&](const QString &, GameInstance *instance, const ModListType &, const UiMessage *messages) {
+        auto fsLocale = *toFsLocale(locale);
+        result[uiMessageCsv(locale)] = [fsLocale](const QString &, GameInstance *instance, const ModListType &, const UiMessage *messages) {
             for (auto &descriptor: instance->mapDescriptors()) {
-                descriptor.names[locale] = messages->at(descriptor.nameMsgId);
+                descriptor.names[fsLocale] = messages->at(descriptor.nameMsgId);
             }
         };
     }
@@ -70,11 +71,8 @@ void StageNameIDTable::allocateUiMessages(const QString &, GameInstance *gameIns
 QMap<QString, UiMessageInterface::SaveMessagesFunction> StageNameIDTable::saveUiMessages() {
     QMap<QString, UiMessageInterface::SaveMessagesFunction> result;
     for (auto &locale: FS_LOCALES) {
-        result[uiMessageCsv(locale)] = [&](const QString &, GameInstance *instance, const ModListType &, UiMessage *messages) {
-            QString theLocale = locale;
-            if (locale == "uk") {
-                theLocale = "en";
-            }
+        auto theLocale = locale == "uk" ? LocaleEn : *toFsLocale(locale);
+        result[uiMessageCsv(locale)] = [theLocale](const QString &, GameInstance *instance, const ModListType &, UiMessage *messages) {
             for (auto &descriptor: instance->mapDescriptors()) {
                 (*messages)[descriptor.nameMsgId] = retrieveStr(descriptor.names, theLocale);
             }
@@ -1,23 +1,144 @@
 #include "copymapfiles.h"
+#include <QDataStream>
+#include <QDirIterator>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include "lib/cancellation.h"
 #include "lib/datafileset.h"
-#include <filesystem>
+#include "lib/filecopy.h"
+#include "lib/importexportutils.h"
+#include "lib/tracing.h"
 
-void CopyMapFiles::saveFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList)
-{
-    auto paramDir = QDir(gameInstance->getImportDir()).filePath(PARAM_FOLDER);
-    for (auto &frbFile: QDir(paramDir).entryInfoList({"*.frb"}, QDir::Files)) {
-        auto destFrbFile = QDir(root).filePath(PARAM_FOLDER + "/" + frbFile.fileName());
-        QFile::remove(destFrbFile);
-        QFile::copy(frbFile.filePath(), destFrbFile);
+static constexpr quint32 MANIFEST_MAGIC = 0x43534d4d; // "CSMM"
+static constexpr quint32 MANIFEST_VERSION = 1;
+
+namespace {
+
+/**
+ * @brief A file placed in the game directory by a previous save.
+ */
+struct PlacedFile {
+    qint64 size = 0;
+    qint64 sourceModified = 0;
+    qint64 destModified = 0;
+    // whether the file did not exist before CSMM placed it, in which case it may be removed again
+    bool owned = false;
+};
+
+QDataStream &operator<<(QDataStream &stream, const PlacedFile &file) {
+    return stream << file.size << file.sourceModified << file.destModified << file.owned;
+}
+
+QDataStream &operator>>(QDataStream &stream, PlacedFile &file) {
+    return stream >> file.size >> file.sourceModified >> file.destModified >> file.owned;
+}
+
+}
+
+static qint64 modifiedTime(const QFileInfo &fileInfo) {
+    return fileInfo.lastModified().toMSecsSinceEpoch();
+}
+
+static QHash<QString, PlacedFile> readManifest(const QString &manifestFile) {
+    QFile file(manifestFile);
+    if (!file.open(QFile::ReadOnly)) {
+        return {};
+    }
+    QDataStream stream(&file);
+    quint32 magic, version;
+    QHash<QString, PlacedFile> manifest;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != MANIFEST_MAGIC || version != MANIFEST_VERSION) {
+        return {};
+    }
+    stream >> manifest;
+    return stream.status() == QDataStream::Ok ? manifest : QHash<QString, PlacedFile>();
+}
+
+static void writeManifest(const QString &manifestFile, const QHash<QString, PlacedFile> &manifest) {
+    QSaveFile file(manifestFile);
+    if (!file.open(QFile::WriteOnly)) {
+        throw ModException("could not open " + manifestFile + " for writing");
+    }
+    QDataStream stream(&file);
+    stream << MANIFEST_MAGIC << MANIFEST_VERSION << manifest;
+    if (!file.commit()) {
+        throw ModException("could not write " + manifestFile);
+    }
+}
+
+static QStringList mapFiles(const QDir &importDir) {
+    QStringList result;
+    for (auto &frbFile: QDir(importDir.filePath(PARAM_FOLDER)).entryList({"*.frb"}, QDir::Files)) {
+        result.append(PARAM_FOLDER + "/" + frbFile);
     }
     const QStringList toCopyList{SOUND_STREAM_FOLDER, SCENE_FOLDER, "files/bg"};
     for (auto &toCopy: toCopyList) {
-        if (QFileInfo::exists(QDir(gameInstance->getImportDir()).filePath(toCopy))) {
-            std::filesystem::copy(
-                        QDir(gameInstance->getImportDir()).filePath(toCopy).toStdU16String(),
-                        QDir(root).filePath(toCopy).toStdU16String(),
-                        std::filesystem::copy_options::recursive | std::filesystem::copy_options::overwrite_existing
-                        );
+        QDirIterator it(importDir.filePath(toCopy), QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            result.append(importDir.relativeFilePath(it.next()));
+        }
+    }
+    return result;
+}
+
+void CopyMapFiles::saveFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList)
+{
+    // mirrors the map files of the import directory into the game directory: files which are unchanged since the
+    // last save are skipped, so that saving again with a large music set only compares file metadata
+    QDir importDir(gameInstance->getImportDir()), rootDir(root);
+    auto manifestFile = rootDir.filePath(MAP_FILES_MANIFEST);
+    auto previous = readManifest(manifestFile);
+    Tracing::Span span("mod", "mirror map files");
+    // in a partially extracted game directory a missing file may still be a file of the disc image which is only not
+    // extracted yet, so it must not be claimed: removing it later would remove it from the game
+    bool partial = rootDir.exists(SOURCE_IMAGE_FILE);
+
+    QHash<QString, PlacedFile> placed;
+    QStringList toCopy;
+    for (auto &relativePath: mapFiles(importDir)) {
+        QFileInfo source(importDir.filePath(relativePath)), dest(rootDir.filePath(relativePath));
+        auto it = previous.constFind(relativePath);
+        bool upToDate = false;
+        if (it != previous.constEnd() && dest.exists() && dest.size() == it->size && modifiedTime(dest) == it->destModified
+                && source.size() == it->size) {
+            // same size but a different time stamp, e.g. the map was imported again: compare the contents
+            upToDate = modifiedTime(source) == it->sourceModified
+                    || ImportExportUtils::fileSha1(source.filePath()) == ImportExportUtils::fileSha1(dest.filePath());
+        }
+        PlacedFile file;
+        if (upToDate) {
+            file = *it;
+        } else {
+            file.owned = it != previous.constEnd() ? it->owned : !partial && !dest.exists();
+            toCopy.append(relativePath);
+        }
+        file.size = source.size();
+        file.sourceModified = modifiedTime(source);
+        placed[relativePath] = file;
+    }
+    span.arg("files", placed.size());
+    span.arg("copied", toCopy.size());
+
+    for (auto &relativePath: toCopy) {
+        rootDir.mkpath(QFileInfo(relativePath).path());
+    }
+    // the pool threads run without a token of their own
+    auto token = Cancellation::current() ? *Cancellation::current() : Cancellation::Token();
+    QtConcurrent::blockingMap(toCopy, [&, token](const QString &relativePath) {
+        Cancellation::Scope scope(token);
+        Cancellation::checkpoint();
+        FileCopy::copyFile(importDir.filePath(relativePath), rootDir.filePath(relativePath));
+    });
+    for (auto &relativePath: toCopy) {
+        placed[relativePath].destModified = modifiedTime(QFileInfo(rootDir.filePath(relativePath)));
+    }
+
+    // remove the files of maps which are no longer in the map list, unless they replaced a file of the game
+    for (auto it = previous.constBegin(); it != previous.constEnd(); ++it) {
+        if (it->owned && !placed.contains(it.key())) {
+            QFile::remove(rootDir.filePath(it.key()));
         }
     }
+    writeManifest(manifestFile, placed);
 }
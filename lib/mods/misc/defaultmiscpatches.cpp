@@ -6,6 +6,20 @@ void DefaultMiscPatches::loadFiles(const QString &, GameInstance *, const ModLis
     // crab nothing to do crab
 }
 
+QSet<QString> DefaultMiscPatches::fileDependencies()
+{
+    QSet<QString> result;
+    QFile f(":/files/bspatches.yaml");
+    if (f.open(QFile::ReadOnly)) {
+        QString contents = f.readAll();
+        auto yaml = YAML::Load(contents.toStdString());
+        for (auto it=yaml.begin(); it!=yaml.end(); ++it) {
+            result.insert(QString::fromStdString(it->first.as<std::string>()));
+        }
+    }
+    return result;
+}
+
 void DefaultMiscPatches::saveFiles(const QString &root, GameInstance *, const ModListType &)
 {
     QFile f(":/files/bspatches.yaml");
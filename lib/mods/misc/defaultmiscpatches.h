@@ -10,6 +10,7 @@ public:
     QString modId() const override { return MODID.data(); }
     void loadFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) override;
     void saveFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) override;
+    QSet<QString> fileDependencies() override;
 };
 
 #endif // DEFAULTMISCPATCHES_H
@@ -2,12 +2,14 @@
 #define READFRBFILEINFO_H
 
 #include "lib/mods/csmmmod.h"
+#include "lib/datafileset.h"
 
 class ReadFrbFileInfo : public CSMMMod, public GeneralInterface
 {
     static constexpr std::string_view MODID = "readFrbFileInfo";
     void loadFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) override;
     void saveFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) override;
+    QSet<QString> fileDependencies() override { return {PARAM_FOLDER + "/*.frb"}; }
     QString modId() const override { return MODID.data(); };
     QSet<QString> after() const override { return {"frbMapTable"}; }
 };
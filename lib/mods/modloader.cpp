@@ -1,10 +1,28 @@
 #include "modloader.h"
 #include "defaultmodlist.h"
+#include "lib/importexportutils.h"
 #include "lib/python/pythonbindings.h"
 #include "lib/zip/zip.h"
+#include <QDateTime>
+#include <QLockFile>
+#include <QMutex>
+#include <QStandardPaths>
+#include <map>
+#include <memory>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/file.h>
+#endif
 
 namespace ModLoader {
 
+static constexpr int MAX_CACHED_MODPACKS = 16;
+// holds the path of the directory containing modlist.txt, relative to the cache entry
+static const QString CACHE_ENTRY_FILE = "csmm_modpack_entry.txt";
+
 static const QRegularExpression modListSplit("\\s+|\\b", QRegularExpression::UseUnicodePropertiesOption);
 
 struct ParsedModList {
@@ -131,76 +149,189 @@ static ModListType importModpackDirs(const QVector<QString> &modpackDirs) {
     return result;
 }
 
-std::pair<ModListType, std::shared_ptr<QTemporaryDir[]>> importModpackCollection(const QVector<QString> &modlistColl) {
-    if (modlistColl.isEmpty()) {
-        return std::make_pair(DefaultModList::defaultModList(), nullptr);
+static QDir modpackCacheDir() {
+    QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    if (!cacheDir.mkpath("modpacks")) {
+        throw ModException(QString("could not create the modpack cache in %1").arg(cacheDir.path()));
     }
+    return cacheDir.filePath("modpacks");
+}
 
-    std::shared_ptr<QTemporaryDir[]> tmpDirs(new QTemporaryDir[modlistColl.size()]);
-    QVector<QString> modpackDirs;
+static void markUsed(const QString &entryFilePath) {
+    QFile entryFile(entryFilePath);
+    if (entryFile.open(QFile::ReadWrite)) {
+        entryFile.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+    }
+}
 
-    for (int i=0; i<modlistColl.size(); ++i) {
-        QString extractedFile;
+/**
+ * @brief lockEntryFile Locks an open cache entry file, shared while a process uses the entry, or exclusively
+ * without waiting to check that no process uses it.
+ * @return whether the lock was acquired
+ */
+static bool lockEntryFile(QFile &entryFile, bool exclusive) {
+#ifdef Q_OS_WIN
+    OVERLAPPED overlapped = {};
+    DWORD flags = exclusive ? LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY : 0;
+    return LockFileEx((HANDLE)_get_osfhandle(entryFile.handle()), flags, 0, MAXDWORD, MAXDWORD, &overlapped);
+#else
+    return flock(entryFile.handle(), exclusive ? LOCK_EX | LOCK_NB : LOCK_SH) == 0;
+#endif
+}
 
-        if (!tmpDirs[i].isValid()) {
-            throw ModException(QString("could not create temporary directory for mod list zip %1").arg(modlistColl[i]));
+/**
+ * @brief holdEntry Takes a shared lock on a cache entry so that no CSMM process evicts it. The lock is held until
+ * this process exits, as the modules Python imported from the entry stay loaded. The cache must be locked.
+ */
+static void holdEntry(const QString &entryFilePath) {
+    static QMutex mutex;
+    static std::map<QString, std::unique_ptr<QFile>> heldEntries;
+    QMutexLocker locker(&mutex);
+    if (heldEntries.count(entryFilePath)) {
+        return;
+    }
+    auto entryFile = std::make_unique<QFile>(entryFilePath);
+    if (!entryFile->open(QFile::ReadOnly) || !lockEntryFile(*entryFile, false)) {
+        throw ModException(QString("could not lock the cached modpack %1").arg(entryFilePath));
+    }
+    heldEntries[entryFilePath] = std::move(entryFile);
+}
+
+/**
+ * @return whether a CSMM process, including this one, holds the cache entry. The cache must be locked, so that
+ * no process can take hold of the entry after checking.
+ */
+static bool isEntryHeld(const QString &entryFilePath) {
+    QFile entryFile(entryFilePath);
+    return entryFile.open(QFile::ReadOnly) && !lockEntryFile(entryFile, true);
+}
+
+/**
+ * @brief evictModpacks Removes the least recently used modpacks beyond MAX_CACHED_MODPACKS and leftovers of
+ * interrupted extractions. Modpacks held by a running CSMM process are kept. The cache must be locked.
+ */
+static void evictModpacks(const QDir &cacheDir) {
+    QVector<QPair<QDateTime, QString>> entries;
+    for (auto &entryInfo: cacheDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFileInfo entryFileInfo(QDir(entryInfo.filePath()).filePath(CACHE_ENTRY_FILE));
+        if (entryFileInfo.exists()) {
+            entries.append({entryFileInfo.lastModified(), entryInfo.filePath()});
+        } else {
+            QDir(entryInfo.filePath()).removeRecursively();
         }
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto &A, const auto &B) { return A.first > B.first; });
+    for (int i = MAX_CACHED_MODPACKS; i < entries.size(); ++i) {
+        if (isEntryHeld(QDir(entries[i].second).filePath(CACHE_ENTRY_FILE))) {
+            qDebug() << "keeping modpack" << entries[i].second << "in the cache as it is in use";
+            continue;
+        }
+        qInfo() << "removing least recently used modpack" << entries[i].second << "from the cache";
+        QDir(entries[i].second).removeRecursively();
+    }
+}
 
-        int zipResult = zip_extract(modlistColl[i].toUtf8(), tmpDirs[i].path().toUtf8(), [](const char *candidate, void *arg) {
-            QFileInfo fi(candidate);
-            QString *extractedFilePtr = (QString *)arg;
+/**
+ * @brief extractModpackZip Extracts a modpack zip into the persistent modpack cache, which is keyed by the SHA-1
+ * of the zip, unless it has been extracted before. The extracted tree is kept together with the __pycache__
+ * directories Python writes into it, so the mods are neither extracted nor compiled again. The entry is held by
+ * this process from then on.
+ * @param root if not null, set to the root of the extracted tree
+ * @return the directory containing modlist.txt
+ */
+static QString extractModpackZip(const QString &zipFile, QString *root = nullptr) {
+    auto cacheDir = modpackCacheDir();
+    QLockFile lock(cacheDir.filePath("lock"));
+    lock.setStaleLockTime(0); // extracting may take long; a lock is only stale if its process is gone
+    if (!lock.lock()) {
+        throw ModException(QString("could not lock the modpack cache in %1").arg(cacheDir.path()));
+    }
 
-            if (fi.fileName() == "modlist.txt") {
-                *extractedFilePtr = candidate;
-            }
+    auto key = ImportExportUtils::fileSha1(zipFile);
+    QDir entryDir(cacheDir.filePath(key));
+    if (root) {
+        *root = entryDir.path();
+    }
+    QFile entryFile(entryDir.filePath(CACHE_ENTRY_FILE));
+    if (entryFile.open(QFile::ReadOnly)) {
+        auto modListDir = QString::fromUtf8(entryFile.readAll());
+        entryFile.close();
+        markUsed(entryFile.fileName());
+        holdEntry(entryFile.fileName());
+        qDebug() << "using cached modpack" << entryDir.path() << "for" << zipFile;
+        return entryDir.filePath(modListDir);
+    }
+    entryDir.removeRecursively(); // incomplete entry
 
-            return 0;
-        }, &extractedFile);
-        if (zipResult < 0) {
-            throw ModException(QString("zip file %1 could not be extracted: %2").arg(modlistColl[i], zip_strerror(zipResult)));
+    // extract next to the entry so that the complete tree can be moved into place at once
+    QTemporaryDir extractDir(cacheDir.filePath(key + "-XXXXXX"));
+    if (!extractDir.isValid()) {
+        throw ModException(QString("could not create temporary directory to extract %1 to").arg(zipFile));
+    }
+    QString extractedFile;
+    int zipResult = zip_extract(zipFile.toUtf8(), extractDir.path().toUtf8(), [](const char *candidate, void *arg) {
+        QFileInfo fi(candidate);
+        QString *extractedFilePtr = (QString *)arg;
+
+        if (fi.fileName() == "modlist.txt") {
+            *extractedFilePtr = candidate;
         }
-        modpackDirs.append(QFileInfo(extractedFile).dir().path());
+
+        return 0;
+    }, &extractedFile);
+    if (zipResult < 0) {
+        throw ModException(QString("zip file %1 could not be extracted: %2").arg(zipFile, zip_strerror(zipResult)));
     }
+    auto modListDir = QDir(extractDir.path()).relativeFilePath(QFileInfo(extractedFile).dir().path());
+    QFile newEntryFile(QDir(extractDir.path()).filePath(CACHE_ENTRY_FILE));
+    if (!newEntryFile.open(QFile::WriteOnly) || newEntryFile.write(modListDir.toUtf8()) < 0) {
+        throw ModException(QString("could not write %1").arg(newEntryFile.fileName()));
+    }
+    newEntryFile.close();
+    if (!QDir().rename(extractDir.path(), entryDir.path())) {
+        throw ModException(QString("could not move %1 to %2").arg(extractDir.path(), entryDir.path()));
+    }
+    extractDir.setAutoRemove(false);
+    holdEntry(entryFile.fileName());
+
+    evictModpacks(cacheDir);
 
-    return make_pair(ModLoader::importModpackDirs(modpackDirs), tmpDirs);
+    return entryDir.filePath(modListDir);
 }
 
-std::pair<ModListType, std::shared_ptr<QTemporaryDir>> importModpackFile(const QString &file) {
-    if (file.isEmpty()) { // special case: empty string yields default modpack
-        return std::make_pair(DefaultModList::defaultModList(), nullptr);
+ModListType importModpackCollection(const QVector<QString> &modlistColl) {
+    if (modlistColl.isEmpty()) {
+        return DefaultModList::defaultModList();
     }
 
-    std::shared_ptr<QTemporaryDir> tmpDir;
-
-    QString dir;
+    QVector<QString> modpackDirs;
+    for (auto &modpackZip: modlistColl) {
+        modpackDirs.append(extractModpackZip(modpackZip));
+    }
 
-    if (QFileInfo(file).suffix() == "zip") {
-        QString extractedFile;
+    return ModLoader::importModpackDirs(modpackDirs);
+}
 
-        tmpDir = std::make_shared<QTemporaryDir>();
-        if (!tmpDir->isValid()) {
-            throw ModException(QString("could not create temporary directory to extract %1 to").arg(file));
-        }
+QString extractedModpackRoot(const QString &zipFile) {
+    QString root;
+    extractModpackZip(zipFile, &root);
+    return root;
+}
 
-        int zipResult = zip_extract(file.toUtf8(), tmpDir->path().toUtf8(), [](const char *candidate, void *arg) {
-            QFileInfo fi(candidate);
-            QString *extractedFilePtr = (QString *)arg;
+ModListType importModpackFile(const QString &file) {
+    if (file.isEmpty()) { // special case: empty string yields default modpack
+        return DefaultModList::defaultModList();
+    }
 
-            if (fi.fileName() == "modlist.txt") {
-                *extractedFilePtr = candidate;
-            }
+    QString dir;
 
-            return 0;
-        }, &extractedFile);
-        if (zipResult < 0) {
-            throw ModException(QString("zip file %1 could not be extracted: %2").arg(file, zip_strerror(zipResult)));
-        }
-        dir = QFileInfo(extractedFile).dir().path();
+    if (QFileInfo(file).suffix() == "zip") {
+        dir = extractModpackZip(file);
     } else {
         dir = QFileInfo(file).dir().path();
     }
 
-    return make_pair(ModLoader::importModpackDirs({dir}), tmpDir);
+    return ModLoader::importModpackDirs({dir});
 }
 
 }
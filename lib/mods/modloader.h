@@ -7,16 +7,23 @@
 namespace ModLoader {
 
 /**
- * Loads the mod lists in the files and aggregates them.
- * @return a pair containing (1) a list of mods and (2) temporary directories holding the modpacks if applicable
+ * Loads the mod lists in the files and aggregates them. Modpack zips are extracted into the persistent modpack cache,
+ * where their entries are kept from being evicted for as long as this process runs.
+ * @return the list of mods
  */
-std::pair<ModListType, std::shared_ptr<QTemporaryDir[]>> importModpackCollection(const QVector<QString> &modlistColl);
+ModListType importModpackCollection(const QVector<QString> &modlistColl);
 
 /**
  * Loads the mod list from the file, or the default modlist if file is an empty string.
- * @return a pair containing (1) a list of mods and (2) a temporary directory holding the modpack if applicable
+ * A modpack zip is extracted into the persistent modpack cache like in importModpackCollection.
+ * @return the list of mods
  */
-std::pair<ModListType, std::shared_ptr<QTemporaryDir>> importModpackFile(const QString &file);
+ModListType importModpackFile(const QString &file);
+
+/**
+ * @return the root of the tree the modpack zip is extracted to in the modpack cache, extracting it if needed
+ */
+QString extractedModpackRoot(const QString &zipFile);
 
 }
 
@@ -63,6 +63,69 @@ static pybind11::class_<std::array<T, N>> bindStdArray(pybind11::handle h, const
     return cls;
 }
 
+/**
+ * Binds a LocaleTable as a dict-like type keyed by the locales in FS_LOCALES.
+ */
+template<class T, class ...Args>
+static pybind11::class_<LocaleTable<T>> bindLocaleTable(pybind11::handle h, const std::string &name, Args &&...args) {
+    using Table = LocaleTable<T>;
+    auto locale = [](const QString &key) {
+        auto locale = toFsLocale(key);
+        if (!locale) throw pybind11::key_error(key.toStdString());
+        return *locale;
+    };
+    pybind11::class_<Table> cls(h, name.c_str(), std::forward<Args>(args)...);
+    cls.def(pybind11::init<>());
+    cls.def(pybind11::init([locale](const pybind11::dict &d) {
+        Table res;
+        for (auto &item: d) {
+            res[locale(item.first.cast<QString>())] = item.second.cast<T>();
+        }
+        return res;
+    }));
+    cls.def("__getitem__", [locale](Table &table, const QString &key) -> T & {
+        auto fsLocale = locale(key);
+        if (!table.count(fsLocale)) throw pybind11::key_error(key.toStdString());
+        return table.at(fsLocale);
+    }, pybind11::return_value_policy::reference_internal);
+    cls.def("__setitem__", [locale](Table &table, const QString &key, const T &value) { table[locale(key)] = value; });
+    cls.def("__delitem__", [locale](Table &table, const QString &key) {
+        if (!table.erase(locale(key))) throw pybind11::key_error(key.toStdString());
+    });
+    cls.def("__contains__", [](const Table &table, const QString &key) { return table.count(key) > 0; });
+    cls.def("__bool__", [](const Table &table) { return !table.empty(); });
+    cls.def("__len__", &Table::size);
+    cls.def("keys", [](const Table &table) {
+        pybind11::list keys;
+        for (auto it = table.begin(); it != table.end(); ++it) keys.append(it->first);
+        return keys;
+    });
+    cls.def("__iter__", [](pybind11::object self) { return self.attr("keys")().attr("__iter__")(); });
+    cls.def("values", [](pybind11::object self) {
+        auto &table = self.cast<Table &>();
+        pybind11::list values;
+        for (auto it = table.begin(); it != table.end(); ++it) {
+            values.append(pybind11::cast(&it->second, pybind11::return_value_policy::reference_internal, self));
+        }
+        return values;
+    });
+    cls.def("items", [](pybind11::object self) {
+        auto &table = self.cast<Table &>();
+        pybind11::list items;
+        for (auto it = table.begin(); it != table.end(); ++it) {
+            items.append(pybind11::make_tuple(it->first,
+                pybind11::cast(&it->second, pybind11::return_value_policy::reference_internal, self)));
+        }
+        return items;
+    });
+    cls.def("__eq__", [](const Table &a, const Table &b) { return a == b; });
+    cls.def("__ne__", [](const Table &a, const Table &b) { return a != b; });
+    cls.def("__repr__", [name](pybind11::object self) {
+        return name + "(" + pybind11::str(pybind11::dict(self.attr("items")())).cast<std::string>() + ")";
+    });
+    return cls;
+}
+
 namespace {
 
 class PyQIODevice : public QIODevice {
@@ -130,12 +193,16 @@ public:
 class PyBrresFileInterface : public BrresFileInterface {
 private:
     typedef QMap<QString, ModifyBrresFunction> ResultType;
+    typedef QMap<QString, ModifyBrresArchiveFunction> ArchiveResultType;
 public:
     using BrresFileInterface::BrresFileInterface;
 
     QMap<QString, ModifyBrresFunction> modifyBrresFile() override {
         PYBIND11_OVERRIDE(ResultType, BrresFileInterface, modifyBrresFile);
     }
+    QMap<QString, ModifyBrresArchiveFunction> modifyBrresArchive() override {
+        PYBIND11_OVERRIDE(ArchiveResultType, BrresFileInterface, modifyBrresArchive);
+    }
 };
 
 class PyGeneralInterface : public GeneralInterface {
@@ -148,6 +215,11 @@ public:
     void saveFiles(const QString &root, GameInstance *gameInstance, const ModListType &modList) override {
         PYBIND11_OVERRIDE(void, GeneralInterface, saveFiles, root, gameInstance, modList);
     }
+    QSet<QString> fileDependencies() override {
+        PYBIND11_OVERRIDE_IMPL(QSet<QString>, GeneralInterface, "fileDependencies");
+        // python mods that don't declare their file dependencies could read any file
+        return {"*"};
+    }
 };
 
 class PyUiMessageInterface : public UiMessageInterface {
@@ -172,18 +244,29 @@ public:
 
 //PYBIND11_EMBEDDED_MODULE(pycsmm, m)
 void init_pycsmm(pybind11::module_ &m) {
-    m.def("convertPngToTpl", [](const QString &src, const QString &dest) {
+    pybind11::enum_<TextureEncoder::Quality>(m, "TextureQuality", R"pycsmmdoc(
+    Enum trading speed for quality when encoding CMPR textures.
+)pycsmmdoc")
+            .value("Fast", TextureEncoder::Quality::Fast)
+            .value("Normal", TextureEncoder::Quality::Normal)
+            .value("Best", TextureEncoder::Quality::Best);
+
+    m.def("convertPngToTpl", [](const QString &src, const QString &dest, const QString &format, TextureEncoder::Quality quality) {
         pybind11::gil_scoped_release release;
-        await(ExeWrapper::convertPngToTpl(src, dest));
-    }, pybind11::arg("src"), pybind11::arg("dest"), R"pycsmmdoc(
-    Converts the png file at src to a tpl file at dest, overwriting if necessary.
+        await(ExeWrapper::convertPngToTpl(src, dest, format, quality));
+    }, pybind11::arg("src"), pybind11::arg("dest"), pybind11::arg("format") = "RGB5A3",
+          pybind11::arg("quality") = TextureEncoder::Quality::Normal, R"pycsmmdoc(
+    Converts the png file at src to a tpl file at dest, overwriting if necessary. format is a wimgt image format;
+    if it is empty, CMPR is picked for opaque images and RGB5A3 otherwise. quality is a TextureQuality.
 )pycsmmdoc");
 
-    m.def("convertPngToTex", [](const QString &src, const QString &dest) {
+    m.def("convertPngToTex", [](const QString &src, const QString &dest, const QString &format, TextureEncoder::Quality quality) {
         pybind11::gil_scoped_release release;
-        await(ExeWrapper::convertPngToTex(src, dest));
-    }, pybind11::arg("src"), pybind11::arg("dest"), R"pycsmmdoc(
-    Converts the png file at src to a tex file at dest, overwriting if necessary.
+        await(ExeWrapper::convertPngToTex(src, dest, format, quality));
+    }, pybind11::arg("src"), pybind11::arg("dest"), pybind11::arg("format") = "",
+          pybind11::arg("quality") = TextureEncoder::Quality::Normal, R"pycsmmdoc(
+    Converts the png file at src to a tex file at dest, overwriting if necessary. format is a wimgt image format;
+    CMPR is picked for opaque images and RGB5A3 otherwise if it is omitted. quality is a TextureQuality.
 )pycsmmdoc");
 
     m.attr("FS_LOCALES") = pybind11::list();
@@ -300,7 +383,7 @@ void init_pycsmm(pybind11::module_ &m) {
     An array-like type containing the three tour opponents.
 )pycsmmdoc");
 
-    pybind11::bind_map<std::map<QString, QString>>(m, "LanguageTable", R"pycsmmdoc(
+    bindLocaleTable<QString>(m, "LanguageTable", R"pycsmmdoc(
     Maps the language code to the localized name, string, etc.
 )pycsmmdoc");
 
@@ -308,7 +391,7 @@ void init_pycsmm(pybind11::module_ &m) {
     A list-like type of strings.
 )pycsmmdoc");
 
-    pybind11::bind_map<std::map<QString, std::vector<QString>>>(m, "ListLanguageTable", R"pycsmmdoc(
+    bindLocaleTable<std::vector<QString>>(m, "ListLanguageTable", R"pycsmmdoc(
     Maps the language code to a localized list of localized names, strings, etc.
 )pycsmmdoc");
 
@@ -324,6 +407,67 @@ void init_pycsmm(pybind11::module_ &m) {
     A mapping from localization ID to the localized string.
 )pycsmmdoc");
 
+    auto modListToList = [](const ModListType &modList) {
+        pybind11::list result;
+        for (auto &mod: modList) {
+            result.append(pybind11::cast(mod));
+        }
+        return result;
+    };
+    auto modListCls = pybind11::class_<ModListType>(m, "ModList", R"pycsmmdoc(
+    A read-only list-like type of the mods in load order. It is passed to mod callbacks without converting
+    every mod to a Python object first. Slicing, copy() and concatenation return ordinary lists.
+
+    A ModList is no list: isinstance(mods, list) is False, json.dumps() does not accept it and it cannot be
+    modified in place. Use list(mods) or mods.copy() where a list is needed.
+)pycsmmdoc")
+            .def("__len__", [](const ModListType &modList) { return modList.size(); })
+            .def("__bool__", [](const ModListType &modList) { return !modList.isEmpty(); })
+            .def("__getitem__", [modListToList](const ModListType &modList, const pybind11::slice &slice) {
+                return modListToList(modList).attr("__getitem__")(slice);
+            })
+            .def("__getitem__", [](const ModListType &modList, qsizetype i) {
+                if (i < 0) {
+                    i += modList.size();
+                }
+                if (i < 0 || i >= modList.size()) {
+                    throw pybind11::index_error();
+                }
+                return modList[i];
+            })
+            .def("__iter__", [](const ModListType &modList) {
+                return pybind11::make_iterator(modList.begin(), modList.end());
+            }, pybind11::keep_alive<0, 1>())
+            .def("__contains__", [](const ModListType &modList, pybind11::object mod) {
+                // like a list, anything that is no mod is simply not contained
+                return pybind11::isinstance<CSMMMod>(mod) && modList.contains(mod.cast<CSMMModHolder>());
+            })
+            .def("__reversed__", [modListToList](const ModListType &modList) {
+                return modListToList(modList).attr("__reversed__")();
+            })
+            .def("index", [modListToList](const ModListType &modList, pybind11::args args) {
+                return modListToList(modList).attr("index")(*args);
+            })
+            .def("count", [modListToList](const ModListType &modList, pybind11::object mod) {
+                return modListToList(modList).attr("count")(mod);
+            })
+            .def("copy", modListToList)
+            .def("__add__", [modListToList](const ModListType &modList, pybind11::object other) {
+                return modListToList(modList).attr("__add__")(pybind11::list(other));
+            })
+            .def("__radd__", [modListToList](const ModListType &modList, pybind11::object other) {
+                return pybind11::list(other).attr("__add__")(modListToList(modList));
+            })
+            .def("__eq__", [modListToList](const ModListType &modList, pybind11::object other) {
+                return pybind11::isinstance<pybind11::sequence>(other) && !pybind11::isinstance<pybind11::str>(other)
+                        && modListToList(modList).equal(pybind11::list(other));
+            })
+            .def("__repr__", [modListToList](const ModListType &modList) {
+                return "ModList(" + pybind11::repr(modListToList(modList)).cast<std::string>() + ")";
+            });
+    // isinstance(modList, collections.abc.Sequence) holds like it did for the list it replaces
+    pybind11::module_::import("collections.abc").attr("Sequence").attr("register")(modListCls);
+
     pybind11::class_<MapDescriptor>(m, "MapDescriptor", R"pycsmmdoc(
     Stores relevant information for a Fortune Street board.
 )pycsmmdoc")
@@ -432,6 +576,15 @@ void init_pycsmm(pybind11::module_ &m) {
 )pycsmmdoc")
             .def_readwrite("districtNameIds", &MapDescriptor::districtNameIds, R"pycsmmdoc(
     A list of localization IDs for the boards' district names.
+)pycsmmdoc")
+            .def_readwrite("authors", &MapDescriptor::authors, R"pycsmmdoc(
+    A list of the board's authors.
+)pycsmmdoc")
+            .def_readwrite("shopNames", &MapDescriptor::shopNames, R"pycsmmdoc(
+    A mapping from language code to a list of shop names, indexed by shop model - 1.
+)pycsmmdoc")
+            .def_readwrite("shopNameStartId", &MapDescriptor::shopNameStartId, R"pycsmmdoc(
+    The first localization ID of the board's shop names.
 )pycsmmdoc")
             .def_property("extraData", [](MapDescriptor &desc) { return desc.extraData.get(); },
     [](MapDescriptor &desc, pybind11::dict d) { desc.extraData.get() = d; }, R"pycsmmdoc(
@@ -580,7 +733,28 @@ void init_pycsmm(pybind11::module_ &m) {
     Returns a mapping from .brres file (relative to the root of the Fortune Street game folder) to callback.
     Each callback should take 4 arguments: the root of the Fortune Street game folder, the GameInstance,
     the list of mods, and the directory that the .brres file was extracted to for modification. Each callback
-    should modify the .brres file as it desires.
+    should modify the .brres file as it desires. The directory holds the sub-files of the BrresArchive of the
+    .brres file and is read back into it, so the .brres file is only packed with wszst if sub-files are added
+    or removed.
+)pycsmmdoc")
+        .def("modifyBrresArchive", &BrresFileInterface::modifyBrresArchive, R"pycsmmdoc(
+    Returns a mapping from .brres file (relative to the root of the Fortune Street game folder) to callback.
+    Each callback should take 4 arguments: the root of the Fortune Street game folder, the GameInstance,
+    the list of mods, and the BrresArchive of the .brres file. This avoids writing the sub-files to a directory.
+)pycsmmdoc");
+
+    pybind11::class_<Brres::Archive>(m, "BrresArchive", R"pycsmmdoc(
+    A .brres file held in memory. Sub-files can be replaced but not added, removed or renamed.
+)pycsmmdoc")
+        .def("paths", &Brres::Archive::paths, R"pycsmmdoc(
+    Returns the paths of the sub-files, named like wszst extracts them (e.g. "Textures(NW4R)/name").
+)pycsmmdoc")
+        .def("__contains__", &Brres::Archive::contains)
+        .def("subFile", &Brres::Archive::subFile, pybind11::arg("path"), R"pycsmmdoc(
+    Returns the contents of the sub-file at path as bytes.
+)pycsmmdoc")
+        .def("setSubFile", &Brres::Archive::setSubFile, pybind11::arg("path"), pybind11::arg("data"), R"pycsmmdoc(
+    Replaces the contents of the sub-file at path. Only TEX0 and PLT0 sub-files may grow.
 )pycsmmdoc");
 
     pybind11::class_<GeneralInterface, PyGeneralInterface, std::shared_ptr<GeneralInterface>>(m, "GeneralInterface", R"pycsmmdoc(
@@ -595,7 +769,12 @@ void init_pycsmm(pybind11::module_ &m) {
 )pycsmmdoc", pybind11::arg("root"), pybind11::arg("gameInstance"), pybind11::arg("modList"))
             .def("saveFiles", &GeneralInterface::saveFiles, R"pycsmmdoc(
     Writes to the game files as applicable to the mod.
-)pycsmmdoc", pybind11::arg("root"), pybind11::arg("gameInstance"), pybind11::arg("modList"));
+)pycsmmdoc", pybind11::arg("root"), pybind11::arg("gameInstance"), pybind11::arg("modList"))
+            .def("fileDependencies", &GeneralInterface::fileDependencies, R"pycsmmdoc(
+    Returns the set of existing game files (relative to the game root, wildcards allowed) that loadFiles
+    and saveFiles read or modify, so that only those need to be extracted from a disc image. If this is not
+    overridden, the whole game is extracted.
+)pycsmmdoc");
 
     pybind11::class_<UiMessageInterface, PyUiMessageInterface, std::shared_ptr<UiMessageInterface>>(m, "UiMessageInterface", R"pycsmmdoc(
     Mod interface for modifying the game localization files.
@@ -267,12 +267,11 @@ PYBIND11_MAKE_OPAQUE(std::vector<OriginPoint>);
 PYBIND11_MAKE_OPAQUE(std::vector<MusicEntry>);
 PYBIND11_MAKE_OPAQUE(std::map<MusicType, std::vector<MusicEntry>>);
 PYBIND11_MAKE_OPAQUE(std::array<Character, 3>);
-PYBIND11_MAKE_OPAQUE(std::map<QString, QString>);
 PYBIND11_MAKE_OPAQUE(std::vector<QString>);
-PYBIND11_MAKE_OPAQUE(std::map<QString, std::vector<QString>>);
 PYBIND11_MAKE_OPAQUE(std::vector<quint32>);
 PYBIND11_MAKE_OPAQUE(std::vector<MapDescriptor>);
 PYBIND11_MAKE_OPAQUE(UiMessage);
+PYBIND11_MAKE_OPAQUE(ModListType);
 
 void init_pycsmm(pybind11::module_ &m);
 
@@ -11,33 +11,12 @@ bool validateRiivolutionName(const QString &riivolutionName) {
             && riivolutionName != "riivolution";
 }
 
-static bool fileContentsEqual(const QString &filePath0, const QString &filePath1) {
-    QFileInfo fileInfo0(filePath0), fileInfo1(filePath1);
-    if (!fileInfo0.exists()) {
-        return !fileInfo1.exists();
-    }
-    if (fileInfo0.size() != fileInfo1.size()) {
-        return false;
-    }
-    QFile file0(filePath0), file1(filePath1);
-    if (!file0.open(QFile::ReadOnly)) {
-        throw Exception("could not open " + filePath0 + " for inspection");
-    }
-    if (!file1.open(QFile::ReadOnly)) {
-        throw Exception("could not open " + filePath1 + " for inspection");
-    }
-    char buffer0[4096], buffer1[4096];
-    while (!file0.atEnd() && !file1.atEnd()) {
-        auto numRead0 = file0.read(buffer0, 4096);
-        auto numRead1 = file1.read(buffer1, 4096);
-        if (numRead0 != numRead1 || memcmp(buffer0, buffer1, numRead0) != 0) {
-            return false;
-        }
-    }
-    return true;
+void write(const QDir &vanilla, const QDir &fullPatchDir, const AddressMapper &addressMapper, const QString &riivolutionName) {
+    write(FileManifest::cachedVanillaManifest(vanilla), vanilla.filePath(MAIN_DOL), fullPatchDir, addressMapper, riivolutionName);
 }
 
-void write(const QDir &vanilla, const QDir &fullPatchDir, const AddressMapper &addressMapper, const QString &riivolutionName) {
+void write(const FileManifest::Manifest &vanillaFiles, const QString &vanillaMainDolPath, const QDir &fullPatchDir,
+           const AddressMapper &addressMapper, const QString &riivolutionName) {
     const char *discId;
     switch (addressMapper.getVersion()) {
     case GameVersion::BOOM:
@@ -100,7 +79,7 @@ void write(const QDir &vanilla, const QDir &fullPatchDir, const AddressMapper &a
 
     // patch main dol
     {
-        QFile vanillaMainDol(vanilla.filePath(MAIN_DOL)),
+        QFile vanillaMainDol(vanillaMainDolPath),
                 patchedMainDol(fullPatchDir.filePath(riivolutionName + "/" + MAIN_DOL));
         if (!vanillaMainDol.open(QFile::ReadOnly)) {
             throw Exception("couldn't open vanilla main dol for reading");
@@ -151,14 +130,23 @@ void write(const QDir &vanilla, const QDir &fullPatchDir, const AddressMapper &a
         }
     }
 
-    // then purge unchanged files
-    QDirIterator dirIt(fullPatchDir.filePath(riivolutionName + "/files"),
-                       QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    // then purge unchanged files; only files whose size matches the vanilla manifest need to be hashed
+    QDir patchedFilesDir(fullPatchDir.filePath(riivolutionName + "/files"));
+    QVector<QString> candidatePaths;
+    QVector<QString> candidateVanillaHashes;
+    QDirIterator dirIt(patchedFilesDir.path(), QDir::Files | QDir::NoDotAndDotDot | QDir::Hidden, QDirIterator::Subdirectories);
     while (dirIt.hasNext()) {
         auto patchedFilePath = dirIt.next();
-        auto vanillaFilePath = vanilla.filePath("files/" + QDir(dirIt.path()).relativeFilePath(patchedFilePath));
-        if (fileContentsEqual(vanillaFilePath, patchedFilePath)) {
-            QFile::remove(patchedFilePath);
+        auto vanillaIt = vanillaFiles.find(patchedFilesDir.relativeFilePath(patchedFilePath));
+        if (vanillaIt != vanillaFiles.end() && vanillaIt->size == dirIt.fileInfo().size()) {
+            candidatePaths.append(patchedFilePath);
+            candidateVanillaHashes.append(vanillaIt->sha1);
+        }
+    }
+    auto candidateHashes = FileManifest::hashFiles(candidatePaths);
+    for (int i = 0; i < candidatePaths.size(); ++i) {
+        if (candidateHashes[i] == candidateVanillaHashes[i] && !QFile::remove(candidatePaths[i])) {
+            throw Exception("could not remove unchanged file " + candidatePaths[i]);
         }
     }
 }
@@ -2,6 +2,7 @@
 #define RIIVOLUTION_H
 
 #include "lib/addressmapping.h"
+#include "lib/filemanifest.h"
 #include <QDir>
 #include <QException>
 #include <stdexcept>
@@ -10,6 +11,16 @@ namespace Riivolution {
 
 bool validateRiivolutionName(const QString &riivolutionName);
 void write(const QDir &vanilla, const QDir &fullPatchDir, const AddressMapper &addressMapper, const QString &riivolutionName);
+/**
+ * @brief write Writes the Riivolution patch, purging files that are unchanged from vanilla.
+ * @param vanillaFiles the manifest of the vanilla files folder (see FileManifest::cachedVanillaManifest)
+ * @param vanillaMainDolPath path to a copy of the vanilla main.dol
+ * @param fullPatchDir the directory containing the modified game directory named riivolutionName
+ * @param addressMapper the address mapper for the game
+ * @param riivolutionName the name of the Riivolution patch
+ */
+void write(const FileManifest::Manifest &vanillaFiles, const QString &vanillaMainDolPath, const QDir &fullPatchDir,
+           const AddressMapper &addressMapper, const QString &riivolutionName);
 
 class Exception : public QException, public std::runtime_error {
 public:
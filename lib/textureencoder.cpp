@@ -0,0 +1,447 @@
+#include "textureencoder.h"
+
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace TextureEncoder {
+
+static constexpr int MAX_DIMENSION = 1024;
+
+std::optional<Format> findFormat(const QString &name) {
+    auto upperName = name.toUpper();
+    if (upperName == "RGB5A3") return RGB5A3;
+    if (upperName == "RGBA8" || upperName == "RGBA32") return RGBA8;
+    if (upperName == "CMPR") return CMPR;
+    return std::nullopt;
+}
+
+Format formatFromName(const QString &name) {
+    if (auto format = findFormat(name)) {
+        return *format;
+    }
+    throw Exception(QString("Unsupported texture format %1").arg(name));
+}
+
+Format autoFormat(const QImage &image) {
+    if (!image.hasAlphaChannel()) {
+        return CMPR;
+    }
+    auto rgbaImage = image.convertToFormat(QImage::Format_RGBA8888);
+    for (int y = 0; y < rgbaImage.height(); ++y) {
+        auto line = rgbaImage.constScanLine(y);
+        for (int x = 0; x < rgbaImage.width(); ++x) {
+            if (line[4 * x + 3] != 0xFF) {
+                return RGB5A3;
+            }
+        }
+    }
+    return CMPR;
+}
+
+static int blockWidth(Format format) { return format == CMPR ? 8 : 4; }
+static int blockHeight(Format format) { return format == CMPR ? 8 : 4; }
+static int blockSize(Format format) { return format == RGBA8 ? 64 : 32; }
+
+/**
+ * @return the RGBA8888 pixel at (x, y), repeating the edges of the image for coordinates outside of it
+ */
+static inline const uchar *pixelAt(const QImage &image, int x, int y) {
+    return image.constScanLine(std::min(y, image.height() - 1)) + 4 * std::min(x, image.width() - 1);
+}
+
+static inline int scaleChannel(int value, int max) {
+    return (value * max + 127) / 255;
+}
+
+static void encodeRgb5a3Block(const QImage &image, int x0, int y0, uchar *out) {
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            auto p = pixelAt(image, x0 + x, y0 + y);
+            quint16 value;
+            if (p[3] >= 0xE0) {
+                // opaque: 1RRRRRGGGGGBBBBB
+                value = 0x8000 | scaleChannel(p[0], 31) << 10 | scaleChannel(p[1], 31) << 5 | scaleChannel(p[2], 31);
+            } else {
+                // translucent: 0AAARRRRGGGGBBBB
+                value = scaleChannel(p[3], 7) << 12 | scaleChannel(p[0], 15) << 8 | scaleChannel(p[1], 15) << 4 | scaleChannel(p[2], 15);
+            }
+            qToBigEndian<quint16>(value, out + 2 * (4 * y + x));
+        }
+    }
+}
+
+static void encodeRgba8Block(const QImage &image, int x0, int y0, uchar *out) {
+    // the AR pairs of the block come first, followed by the GB pairs
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            auto p = pixelAt(image, x0 + x, y0 + y);
+            int i = 4 * y + x;
+            out[2 * i] = p[3];
+            out[2 * i + 1] = p[0];
+            out[32 + 2 * i] = p[1];
+            out[32 + 2 * i + 1] = p[2];
+        }
+    }
+}
+
+/**
+ * The pixels of a 4x4 CMPR sub-block, stored as separate channels so that the per-pixel loops vectorize.
+ */
+struct CmprBlock {
+    float r[16], g[16], b[16];
+    float weight[16]; // 1 for opaque pixels, 0 for transparent ones
+    int opaqueCount = 0;
+};
+
+struct CmprCandidate {
+    quint16 color0 = 0, color1 = 0;
+    quint8 indices[16] = {};
+    float error = std::numeric_limits<float>::max();
+    bool threeColorMode = false;
+    float palette[4][3] = {};
+};
+
+static inline quint16 packRgb565(const float color[3]) {
+    int r = std::clamp((int)std::lround(color[0] * 31 / 255), 0, 31);
+    int g = std::clamp((int)std::lround(color[1] * 63 / 255), 0, 63);
+    int b = std::clamp((int)std::lround(color[2] * 31 / 255), 0, 31);
+    return r << 11 | g << 5 | b;
+}
+
+static inline void unpackRgb565(quint16 value, float color[3]) {
+    int r = value >> 11 & 31, g = value >> 5 & 63, b = value & 31;
+    color[0] = r << 3 | r >> 2;
+    color[1] = g << 2 | g >> 4;
+    color[2] = b << 3 | b >> 2;
+}
+
+static void boundingBoxEndpoints(const CmprBlock &block, float endpoint0[3], float endpoint1[3]) {
+    const float big = std::numeric_limits<float>::max();
+    float minR = big, minG = big, minB = big, maxR = -big, maxG = -big, maxB = -big;
+    for (int i = 0; i < 16; ++i) {
+        bool opaque = block.weight[i] > 0;
+        minR = opaque ? std::min(minR, block.r[i]) : minR;
+        minG = opaque ? std::min(minG, block.g[i]) : minG;
+        minB = opaque ? std::min(minB, block.b[i]) : minB;
+        maxR = opaque ? std::max(maxR, block.r[i]) : maxR;
+        maxG = opaque ? std::max(maxG, block.g[i]) : maxG;
+        maxB = opaque ? std::max(maxB, block.b[i]) : maxB;
+    }
+    endpoint0[0] = maxR; endpoint0[1] = maxG; endpoint0[2] = maxB;
+    endpoint1[0] = minR; endpoint1[1] = minG; endpoint1[2] = minB;
+}
+
+static void principalAxisEndpoints(const CmprBlock &block, float endpoint0[3], float endpoint1[3]) {
+    float meanR = 0, meanG = 0, meanB = 0;
+    for (int i = 0; i < 16; ++i) {
+        meanR += block.weight[i] * block.r[i];
+        meanG += block.weight[i] * block.g[i];
+        meanB += block.weight[i] * block.b[i];
+    }
+    meanR /= block.opaqueCount; meanG /= block.opaqueCount; meanB /= block.opaqueCount;
+
+    float covRR = 0, covRG = 0, covRB = 0, covGG = 0, covGB = 0, covBB = 0;
+    for (int i = 0; i < 16; ++i) {
+        float dr = block.r[i] - meanR, dg = block.g[i] - meanG, db = block.b[i] - meanB;
+        covRR += block.weight[i] * dr * dr;
+        covRG += block.weight[i] * dr * dg;
+        covRB += block.weight[i] * dr * db;
+        covGG += block.weight[i] * dg * dg;
+        covGB += block.weight[i] * dg * db;
+        covBB += block.weight[i] * db * db;
+    }
+
+    // power iteration for the eigenvector with the largest eigenvalue
+    float axis[3] = {1, 1, 1};
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float x = covRR * axis[0] + covRG * axis[1] + covRB * axis[2];
+        float y = covRG * axis[0] + covGG * axis[1] + covGB * axis[2];
+        float z = covRB * axis[0] + covGB * axis[1] + covBB * axis[2];
+        float length = std::max({std::abs(x), std::abs(y), std::abs(z)});
+        if (length < 1e-6f) {
+            // all opaque pixels have the same color
+            endpoint0[0] = endpoint1[0] = meanR;
+            endpoint0[1] = endpoint1[1] = meanG;
+            endpoint0[2] = endpoint1[2] = meanB;
+            return;
+        }
+        axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+    }
+    float norm = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    axis[0] /= norm; axis[1] /= norm; axis[2] /= norm;
+
+    const float big = std::numeric_limits<float>::max();
+    float minT = big, maxT = -big;
+    for (int i = 0; i < 16; ++i) {
+        float t = (block.r[i] - meanR) * axis[0] + (block.g[i] - meanG) * axis[1] + (block.b[i] - meanB) * axis[2];
+        bool opaque = block.weight[i] > 0;
+        minT = opaque ? std::min(minT, t) : minT;
+        maxT = opaque ? std::max(maxT, t) : maxT;
+    }
+    endpoint0[0] = meanR + axis[0] * maxT; endpoint0[1] = meanG + axis[1] * maxT; endpoint0[2] = meanB + axis[2] * maxT;
+    endpoint1[0] = meanR + axis[0] * minT; endpoint1[1] = meanG + axis[1] * minT; endpoint1[2] = meanB + axis[2] * minT;
+}
+
+/**
+ * @brief Quantizes the endpoints and maps every pixel of the block to its closest palette entry.
+ */
+static CmprCandidate evaluateEndpoints(const CmprBlock &block, const float endpoint0[3], const float endpoint1[3], bool threeColorMode) {
+    CmprCandidate candidate;
+    candidate.color0 = packRgb565(endpoint0);
+    candidate.color1 = packRgb565(endpoint1);
+    // the hardware picks the 4 color mode if color0 > color1 and the 3 color mode with transparency otherwise
+    if (threeColorMode ? candidate.color0 > candidate.color1 : candidate.color0 < candidate.color1) {
+        std::swap(candidate.color0, candidate.color1);
+    }
+    candidate.threeColorMode = candidate.color0 <= candidate.color1;
+
+    auto &palette = candidate.palette;
+    unpackRgb565(candidate.color0, palette[0]);
+    unpackRgb565(candidate.color1, palette[1]);
+    int paletteSize;
+    if (candidate.threeColorMode) {
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+        }
+        paletteSize = 3;
+    } else {
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (5 * palette[0][c] + 3 * palette[1][c]) / 8;
+            palette[3][c] = (3 * palette[0][c] + 5 * palette[1][c]) / 8;
+        }
+        paletteSize = 4;
+    }
+
+    float bestDistance[16];
+    std::fill(std::begin(bestDistance), std::end(bestDistance), std::numeric_limits<float>::max());
+    for (int p = 0; p < paletteSize; ++p) {
+        for (int i = 0; i < 16; ++i) {
+            float dr = block.r[i] - palette[p][0], dg = block.g[i] - palette[p][1], db = block.b[i] - palette[p][2];
+            float distance = dr * dr + dg * dg + db * db;
+            bool closer = distance < bestDistance[i];
+            bestDistance[i] = closer ? distance : bestDistance[i];
+            candidate.indices[i] = closer ? p : candidate.indices[i];
+        }
+    }
+    candidate.error = 0;
+    for (int i = 0; i < 16; ++i) {
+        candidate.error += block.weight[i] * bestDistance[i];
+        // index 3 is transparent in the 3 color mode
+        candidate.indices[i] = block.weight[i] > 0 ? candidate.indices[i] : 3;
+    }
+    return candidate;
+}
+
+/**
+ * @brief Solves for the endpoints which minimize the squared error of the pixels given their palette indices.
+ * @return false if the indices do not determine both endpoints
+ */
+static bool refineEndpoints(const CmprBlock &block, const CmprCandidate &candidate, float endpoint0[3], float endpoint1[3]) {
+    // the weight of endpoint 0 for every palette index
+    const float fourColorWeights[4] = {1, 0, 5.0f / 8, 3.0f / 8};
+    const float threeColorWeights[4] = {1, 0, 0.5f, 0};
+    auto &weights = candidate.threeColorMode ? threeColorWeights : fourColorWeights;
+
+    float aa = 0, ab = 0, bb = 0;
+    float ax[3] = {}, bx[3] = {};
+    for (int i = 0; i < 16; ++i) {
+        float a = weights[candidate.indices[i]] * block.weight[i];
+        float b = (1 - weights[candidate.indices[i]]) * block.weight[i];
+        aa += a * a; ab += a * b; bb += b * b;
+        ax[0] += a * block.r[i]; ax[1] += a * block.g[i]; ax[2] += a * block.b[i];
+        bx[0] += b * block.r[i]; bx[1] += b * block.g[i]; bx[2] += b * block.b[i];
+    }
+    float determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f) {
+        return false;
+    }
+    for (int c = 0; c < 3; ++c) {
+        endpoint0[c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f);
+        endpoint1[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+static void encodeCmprSubBlock(const QImage &image, int x0, int y0, Quality quality, uchar *out) {
+    CmprBlock block;
+    for (int i = 0; i < 16; ++i) {
+        auto p = pixelAt(image, x0 + i % 4, y0 + i / 4);
+        block.r[i] = p[0];
+        block.g[i] = p[1];
+        block.b[i] = p[2];
+        block.weight[i] = p[3] >= 0x80 ? 1 : 0;
+        block.opaqueCount += p[3] >= 0x80;
+    }
+
+    CmprCandidate best;
+    if (block.opaqueCount == 0) {
+        // color0 == color1 selects the 3 color mode; every pixel uses the transparent index
+        std::fill(std::begin(best.indices), std::end(best.indices), 3);
+    } else {
+        bool hasTransparency = block.opaqueCount < 16;
+        float endpoint0[3], endpoint1[3];
+        if (quality == Quality::Fast) {
+            boundingBoxEndpoints(block, endpoint0, endpoint1);
+        } else {
+            principalAxisEndpoints(block, endpoint0, endpoint1);
+        }
+        best = evaluateEndpoints(block, endpoint0, endpoint1, hasTransparency);
+        if (quality == Quality::Best) {
+            if (!hasTransparency) {
+                auto candidate = evaluateEndpoints(block, endpoint0, endpoint1, true);
+                if (candidate.error < best.error) {
+                    best = candidate;
+                }
+            }
+            for (int iteration = 0; iteration < 2 && best.error > 0; ++iteration) {
+                if (!refineEndpoints(block, best, endpoint0, endpoint1)) {
+                    break;
+                }
+                auto candidate = evaluateEndpoints(block, endpoint0, endpoint1, best.threeColorMode);
+                if (candidate.error >= best.error) {
+                    break;
+                }
+                best = candidate;
+            }
+        }
+    }
+
+    qToBigEndian<quint16>(best.color0, out);
+    qToBigEndian<quint16>(best.color1, out + 2);
+    for (int y = 0; y < 4; ++y) {
+        auto row = best.indices + 4 * y;
+        out[4 + y] = row[0] << 6 | row[1] << 4 | row[2] << 2 | row[3];
+    }
+}
+
+static void encodeCmprBlock(const QImage &image, int x0, int y0, Quality quality, uchar *out) {
+    // an 8x8 CMPR block consists of four 4x4 DXT1 blocks in row-major order
+    for (int i = 0; i < 4; ++i) {
+        encodeCmprSubBlock(image, x0 + 4 * (i % 2), y0 + 4 * (i / 2), quality, out + 8 * i);
+    }
+}
+
+QByteArray encode(const QImage &image, Format format, Quality quality) {
+    if (image.isNull()) {
+        throw Exception("Cannot encode an empty image");
+    }
+    if (image.width() > MAX_DIMENSION || image.height() > MAX_DIMENSION) {
+        throw Exception(QString("Cannot encode a %1x%2 image; textures are at most %3x%3")
+                        .arg(image.width()).arg(image.height()).arg(MAX_DIMENSION));
+    }
+    auto rgbaImage = image.convertToFormat(QImage::Format_RGBA8888);
+    int blocksX = (rgbaImage.width() + blockWidth(format) - 1) / blockWidth(format);
+    int blocksY = (rgbaImage.height() + blockHeight(format) - 1) / blockHeight(format);
+    QByteArray result(blocksX * blocksY * blockSize(format), '\0');
+    auto data = reinterpret_cast<uchar *>(result.data());
+
+    QVector<int> blockRows(blocksY);
+    std::iota(blockRows.begin(), blockRows.end(), 0);
+    QtConcurrent::blockingMap(blockRows, [&](int blockY) {
+        auto out = data + blockY * blocksX * blockSize(format);
+        for (int blockX = 0; blockX < blocksX; ++blockX, out += blockSize(format)) {
+            int x0 = blockX * blockWidth(format), y0 = blockY * blockHeight(format);
+            switch (format) {
+            case RGB5A3:
+                encodeRgb5a3Block(rgbaImage, x0, y0, out);
+                break;
+            case RGBA8:
+                encodeRgba8Block(rgbaImage, x0, y0, out);
+                break;
+            case CMPR:
+                encodeCmprBlock(rgbaImage, x0, y0, quality, out);
+                break;
+            }
+        }
+    });
+    return result;
+}
+
+QByteArray toTpl(const QImage &image, Format format, Quality quality) {
+    static constexpr quint32 IMAGE_TABLE_OFFSET = 0x0C;
+    static constexpr quint32 IMAGE_HEADER_OFFSET = 0x14;
+    static constexpr quint32 DATA_OFFSET = 0x40;
+
+    auto data = encode(image, format, quality);
+    QByteArray result(DATA_OFFSET, '\0');
+    auto header = reinterpret_cast<uchar *>(result.data());
+    qToBigEndian<quint32>(0x0020AF30, header);
+    qToBigEndian<quint32>(1, header + 0x04); // image count
+    qToBigEndian<quint32>(IMAGE_TABLE_OFFSET, header + 0x08);
+    qToBigEndian<quint32>(IMAGE_HEADER_OFFSET, header + IMAGE_TABLE_OFFSET); // no palette header follows
+    auto imageHeader = header + IMAGE_HEADER_OFFSET;
+    qToBigEndian<quint16>(image.height(), imageHeader);
+    qToBigEndian<quint16>(image.width(), imageHeader + 0x02);
+    qToBigEndian<quint32>(format, imageHeader + 0x04);
+    qToBigEndian<quint32>(DATA_OFFSET, imageHeader + 0x08);
+    // clamped wrapping, linear filtering, no LOD bias and no mipmaps
+    qToBigEndian<quint32>(1, imageHeader + 0x14);
+    qToBigEndian<quint32>(1, imageHeader + 0x18);
+    result += data;
+    return result;
+}
+
+QByteArray toTex0(const QImage &image, Format format, const QString &name, Quality quality) {
+    static constexpr quint32 DATA_OFFSET = 0x40;
+
+    auto data = encode(image, format, quality);
+    quint32 sectionSize = DATA_OFFSET + data.size();
+    QByteArray result(DATA_OFFSET, '\0');
+    auto header = reinterpret_cast<uchar *>(result.data());
+    std::copy_n("TEX0", 4, header);
+    qToBigEndian<quint32>(sectionSize, header + 0x04);
+    qToBigEndian<quint32>(3, header + 0x08); // version
+    qToBigEndian<qint32>(0, header + 0x0C); // not part of a brres
+    qToBigEndian<quint32>(DATA_OFFSET, header + 0x10);
+    // the name is stored after the section, preceded by its length
+    qToBigEndian<quint32>(sectionSize + 4, header + 0x14);
+    qToBigEndian<quint16>(image.width(), header + 0x1C);
+    qToBigEndian<quint16>(image.height(), header + 0x1E);
+    qToBigEndian<quint32>(format, header + 0x20);
+    qToBigEndian<quint32>(1, header + 0x24); // image count
+    result += data;
+
+    auto nameBytes = name.toUtf8();
+    uchar length[4];
+    qToBigEndian<quint32>(nameBytes.size(), length);
+    result.append(reinterpret_cast<const char *>(length), 4);
+    result += nameBytes;
+    result += '\0';
+    while (result.size() % 4 != 0) {
+        result += '\0';
+    }
+    return result;
+}
+
+static QImage loadImage(const QString &imageFile) {
+    QImage image(imageFile);
+    if (image.isNull()) {
+        throw Exception(QString("Could not read image %1").arg(imageFile));
+    }
+    return image;
+}
+
+static void writeFile(const QString &file, const QByteArray &contents) {
+    QSaveFile saveFile(file);
+    if (!saveFile.open(QFile::WriteOnly) || saveFile.write(contents) != contents.size() || !saveFile.commit()) {
+        throw Exception(QString("Could not write %1").arg(file));
+    }
+}
+
+void encodeTplFile(const QString &imageFile, const QString &tplFile, std::optional<Format> format, Quality quality) {
+    auto image = loadImage(imageFile);
+    writeFile(tplFile, toTpl(image, format ? *format : autoFormat(image), quality));
+}
+
+void encodeTex0File(const QString &imageFile, const QString &texFile, std::optional<Format> format, Quality quality) {
+    auto image = loadImage(imageFile);
+    writeFile(texFile, toTex0(image, format ? *format : autoFormat(image), QFileInfo(texFile).completeBaseName(), quality));
+}
+
+}
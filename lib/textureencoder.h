@@ -0,0 +1,88 @@
+#ifndef TEXTUREENCODER_H
+#define TEXTUREENCODER_H
+
+#include <QByteArray>
+#include <QException>
+#include <QImage>
+#include <QString>
+#include <optional>
+#include <stdexcept>
+
+/**
+ * Encodes images to the GX texture formats used by CSMM and writes them as TPL or TEX0 files,
+ * so that textures no longer need a wimgt round trip.
+ */
+namespace TextureEncoder {
+
+/**
+ * @brief The supported GX texture formats; the values are the format ids stored in TPL and TEX0 headers.
+ */
+enum Format : quint32 {
+    RGB5A3 = 0x05,
+    RGBA8 = 0x06,
+    CMPR = 0x0E
+};
+
+/**
+ * @brief Trades speed for quality when encoding CMPR; RGB5A3 and RGBA8 are unaffected.
+ * Fast uses the bounding box of each block, Normal its principal axis and Best additionally refines the
+ * endpoints by least squares and tries the 3 color mode.
+ */
+enum class Quality {
+    Fast,
+    Normal,
+    Best
+};
+
+/**
+ * @return the format with the given wimgt name (e.g. "RGB5A3" or "CMPR"), or nothing if the encoder does not support it
+ */
+std::optional<Format> findFormat(const QString &name);
+
+/**
+ * @return the format with the given wimgt name (e.g. "RGB5A3" or "CMPR")
+ */
+Format formatFromName(const QString &name);
+
+/**
+ * @return the format wimgt picks for an image when none is given: CMPR if the image is opaque, otherwise RGB5A3
+ */
+Format autoFormat(const QImage &image);
+
+/**
+ * @brief encode Encodes an image to GX block data. The image is padded to whole blocks by repeating its edges.
+ */
+QByteArray encode(const QImage &image, Format format, Quality quality = Quality::Normal);
+
+/**
+ * @brief toTpl Encodes an image to a TPL file with a single image and no mipmaps.
+ */
+QByteArray toTpl(const QImage &image, Format format, Quality quality = Quality::Normal);
+
+/**
+ * @brief toTex0 Encodes an image to a standalone TEX0 file with no mipmaps.
+ * @param name the texture name; wszst renames the texture after its file name when packing a brres
+ */
+QByteArray toTex0(const QImage &image, Format format, const QString &name, Quality quality = Quality::Normal);
+
+/**
+ * @param format the format to encode to, or nothing to pick it with autoFormat
+ */
+void encodeTplFile(const QString &imageFile, const QString &tplFile, std::optional<Format> format, Quality quality = Quality::Normal);
+/**
+ * @param format the format to encode to, or nothing to pick it with autoFormat
+ */
+void encodeTex0File(const QString &imageFile, const QString &texFile, std::optional<Format> format, Quality quality = Quality::Normal);
+
+class Exception : public QException, public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+    const char *what() const noexcept override { return std::runtime_error::what(); }
+    Exception(const QString &str) : std::runtime_error(str.toStdString()) {}
+    void raise() const override { throw *this; }
+    Exception *clone() const override { return new Exception(*this); }
+};
+
+}
+
+#endif // TEXTUREENCODER_H
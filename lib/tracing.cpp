@@ -0,0 +1,100 @@
+#include "tracing.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+#include <QCoreApplication>
+
+namespace Tracing {
+
+struct Event {
+    const char *category;
+    QString name;
+    qint64 start;
+    qint64 duration;
+    quint64 threadId;
+    QVariantMap args;
+};
+
+static QMutex mutex;
+static QElapsedTimer clock;
+static QString traceFilePath;
+static QVector<Event> events;
+
+void start(const QString &traceFile) {
+    QMutexLocker locker(&mutex);
+    traceFilePath = traceFile;
+    events.clear();
+    clock.start();
+    detail::enabled = true;
+}
+
+void stop() {
+    if (!isEnabled()) {
+        return;
+    }
+    detail::enabled = false;
+    QMutexLocker locker(&mutex);
+    QJsonArray traceEvents;
+    qint64 pid = QCoreApplication::applicationPid();
+    for (auto &event: events) {
+        traceEvents.append(QJsonObject{
+            {"cat", event.category},
+            {"name", event.name},
+            {"ph", "X"},
+            {"ts", event.start},
+            {"dur", event.duration},
+            {"pid", pid},
+            {"tid", (qint64)event.threadId},
+            {"args", QJsonObject::fromVariantMap(event.args)}
+        });
+    }
+    events.clear();
+    auto json = QJsonDocument(QJsonObject{{"traceEvents", traceEvents}, {"displayTimeUnit", "ms"}}).toJson(QJsonDocument::Compact);
+    QSaveFile file(traceFilePath);
+    if (!file.open(QFile::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        qWarning() << "could not write the trace to" << traceFilePath;
+    }
+}
+
+qint64 now() {
+    return clock.isValid() ? clock.nsecsElapsed() / 1000 : 0;
+}
+
+Span::Span(const char *category, const QString &name) : active(isEnabled()), category(category) {
+    if (active) {
+        this->name = name;
+        startTime = now();
+        threadId = (quint64)(quintptr)QThread::currentThreadId();
+    }
+}
+
+Span::~Span() {
+    end();
+}
+
+void Span::end() {
+    if (!active) {
+        return;
+    }
+    active = false;
+    if (!isEnabled()) {
+        return;
+    }
+    Event event{category, name, startTime, now() - startTime, threadId, args};
+    QMutexLocker locker(&mutex);
+    events.append(std::move(event));
+}
+
+void Span::arg(const QString &key, const QVariant &value) {
+    if (active) {
+        args.insert(key, value);
+    }
+}
+
+}
@@ -0,0 +1,68 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QString>
+#include <QVariantMap>
+#include <atomic>
+
+/**
+ * Records spans of the work CSMM does as Chrome trace events (viewable in chrome://tracing or Perfetto).
+ * Tracing is off unless started; while it is off a span costs a single atomic load.
+ */
+namespace Tracing {
+
+namespace detail {
+inline std::atomic<bool> enabled{false};
+}
+
+inline bool isEnabled() {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief start Starts recording spans, discarding the spans recorded so far.
+ * @param traceFile the file the trace is written to by stop()
+ */
+void start(const QString &traceFile);
+
+/**
+ * @brief stop Stops recording and writes the recorded spans to the trace file.
+ */
+void stop();
+
+/**
+ * @return microseconds since tracing was started
+ */
+qint64 now();
+
+/**
+ * @brief A span which is recorded when it is destroyed, on the thread it was created on.
+ */
+class Span {
+public:
+    explicit Span(const char *category, const QString &name);
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+    ~Span();
+
+    /**
+     * @brief end Records the span now instead of when it is destroyed, e.g. when an asynchronous operation finishes.
+     */
+    void end();
+
+    /**
+     * @brief arg Attaches an argument, e.g. the number of bytes read or written, to the span.
+     */
+    void arg(const QString &key, const QVariant &value);
+private:
+    bool active;
+    const char *category;
+    QString name;
+    qint64 startTime;
+    quint64 threadId;
+    QVariantMap args;
+};
+
+}
+
+#endif // TRACING_H
@@ -341,18 +341,19 @@ const std::map<QString, QString> &localeToDistrictWord() {
     return LOCALE_TO_DISTRICT_WORD;
 }
 
-const std::map<QString, std::vector<QString>> &getVanillaDistrictNames() {
-    static std::map<QString, std::vector<QString>> cachedResult;
-    if (cachedResult.empty()) {
+const LocaleTable<std::vector<QString>> &getVanillaDistrictNames() {
+    static const LocaleTable<std::vector<QString>> cachedResult = []() {
+        LocaleTable<std::vector<QString>> result;
         for (auto locale: FS_LOCALES) {
             int startingChar = locale == "jp" ? 65313 : 'A';
             auto districtWord = LOCALE_TO_DISTRICT_WORD.at(locale);
             districtWord.replace("\\s", " ");
             for (int i=0; i<16; ++i) {
-                cachedResult[locale].push_back(districtWord + QChar((int(startingChar) + i)));
+                result[locale].push_back(districtWord + QChar((int(startingChar) + i)));
             }
         }
-    }
+        return result;
+    }();
     return cachedResult;
 }
 
@@ -1073,8 +1074,9 @@ static const std::map<QString, std::vector<QString>> LOCALE_TO_SHOP_NAMES = {
      }}
 };
 
-const std::map<QString, std::vector<QString>> &getVanillaShopNames() {
-    return LOCALE_TO_SHOP_NAMES;
+const LocaleTable<std::vector<QString>> &getVanillaShopNames() {
+    static const LocaleTable<std::vector<QString>> result(LOCALE_TO_SHOP_NAMES);
+    return result;
 }
 
 }
@@ -20,8 +20,8 @@ bool isDefaultVentureCards(const std::array<bool, 128> &ventureCards, RuleSet ru
 void setDefaultVentureCards(RuleSet ruleSet, std::array<bool, 128> &outVentureCards);
 QSet<QString> getVanillaIcons();
 const std::map<QString, QString> &localeToDistrictWord();
-const std::map<QString, std::vector<QString> > &getVanillaDistrictNames();
-const std::map<QString, std::vector<QString>> &getVanillaShopNames();
+const LocaleTable<std::vector<QString>> &getVanillaDistrictNames();
+const LocaleTable<std::vector<QString>> &getVanillaShopNames();
 }
 
 #endif // VANILLADATABASE_H
@@ -0,0 +1,79 @@
+#include "zipreader.h"
+
+#include <QFile>
+#include "lib/tracing.h"
+#include "zip/zip.h"
+
+namespace Zip {
+
+Reader::Reader(const QString &zipFile) : zipFile(zipFile) {
+    zip = zip_open(zipFile.toUtf8(), 0, 'r');
+    if (!zip) {
+        throw Exception(QString("Could not open %1").arg(zipFile));
+    }
+    ssize_t total = zip_entries_total(zip);
+    for (ssize_t i = 0; i < total; ++i) {
+        if (zip_entry_openbyindex(zip, i) < 0) {
+            continue;
+        }
+        if (!zip_entry_isdir(zip)) {
+            auto name = QString::fromUtf8(zip_entry_name(zip));
+            entryList.append(name);
+            entryIndices[name] = i;
+        }
+        zip_entry_close(zip);
+    }
+}
+
+Reader::~Reader() {
+    zip_close(zip);
+}
+
+const QStringList &Reader::entries() const {
+    return entryList;
+}
+
+bool Reader::contains(const QString &entry) const {
+    return entryIndices.contains(entry);
+}
+
+void Reader::openEntry(const QString &entry) {
+    if (!entryIndices.contains(entry)) {
+        throw Exception(QString("%1 has no entry %2").arg(zipFile, entry));
+    }
+    int result = zip_entry_openbyindex(zip, entryIndices[entry]);
+    if (result < 0) {
+        throw Exception(QString("Could not open %1 in %2: %3").arg(entry, zipFile, zip_strerror(result)));
+    }
+}
+
+QByteArray Reader::read(const QString &entry) {
+    Tracing::Span span("zip", entry);
+    openEntry(entry);
+    void *buf = nullptr;
+    size_t bufsize = 0;
+    ssize_t result = zip_entry_read(zip, &buf, &bufsize);
+    zip_entry_close(zip);
+    if (result < 0) {
+        throw Exception(QString("Could not extract %1 from %2: %3").arg(entry, zipFile, zip_strerror(result)));
+    }
+    QByteArray data((const char *)buf, bufsize);
+    free(buf);
+    span.arg("bytesWritten", data.size());
+    return data;
+}
+
+void Reader::extract(const QString &entry, const QString &destFile) {
+    Tracing::Span span("zip", entry);
+    openEntry(entry);
+    span.arg("bytesWritten", qint64(zip_entry_uncomp_size(zip)));
+    QFile::remove(destFile);
+    int result = zip_entry_fread(zip, destFile.toUtf8());
+    zip_entry_close(zip);
+    if (result < 0) {
+        QFile::remove(destFile);
+        throw Exception(QString("Could not extract %1 from %2 to %3: %4").arg(entry, zipFile, destFile, zip_strerror(result)));
+    }
+}
+
+}
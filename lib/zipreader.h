@@ -0,0 +1,59 @@
+#ifndef ZIPREADER_H
+#define ZIPREADER_H
+
+#include <QByteArray>
+#include <QException>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <stdexcept>
+
+struct zip_t;
+
+namespace Zip {
+
+/**
+ * @brief Reads single entries of a zip archive without extracting the whole archive.
+ * A reader must only be used by one thread at a time.
+ */
+class Reader {
+public:
+    explicit Reader(const QString &zipFile);
+    ~Reader();
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    /**
+     * @return the paths of the file entries, in archive order; directories are not listed
+     */
+    const QStringList &entries() const;
+    bool contains(const QString &entry) const;
+    /**
+     * @brief read Decompresses the entry into memory.
+     */
+    QByteArray read(const QString &entry);
+    /**
+     * @brief extract Decompresses the entry into destFile, replacing it.
+     */
+    void extract(const QString &entry, const QString &destFile);
+private:
+    void openEntry(const QString &entry);
+
+    QString zipFile;
+    zip_t *zip;
+    QStringList entryList;
+    QHash<QString, size_t> entryIndices;
+};
+
+class Exception : public QException, public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+    const char *what() const noexcept override { return std::runtime_error::what(); }
+    Exception(const QString &str) : std::runtime_error(str.toStdString()) {}
+    void raise() const override { throw *this; }
+    Exception *clone() const override { return new Exception(*this); }
+};
+
+}
+
+#endif // ZIPREADER_H
@@ -2,6 +2,7 @@
 #include "csmmmode.h"
 #include <QApplication>
 #include <QDir>
+#include <QMutex>
 #include <QProgressDialog>
 #include <QStyleHints>
 #include "lib/python/pythonbindings.h"
@@ -15,6 +16,7 @@
 #endif
 
 #include "maincli.h"
+#include "lib/tracing.h"
 
 PYBIND11_EMBEDDED_MODULE(pycsmm, m) {
     init_pycsmm(m);
@@ -80,9 +82,7 @@ int main(int argc, char *argv[])
         QStringList arguments = QCoreApplication::arguments();
         // arguments.clear();
         // arguments << "csmm" << "save" << "C:\\BoomStreet\\ST7P01";
-        maincli::run(arguments);
-
-        return 0;
+        return maincli::run(arguments);
     } else {
         QApplication app(argc, argv);
         QCoreApplication::setOrganizationName("Custom Street");
@@ -97,6 +97,12 @@ int main(int argc, char *argv[])
 
         initLogFile();
 
+        QSettings settings;
+        if (settings.value("traceEnabled").toBool()) {
+            QDir traceFileDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+            Tracing::start(traceFileDir.filePath(QString("csmmgui-trace-%0.json").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd-HH-mm-ss"))));
+        }
+
         // show progress messages in progress dialog
         qInstallMessageHandler([](QtMsgType type, const QMessageLogContext &context, const QString &msg) {
             // filter this specific message since it is littering the whole console output
@@ -104,13 +110,22 @@ int main(int argc, char *argv[])
                 return;
             static QTextStream cerr(stderr);
             static QTextStream logFileStream(&logFile);
-            cerr << msg << Qt::endl;
-            if (logFile.isOpen()) {
-                logFileStream << msg << Qt::endl;
+            static QMutex streamMutex;
+            {
+                QMutexLocker locker(&streamMutex);
+                cerr << msg << Qt::endl;
+                if (logFile.isOpen()) {
+                    logFileStream << msg << Qt::endl;
+                }
             }
-            auto progressDialog = dynamic_cast<QProgressDialog *>(QApplication::activeModalWidget());
-            if (type != QtMsgType::QtDebugMsg && progressDialog != nullptr) {
-                progressDialog->setLabelText(msg);
+            if (type != QtMsgType::QtDebugMsg) {
+                // messages also come from worker threads, so the dialog is only touched on the GUI thread
+                QMetaObject::invokeMethod(qApp, [msg]() {
+                    auto progressDialog = dynamic_cast<QProgressDialog *>(QApplication::activeModalWidget());
+                    if (progressDialog != nullptr) {
+                        progressDialog->setLabelText(msg);
+                    }
+                });
             }
         });
 
@@ -121,7 +136,6 @@ int main(int argc, char *argv[])
             ::ShowWindow( ::GetConsoleWindow(), SW_HIDE );
         }
 #endif
-        QSettings settings;
         QWidget *w;
         switch (settings.value("csmmMode", INDETERMINATE).toInt()) {
         case INDETERMINATE:
@@ -142,6 +156,7 @@ int main(int argc, char *argv[])
 #endif
         w->show();
         int e = app.exec();
+        Tracing::stop();
         exit( e ); // needed to exit the hidden console
         return e;
     }
@@ -3,13 +3,22 @@
 #include <QBuffer>
 #include <QTimer>
 #include <QCommandLineParser>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
 #include <QTemporaryDir>
 
 #include "lib/await.h"
+#include "lib/buildmatrix.h"
 #include "lib/exewrapper.h"
+#include "lib/loadsnapshot.h"
 #include "lib/importexportutils.h"
 #include "lib/configuration.h"
 #include "lib/riivolution.h"
+#include "lib/tracing.h"
 #include "lib/mods/csmmmodpack.h"
 #include "lib/mods/modloader.h"
 #include "lib/mods/defaultmodlist.h"
@@ -31,7 +40,92 @@ static std::unique_ptr<QTextStream> cerrp;
 
 static QBuffer placeholderBuffer;
 
-void run(QStringList arguments)
+static const QString DEFAULT_SERVER_NAME = "csmm";
+
+/**
+ * @brief Thrown instead of calling exit() so that a failing command does not take down csmm serve.
+ */
+struct CommandExit {
+    int code;
+};
+
+static void processArguments(QCommandLineParser &parser, const QStringList &arguments) {
+    if (!parser.parse(arguments)) {
+        qCritical().noquote() << parser.errorText();
+        throw CommandExit{1};
+    }
+}
+
+/**
+ * @brief Mods and loaded game directories which csmm serve keeps between jobs.
+ */
+struct ResidentState {
+    bool enabled = false;
+    struct Modpack {
+        QDateTime lastModified;
+        qint64 size;
+        ModListType mods;
+    };
+    QHash<QString, Modpack> modpacks;
+    struct Game {
+        QByteArray stamp;
+        std::vector<MapDescriptor> descriptors;
+    };
+    QHash<QString, Game> games;
+};
+
+static ResidentState resident;
+
+static ModListType importModpack(const QString &modpackFile) {
+    if (!resident.enabled) {
+        return ModLoader::importModpackFile(modpackFile);
+    }
+    QFileInfo modpackInfo(modpackFile);
+    QString key = modpackFile.isEmpty() ? QString() : modpackInfo.absoluteFilePath();
+    auto it = resident.modpacks.find(key);
+    if (it != resident.modpacks.end() && it->lastModified == modpackInfo.lastModified() && it->size == modpackInfo.size()) {
+        return it->mods;
+    }
+    auto mods = ModLoader::importModpackFile(modpackFile);
+    resident.modpacks[key] = {modpackInfo.lastModified(), modpackInfo.size(), mods};
+    return mods;
+}
+
+/**
+ * @brief Loads the map descriptors of the game directory with the mods of the modpack.
+ * The descriptors are read from the load snapshot of the game directory if the files the mods load from have not
+ * changed since. Under csmm serve they are additionally kept in memory until any file of the game directory changes.
+ */
+static std::vector<MapDescriptor> loadMapDescriptors(const QDir &sourceDir, const QString &modpackFile) {
+    auto mods = importModpack(modpackFile);
+    auto dependencies = CSMMModpack::fileDependencies(mods.begin(), mods.end());
+    await(ExeWrapper::extractMissingFiles(sourceDir.path(), dependencies));
+    auto fingerprint = LoadSnapshot::fingerprint(sourceDir, dependencies, modpackFile);
+    auto key = sourceDir.absolutePath();
+    QByteArray stamp;
+    if (resident.enabled) {
+        stamp = fingerprint + LoadSnapshot::treeStamp(sourceDir);
+        auto it = resident.games.find(key);
+        if (it != resident.games.end() && it->stamp == stamp) {
+            qDebug() << "Using the resident state of" << sourceDir.path();
+            return it->descriptors;
+        }
+    }
+    std::vector<MapDescriptor> descriptors;
+    if (!LoadSnapshot::read(sourceDir, fingerprint, descriptors)) {
+        auto gameInstance = GameInstance::fromGameDirectory(sourceDir.path(), "");
+        CSMMModpack modpack(gameInstance, mods.begin(), mods.end());
+        modpack.load(sourceDir.path());
+        descriptors = gameInstance.mapDescriptors();
+        LoadSnapshot::write(sourceDir, fingerprint, descriptors);
+    }
+    if (resident.enabled) {
+        resident.games[key] = {stamp, descriptors};
+    }
+    return descriptors;
+}
+
+static void executeCommand(const QStringList &arguments, QIODevice *out, QIODevice *err)
 {
     auto description = QString(R"(
     ****************************************************************
@@ -64,10 +158,14 @@ void run(QStringList arguments)
   discard         Discard the pending changes in a Fortune Street game directory.
   save            Save the pending changes in a Fortune Street game directory.
   pack            Pack a Fortune Street game directory to a disc image (pending changes must be saved prior).
+  build-matrix    Build every combination of base images, modpacks, map lists and output formats listed in a matrix file
+  convert-maplist Convert a map list between the yaml, csv and binary (*.csml) formats
   default-modlist Output a list of default mod ids
   riivolution     Create a Riivolution patch file from vanilla and patched game folders (WARNING: modifies the patched game folder)
   bsdiff          Create a .bsdiff file
   bspatch         Patch an existing file using a .bsdiff file
+  serve           Keep the Python interpreter, mods and loaded game directories resident and run commands sent by csmm client
+  client          Run a command in a running csmm serve, e.g. csmm client -- status <gameDir>
 )").remove(0,1);
 
     parser.setOptionsAfterPositionalArgumentsMode(QCommandLineParser::ParseAsOptions);
@@ -88,9 +186,11 @@ void run(QStringList arguments)
     QCommandLineOption mapZoneOption(QStringList() << "z" << "zone", "The <zone> of the map. 0=Super Mario Tour, 1=Dragon Quest Tour, 2=Special Tour.", "zone");
     QCommandLineOption modPackOption(QStringList() << "modpack", "The modpack file (.zip or modlist.txt) to load (leave blank for default).", "modpack");
     QCommandLineOption mapDescriptorConfigurationOption(QStringList() << "descCfg" << "descriptorCfg" << "descConfiguration" << "descriptorConfiguration", "The map description configuration .csv to use for saving instead of the default.", "descCfg", "");
+    QCommandLineOption traceOption(QStringList() << "trace", "Record a timeline of the command in Chrome trace-event format (chrome://tracing, Perfetto) to <file>.", "file");
     QCommandLineOption helpOption(QStringList() << "h" << "?" << "help", "Show the help");
     // add some generic options
     parser.addOption(helpOption);
+    parser.addOption(traceOption);
     parser.addOption(quietOption);
     parser.addOption(verboseOption);
     quietOption.setDescription(verboseOption.description()); // add a linebreak at the last generic option
@@ -98,35 +198,27 @@ void run(QStringList arguments)
     // Call parse()
     parser.parse(arguments);
 
-    placeholderBuffer.open(QIODevice::ReadWrite);
-    coutp = parser.isSet(quietOption)
-            ? std::make_unique<QTextStream>(&placeholderBuffer) : std::make_unique<QTextStream>(stdout);
+    if (!placeholderBuffer.isOpen()) {
+        placeholderBuffer.open(QIODevice::ReadWrite);
+    }
+    placeholderBuffer.seek(0);
+    coutp = std::make_unique<QTextStream>(parser.isSet(quietOption) ? &placeholderBuffer : out);
     auto &cout = *coutp;
-    cerrp = parser.isSet(quietOption)
-            ? std::make_unique<QTextStream>(&placeholderBuffer) : std::make_unique<QTextStream>(stderr);
+    cerrp = std::make_unique<QTextStream>(parser.isSet(quietOption) ? &placeholderBuffer : err);
     auto &cerr = *cerrp;
     QTextStream &helpStream = parser.isSet(helpOption) ? cout : cerr;
 
-    atexit([]() { // hack: manually set these to nullptr to prevent weird segfaults on macos
-        coutp = nullptr;
-        cerrp = nullptr;
-    });
-
     _isQuiet = parser.isSet(quietOption);
     _isVerbose = parser.isSet(verboseOption);
 
-    // add logging handler to deal with quiet/verbose options
-    qInstallMessageHandler([](QtMsgType type, const QMessageLogContext &context, const QString &msg) {
-        if (!_isQuiet && (_isVerbose || (type != QtMsgType::QtDebugMsg && type != QtMsgType::QtWarningMsg))) {
-            *cerrp << msg << Qt::endl;
-        }
-    });
-
-    pybind11::scoped_interpreter guard{};
+    if (parser.isSet(traceOption)) {
+        Tracing::start(parser.value(traceOption));
+    }
 
     try {
         const QStringList args = parser.positionalArguments();
         const QString command = args.isEmpty() ? QString() : args.first();
+        Tracing::Span commandSpan("command", command);
 
         if (command.isEmpty()) {
             helpStream << description;
@@ -143,9 +235,12 @@ void run(QStringList arguments)
 
             parser.addPositionalArgument("source", "Source Fortune Street game disc image (.wbfs, .iso).", "extract <source>");
             parser.addPositionalArgument("extractDir", "Target directory to be the container of the Fortune Street game disc.\n[default = <workingDirectory>/<sourceFilename>]", "[extractDir]");
+            QCommandLineOption workingSetOption(QStringList() << "workingSet", "Only extract the files needed by the mods of the modpack (see --modpack). The remaining files are extracted from the disc image when needed, e.g. by csmm pack.");
             parser.addOption(forceOption);
+            parser.addOption(workingSetOption);
+            parser.addOption(modPackOption);
 
-            parser.process(arguments);
+            processArguments(parser, arguments);
             const QStringList args = parser.positionalArguments();
             if(parser.isSet(helpOption) || args.size() < 2) {
                 helpStream << '\n' << parser.helpText();
@@ -154,10 +249,10 @@ void run(QStringList arguments)
                 QFileInfo sourceFileInfo(source);
                 if(!sourceFileInfo.exists()) {
                     qCritical() << source << "does not exist.";
-                    exit(1);
+                    throw CommandExit{1};
                 } else if(!sourceFileInfo.isFile()) {
                     qCritical() << source << "is not a file.";
-                    exit(1);
+                    throw CommandExit{1};
                 }
                 const QString target = args.size() >= 3 ? args.at(2) : QDir::current().filePath(sourceFileInfo.baseName());
                 const QDir targetDir(target);
@@ -167,12 +262,17 @@ void run(QStringList arguments)
                         qInfo() << "Overwriting" << target << "...";
                     } else {
                         qCritical() << "Cannot extract as" << target << "already exists. Use force option to overwrite.";
-                        exit(1);
+                        throw CommandExit{1};
                     }
                 } else {
                     targetDir.mkpath(".");
                 }
-                await(ExeWrapper::extractWbfsIso(source, target));
+                if(parser.isSet(workingSetOption)) {
+                    auto mods = importModpack(parser.value(modPackOption));
+                    await(ExeWrapper::extractWbfsIso(source, target, CSMMModpack::fileDependencies(mods.begin(), mods.end())));
+                } else {
+                    await(ExeWrapper::extractWbfsIso(source, target));
+                }
             }
         } else if (command == "export") {
             // --- export ---
@@ -186,7 +286,7 @@ void run(QStringList arguments)
             parser.addOption(internalNamesOption);
             parser.addOption(modPackOption);
 
-            parser.process(arguments);
+            processArguments(parser, arguments);
             const QStringList args = parser.positionalArguments();
             if(parser.isSet(helpOption) || args.size() < 2) {
                 helpStream << '\n' << parser.helpText();
@@ -195,21 +295,17 @@ void run(QStringList arguments)
                 const QDir sourceDir(source);
                 if(!sourceDir.exists()) {
                     qCritical() << source << "does not exist.";
-                    exit(1);
+                    throw CommandExit{1};
                 }
                 const QString target = args.size() >= 3? args.at(2) : QDir::current().path();
                 QDir targetDir(target);
                 if(!targetDir.exists()) {
                     targetDir.mkpath(".");
                 }
-                auto gameInstance = GameInstance::fromGameDirectory(sourceDir.path(), "");
-                auto mods = ModLoader::importModpackFile(parser.value(modPackOption));
-                CSMMModpack modpack(gameInstance, mods.first.begin(), mods.first.end());
-                modpack.load(sourceDir.path());
-                auto descriptors = gameInstance.mapDescriptors();
+                auto descriptors = loadMapDescriptors(sourceDir, parser.value(modPackOption));
                 if (descriptors.empty()) {
                     qCritical() << " no maps were found in " << source;
-                    exit(1);
+                    throw CommandExit{1};
                 }
                 QString internalNames = parser.value(internalNamesOption);
                 QStringList internalNamesList = internalNames.split(",");
@@ -256,7 +352,7 @@ void run(QStringList arguments)
             parser.addOption(mapPracticeBoardOption);
             parser.addOption(modPackOption);
 
-            parser.process(arguments);
+            processArguments(parser, arguments);
 
             std::optional<int> mapId, mapSet, mapZone, mapOrder, mapPracticeBoard;
             if(parser.isSet(mapIdOption)) mapId.emplace(parser.value(mapIdOption).toInt());
@@ -273,24 +369,20 @@ void run(QStringList arguments)
                 const QDir sourceDir(source);
                 if(!sourceDir.exists()) {
                     qCritical() << source << "does not exist.";
-                    exit(1);
+                    throw CommandExit{1};
                 }
                 const QString yaml = args.at(2);
                 const QFile yamlFile(yaml);
                 if(!yamlFile.exists()) {
                     qCritical() << yaml << "does not exist.";
-                    exit(1);
+                    throw CommandExit{1};
                 }
                 QFile file(sourceDir.filePath("csmm_pending_changes.yaml"));
                 if(!file.exists()) {
-                    auto gameInstance = GameInstance::fromGameDirectory(sourceDir.path(), "");
-                    auto mods = ModLoader::importModpackFile(parser.value(modPackOption));
-                    CSMMModpack modpack(gameInstance, mods.first.begin(), mods.first.end());
-                    modpack.load(sourceDir.path());
-                    auto descriptors = gameInstance.mapDescriptors();
+                    auto descriptors = loadMapDescriptors(sourceDir, parser.value(modPackOption));
                     if(descriptors.empty()) {
                         qCritical() << " no maps were found in " << source;
-                        exit(1);
+                        throw CommandExit{1};
                     }
                     Configuration::save(sourceDir.filePath("csmm_pending_changes.yaml"), descriptors);
                 }
@@ -304,7 +396,7 @@ void run(QStringList arguments)
             parser.addPositionalArgument("gameDir", "Fortune Street game directory.", "status <gameDir>");
             parser.addOption(modPackOption);
 
-            parser.process(arguments);
+            processArguments(parser, arguments);
 
             const QStringList args = parser.positionalArguments();
             if(parser.isSet(helpOption) || args.size() < 2) {
@@ -314,20 +406,16 @@ void run(QStringList arguments)
                 const QDir sourceDir(source);
                 if(!sourceDir.exists()) {
                     qCritical() << source << "does not exist.";
-                    exit(1);
+                    throw CommandExit{1};
                 }
                 QFile file(sourceDir.filePath("csmm_pending_changes.yaml"));
                 if(file.exists()) {
                     cout << Configuration::status(sourceDir.filePath("csmm_pending_changes.yaml"));
                 } else {
-                    auto gameInstance = GameInstance::fromGameDirectory(sourceDir.path(), "");
-                    auto mods = ModLoader::importModpackFile(parser.value(modPackOption));
-                    CSMMModpack modpack(gameInstance, mods.first.begin(), mods.first.end());
-                    modpack.load(sourceDir.path());
-                    auto descriptors = gameInstance.mapDescriptors();
+                    auto descriptors = loadMapDescriptors(sourceDir, parser.value(modPackOption));
                     if (descriptors.empty()) {
                         qCritical() << " no maps were found in " << source;
-                        exit(1);
+                        throw CommandExit{1};
                     }
                     cout << Configuration::status(descriptors, sourceDir.filePath("csmm_pending_changes.yaml"));
                     qInfo() << "There are no pending changes";
@@ -340,7 +428,7 @@ void run(QStringList arguments)
             parser.addOption(modPackOption);
             parser.addOption(mapDescriptorConfigurationOption);
 
-            parser.process(arguments);
+            processArguments(parser, arguments);
             const QStringList args = parser.positionalArguments();
             if(parser.isSet(helpOption) || args.size() < 2) {
                 helpStream << '\n' << parser.helpText();
@@ -349,7 +437,7 @@ void run(QStringList arguments)
                 const QDir sourceDir(source);
                 if(!sourceDir.exists()) {
                     qCritical() << source << "does not exist.";
-                    exit(1);
+                    throw CommandExit{1};
                 }
                 auto cfgPath = parser.value(mapDescriptorConfigurationOption);
                 if (cfgPath.isEmpty()) {
@@ -359,17 +447,18 @@ void run(QStringList arguments)
                     QTemporaryDir importDir;
                     if (!importDir.isValid()) {
                         qCritical() << "Could not create temporary directory for importing descriptors." << importDir.errorString();
-                        exit(1);
+                        throw CommandExit{1};
                     }
                     auto gameInstance = GameInstance::fromGameDirectory(sourceDir.path(), importDir.path());
-                    auto mods = ModLoader::importModpackFile(parser.value(modPackOption));
-                    CSMMModpack modpack(gameInstance, mods.first.begin(), mods.first.end());
+                    auto mods = importModpack(parser.value(modPackOption));
+                    await(ExeWrapper::extractMissingFiles(sourceDir.path(), CSMMModpack::fileDependencies(mods.begin(), mods.end())));
+                    CSMMModpack modpack(gameInstance, mods.begin(), mods.end());
                     modpack.load(sourceDir.path());
                     auto &descriptors = gameInstance.mapDescriptors();
                     try {
                         Configuration::load(cfgPath, descriptors, importDir.path());
 
-                        if (std::any_of(mods.first.begin(), mods.first.end(), [](auto &mod) { return mod->modId() == "wifiFix"; })) {
+                        if (std::any_of(mods.begin(), mods.end(), [](auto &mod) { return mod->modId() == "wifiFix"; })) {
                             qInfo() << "**> The game will be saved with Wiimmfi text replacing WFC. Wiimmfi will only be patched after packing it to a wbfs/iso using csmm pack command.";
                         }
                         modpack.save(sourceDir.path());
@@ -377,7 +466,7 @@ void run(QStringList arguments)
                         qInfo() << "Pending changes have been saved";
                     } catch (const std::runtime_error &exception) {
                         qCritical() << "Error loading the map:" << exception.what();
-                        exit(1);
+                        throw CommandExit{1};
                     }
                 } else {
                     qCritical() << "There are no pending changes to save. Run csmm import first.";
@@ -388,7 +477,7 @@ void run(QStringList arguments)
             setupSubcommand(parser, "discard", "Discard the pending changes.");
             parser.addPositionalArgument("gameDir", "Fortune Street game directory.", "discard <gameDir>");
 
-            parser.process(arguments);
+            processArguments(parser, arguments);
 
             const QStringList args = parser.positionalArguments();
             if(parser.isSet(helpOption) || args.size() < 2) {
@@ -398,7 +487,7 @@ void run(QStringList arguments)
                 const QDir sourceDir(source);
                 if(!sourceDir.exists()) {
                     qCritical() << source << "does not exist.";
-                    exit(1);
+                    throw CommandExit{1};
                 }
                 QFile file(sourceDir.filePath("csmm_pending_changes.yaml"));
                 if(file.exists()) {
@@ -406,7 +495,7 @@ void run(QStringList arguments)
                     qInfo() << "Pending changes have been discarded";
                 } else {
                     qCritical() << "There are no pending changes to discard";
-                    exit(1);
+                    throw CommandExit{1};
                 }
             }
         } else if (command == "riivolution") {
@@ -414,7 +503,7 @@ void run(QStringList arguments)
             parser.addPositionalArgument("vanillaDir", "Vanilla Fortune Street directory.", "pack <vanillaDir>");
             parser.addPositionalArgument("patchedDir", "Patched Fortune Street directory. (WARNING: modifies the patched game folder)", "<patchedDir>");
 
-            parser.process(arguments);
+            processArguments(parser, arguments);
 
             const QStringList args = parser.positionalArguments();
             if (parser.isSet(helpOption) || args.size() < 3) {
@@ -425,13 +514,13 @@ void run(QStringList arguments)
                 const QString patchName = QDir(patchedDir).dirName();
                 if (!Riivolution::validateRiivolutionName(patchName)) {
                     qCritical() << "patch name" << patchName << "is invalid";
-                    exit(1);
+                    throw CommandExit{1};
                 }
                 auto vanillaInst = GameInstance::fromGameDirectory(vanillaDir, "");
                 auto patchedInst = GameInstance::fromGameDirectory(patchedDir, "");
                 if (vanillaInst.addressMapper().getVersion() != patchedInst.addressMapper().getVersion()) {
                     qCritical() << "version mismatch between vanilla and patched roms";
-                    exit(1);
+                    throw CommandExit{1};
                 }
                 Riivolution::write(vanillaDir, QFileInfo(patchedDir).dir(), vanillaInst.addressMapper(), patchName);
             }
@@ -441,11 +530,14 @@ void run(QStringList arguments)
             parser.addPositionalArgument("gameDir", "Fortune Street game directory.", "pack <gameDir>");
             parser.addPositionalArgument("target", "Target filename.\n[default = <gameId6>.wbfs]", "[target]");
 
+            QCommandLineOption verifyWiimmfiOption(QStringList() << "verifyWiimmfi", "If set and Wiimmfi is patched, additionally pack the image the two-pass way (pack, then patch Wiimmfi) and verify that both images are identical.");
+
             parser.addOption(markerCodeOption);
             parser.addOption(separateSaveGameOption);
+            parser.addOption(verifyWiimmfiOption);
             parser.addOption(forceOption);
 
-            parser.process(arguments);
+            processArguments(parser, arguments);
 
             const QStringList args = parser.positionalArguments();
             if(parser.isSet(helpOption) || args.size() < 2) {
@@ -455,7 +547,7 @@ void run(QStringList arguments)
                 const QDir sourceDir(source);
                 if(!sourceDir.exists()) {
                     qCritical() << source << "does not exist.";
-                    exit(1);
+                    throw CommandExit{1};
                 }
 
                 QString markerCode = parser.isSet(markerCodeOption) ? parser.value(markerCodeOption) : "02";
@@ -474,7 +566,7 @@ void run(QStringList arguments)
                         qInfo() << "Overwriting" << target << "...";
                     } else {
                         qCritical() << "Cannot extract as" << target << "already exists. Use force option to overwrite.";
-                        exit(1);
+                        throw CommandExit{1};
                     }
                 }
                 QFileInfo targetInfo(target);
@@ -486,13 +578,89 @@ void run(QStringList arguments)
 
                 qInfo() << "Creating" << targetInfo.suffix() << "file at" << target << "out from" << source << "...";
 
+                // the rest of a partially extracted directory is extracted next to the image when packing
+                await(ExeWrapper::extractMissingFiles(source, {uiMessageCsv("en")}));
                 bool patchWiimmfi = ImportExportUtils::hasWiimmfiText(sourceDir);
-                await(ExeWrapper::createWbfsIso(source, target, markerCode, parser.isSet(separateSaveGameOption)));
-                if(patchWiimmfi) {
-                    await(ExeWrapper::patchWiimmfi(target));
+                await(ExeWrapper::createWbfsIso(source, target, markerCode, parser.isSet(separateSaveGameOption), patchWiimmfi));
+
+                if(patchWiimmfi && parser.isSet(verifyWiimmfiOption)) {
+                    QTemporaryDir verifyDir(targetDir.filePath("csmm_verify_XXXXXX"));
+                    if(!verifyDir.isValid()) {
+                        qCritical() << "Could not create temporary directory for verification.";
+                        throw CommandExit{1};
+                    }
+                    QString twoPassTarget = QDir(verifyDir.path()).filePath(targetInfo.fileName());
+                    qInfo() << "Verifying against two-pass Wiimmfi patching...";
+                    await(ExeWrapper::createWbfsIso(source, twoPassTarget, markerCode, parser.isSet(separateSaveGameOption)));
+                    await(ExeWrapper::patchWiimmfi(twoPassTarget));
+                    if(!await(ExeWrapper::compareWbfsIso(target, twoPassTarget))) {
+                        qCritical() << "Verification failed:" << target << "differs from the image patched in two passes.";
+                        throw CommandExit{1};
+                    }
+                    qInfo() << "Verification succeeded.";
                 }
 
             }
+        } else if (command == "build-matrix") {
+            // --- build-matrix ---
+            setupSubcommand(parser, "build-matrix", "Build the variants of a build matrix file (*.yaml) in one run. Each base image is extracted once and the\n"
+                                                    "mods, the vanilla maps and the downloads of a map list are shared between the variants.");
+            parser.addPositionalArgument("matrix", "The build matrix file.", "build-matrix <matrix>");
+            parser.addPositionalArgument("outputDir", "The directory to write the variants to.\n[default = <current directory>/build]", "[outputDir]");
+
+            QCommandLineOption jobsOption(QStringList() << "j" << "jobs", "The maximum number of disc images packed at the same time. Default is 2.", "jobs", "2");
+            parser.addOption(jobsOption);
+            parser.addOption(forceOption);
+
+            processArguments(parser, arguments);
+
+            const QStringList args = parser.positionalArguments();
+            if (parser.isSet(helpOption) || args.size() < 2) {
+                helpStream << '\n' << parser.helpText();
+            } else {
+                const QString outputDir = args.size() > 2 ? args.at(2) : QDir::current().filePath("build");
+                bool ok;
+                int jobs = parser.value(jobsOption).toInt(&ok);
+                if (!ok || jobs < 1) {
+                    qCritical() << "jobs must be a positive number";
+                    throw CommandExit{1};
+                }
+                auto matrix = BuildMatrix::parse(args.at(1));
+                cout << "Building " << matrix.variants.size() << " variants into " << outputDir << "\n";
+                cout.flush();
+                auto outputs = BuildMatrix::build(matrix, outputDir, jobs, parser.isSet(forceOption));
+                for (int i = 0; i < outputs.size(); ++i) {
+                    cout << BuildMatrix::formatToString(matrix.variants[i].format) << "\t" << outputs[i] << "\n";
+                }
+            }
+        } else if (command == "convert-maplist") {
+            // --- convert-maplist ---
+            setupSubcommand(parser, "convert-maplist", "Convert a map list to another format. The format is chosen by the file extension: *.yaml, *.csv or *.csml\n"
+                                                       "for the binary format, which loads faster for large map lists and can embed the map descriptors.");
+            parser.addPositionalArgument("input", "The map list to convert.", "convert-maplist <input>");
+            parser.addPositionalArgument("output", "The converted map list.", "<output>");
+
+            QCommandLineOption embedOption(QStringList() << "e" << "embed", "Embed the map descriptors and .frb files into a binary map list.");
+            parser.addOption(embedOption);
+            parser.addOption(forceOption);
+
+            processArguments(parser, arguments);
+
+            const QStringList args = parser.positionalArguments();
+            if (parser.isSet(helpOption) || args.size() < 3) {
+                helpStream << '\n' << parser.helpText();
+            } else {
+                if (!QFileInfo::exists(args.at(1))) {
+                    qCritical() << args.at(1) << "does not exist.";
+                    throw CommandExit{1};
+                }
+                if (QFileInfo::exists(args.at(2)) && !parser.isSet(forceOption)) {
+                    qCritical() << args.at(2) << "already exists. Use -f to overwrite.";
+                    throw CommandExit{1};
+                }
+                Configuration::convert(args.at(1), args.at(2), parser.isSet(embedOption));
+                qInfo() << "Converted" << args.at(1) << "to" << args.at(2);
+            }
         } else if (command == "bsdiff") {
             // --- bsdiff ---
             setupSubcommand(parser, "bsdiff", "Create a .bsdiff file");
@@ -502,7 +670,7 @@ void run(QStringList arguments)
 
             parser.addOption(forceOption);
 
-            parser.process(arguments);
+            processArguments(parser, arguments);
 
             const QStringList args = parser.positionalArguments();
             if(parser.isSet(helpOption) || args.size() < 3) {
@@ -513,14 +681,14 @@ void run(QStringList arguments)
                 const QFileInfo oldFileInfo = QFileInfo(oldFile);
                 if(!oldFile.exists()) {
                     qCritical() << oldFileStr << "does not exist.";
-                    exit(1);
+                    throw CommandExit{1};
                 }
                 const QString newFileStr = args.at(2);
                 const QFile newFile = QFile(newFileStr);
                 const QFileInfo newFileInfo(newFile);
                 if(!newFile.exists()) {
                     qCritical() << newFileStr << "does not exist.";
-                    exit(1);
+                    throw CommandExit{1};
                 }
                 QString bsdiffFileStr;
                 if(args.size() >= 4) {
@@ -535,7 +703,7 @@ void run(QStringList arguments)
                         qInfo() << "Overwriting" << bsdiffFileInfo.filePath() << "...";
                     } else {
                         qCritical() << "Cannot create .bsdiff file as" << bsdiffFileInfo.filePath() << "already exists. Use force option to overwrite.";
-                        exit(1);
+                        throw CommandExit{1};
                     }
                 }
 
@@ -549,7 +717,7 @@ void run(QStringList arguments)
                 QString errors = ImportExportUtils::createBsdiff(oldFileInfo.absoluteFilePath(), newFileInfo.absoluteFilePath(), bsdiffFileInfo.absoluteFilePath());
                 if(!errors.isEmpty()) {
                     qCritical() << errors;
-                    exit(1);
+                    throw CommandExit{1};
                 }
             }
         } else if (command == "bspatch") {
@@ -560,7 +728,7 @@ void run(QStringList arguments)
             parser.addPositionalArgument("bsdiffFile", "Input .bsdiff file.", "<bsdiffFile>");
             parser.addOption(forceOption);
 
-            parser.process(arguments);
+            processArguments(parser, arguments);
 
             const QStringList args = parser.positionalArguments();
             if(parser.isSet(helpOption) || args.size() < 3) {
@@ -571,7 +739,7 @@ void run(QStringList arguments)
                 const QFileInfo oldFileInfo = QFileInfo(oldFile);
                 if(!oldFile.exists()) {
                     qCritical() << oldFileStr << "does not exist.";
-                    exit(1);
+                    throw CommandExit{1};
                 }
                 const QString newFileStr = args.at(2);
                 const QFile newFile = QFile(newFileStr);
@@ -581,7 +749,7 @@ void run(QStringList arguments)
                         qInfo() << "Overwriting" << newFileInfo.filePath() << "...";
                     } else {
                         qCritical() << "Cannot patch as" << newFileInfo.filePath() << "already exists. Use force option to overwrite.";
-                        exit(1);
+                        throw CommandExit{1};
                     }
                 }
                 QString bsdiffFileStr = args.at(3);
@@ -589,7 +757,7 @@ void run(QStringList arguments)
                 QFileInfo bsdiffFileInfo(bsdiffFile);
                 if(!bsdiffFile.exists()) {
                     qCritical() << newFileStr << "does not exist.";
-                    exit(1);
+                    throw CommandExit{1};
                 }
 
                 QDir bsdiffFileDir(bsdiffFileInfo.dir());
@@ -602,7 +770,7 @@ void run(QStringList arguments)
                 QString errors = ImportExportUtils::applyBspatch(oldFileInfo.absoluteFilePath(), newFileInfo.absoluteFilePath(), bsdiffFileInfo.absoluteFilePath());
                 if(!errors.isEmpty()) {
                     qCritical() << errors;
-                    exit(1);
+                    throw CommandExit{1};
                 }
             }
         } else {
@@ -612,8 +780,181 @@ void run(QStringList arguments)
         }
     } catch (const std::runtime_error &error) {
         qCritical() << error.what();
-        exit(1);
+        throw CommandExit{1};
+    }
+}
+
+/**
+ * @brief Runs a command with its output written to out and err.
+ * @return the exit code of the command
+ */
+static int runCommand(const QStringList &arguments, QIODevice *out, QIODevice *err) {
+    int exitCode = 0;
+    try {
+        executeCommand(arguments, out, err);
+    } catch (const CommandExit &commandExit) {
+        exitCode = commandExit.code;
+    } catch (const std::exception &exception) {
+        qCritical() << exception.what();
+        exitCode = 1;
+    }
+    Tracing::stop();
+    if (coutp) coutp->flush();
+    if (cerrp) cerrp->flush();
+    coutp = nullptr;
+    cerrp = nullptr;
+    _isQuiet = false;
+    _isVerbose = false;
+    return exitCode;
+}
+
+static QString socketName(const QStringList &arguments, QCommandLineParser &parser, const QCommandLineOption &socketOption) {
+    processArguments(parser, arguments);
+    return parser.isSet(socketOption) ? parser.value(socketOption) : DEFAULT_SERVER_NAME;
+}
+
+/**
+ * @brief Serves jobs of the form {"args": [...], "cwd": "..."} sent as one json line each and answers every job
+ * with {"exitCode": ..., "stdout": "...", "stderr": "..."}. Jobs are run one at a time in the order they arrive.
+ */
+static int serve(const QStringList &arguments) {
+    QCommandLineParser parser;
+    setupSubcommand(parser, "serve", "Keep the Python interpreter, the mods and the loaded game directories resident and run commands sent by csmm client.");
+    QCommandLineOption socketOption(QStringList() << "socket", "The name of the local socket to listen on.", "socket", DEFAULT_SERVER_NAME);
+    parser.addOption(socketOption);
+    auto name = socketName(arguments, parser, socketOption);
+
+    QLocalServer server;
+    server.setSocketOptions(QLocalServer::UserAccessOption);
+    QLocalServer::removeServer(name);
+    if (!server.listen(name)) {
+        qCritical() << "Could not listen on" << name << ":" << server.errorString();
+        return 1;
     }
+    resident.enabled = true;
+    qInfo() << "Listening on" << server.fullServerName();
+
+    QList<QPair<QPointer<QLocalSocket>, QByteArray>> jobs;
+    bool busy = false;
+    std::function<void()> runJobs = [&]() {
+        // commands spin nested event loops while awaiting, so jobs arriving meanwhile are queued
+        if (busy) return;
+        busy = true;
+        while (!jobs.isEmpty()) {
+            auto job = jobs.takeFirst();
+            auto request = QJsonDocument::fromJson(job.second).object();
+            QStringList jobArguments{QCoreApplication::applicationFilePath()};
+            for (auto arg: request["args"].toArray()) {
+                jobArguments << arg.toString();
+            }
+            QString previousDir = QDir::currentPath();
+            if (request.contains("cwd")) {
+                QDir::setCurrent(request["cwd"].toString());
+            }
+            QBuffer out, err;
+            out.open(QIODevice::WriteOnly);
+            err.open(QIODevice::WriteOnly);
+            int exitCode = runCommand(jobArguments, &out, &err);
+            QDir::setCurrent(previousDir);
+            if (job.first) {
+                QJsonObject response{
+                    {"exitCode", exitCode},
+                    {"stdout", QString::fromUtf8(out.data())},
+                    {"stderr", QString::fromUtf8(err.data())}
+                };
+                job.first->write(QJsonDocument(response).toJson(QJsonDocument::Compact) + "\n");
+                job.first->flush();
+            }
+        }
+        busy = false;
+    };
+    QObject::connect(&server, &QLocalServer::newConnection, &server, [&]() {
+        while (auto socket = server.nextPendingConnection()) {
+            QObject::connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+            QObject::connect(socket, &QLocalSocket::readyRead, socket, [&, socket]() {
+                while (socket->canReadLine()) {
+                    jobs.append({socket, socket->readLine().trimmed()});
+                }
+                QTimer::singleShot(0, &server, runJobs);
+            });
+        }
+    });
+    return QCoreApplication::exec();
+}
+
+/**
+ * @brief Sends the command to csmm serve and prints its output, so no Python interpreter is started.
+ */
+static int runClient(const QStringList &arguments) {
+    QCommandLineParser parser;
+    setupSubcommand(parser, "client", "Run a command in a running csmm serve instead of in this process, e.g.\n  csmm client -- status <gameDir>");
+    parser.addPositionalArgument("client", QString(), "client");
+    parser.addPositionalArgument("command", "The command with its arguments and options.", "-- <command> [<args>...]");
+    QCommandLineOption socketOption(QStringList() << "socket", "The name of the local socket csmm serve listens on.", "socket", DEFAULT_SERVER_NAME);
+    parser.addOption(socketOption);
+    QCommandLineOption helpOption(QStringList() << "h" << "?" << "help", "Show the help");
+    parser.addOption(helpOption);
+    auto name = socketName(arguments, parser, socketOption);
+    const QStringList args = parser.positionalArguments();
+    if (parser.isSet(helpOption) || args.size() < 2) {
+        QTextStream(stderr) << parser.helpText();
+        return parser.isSet(helpOption) ? 0 : 1;
+    }
+
+    QLocalSocket socket;
+    socket.connectToServer(name);
+    if (!socket.waitForConnected()) {
+        QTextStream(stderr) << "Could not connect to csmm serve at " << name << ": " << socket.errorString() << Qt::endl;
+        return 1;
+    }
+    QJsonObject request{
+        {"args", QJsonArray::fromStringList(args.mid(1))},
+        {"cwd", QDir::currentPath()}
+    };
+    socket.write(QJsonDocument(request).toJson(QJsonDocument::Compact) + "\n");
+    socket.flush();
+    while (!socket.canReadLine()) {
+        if (!socket.waitForReadyRead(-1)) {
+            QTextStream(stderr) << "Lost the connection to csmm serve: " << socket.errorString() << Qt::endl;
+            return 1;
+        }
+    }
+    auto response = QJsonDocument::fromJson(socket.readLine()).object();
+    QTextStream(stdout) << response["stdout"].toString();
+    QTextStream(stderr) << response["stderr"].toString();
+    return response["exitCode"].toInt(1);
+}
+
+int run(const QStringList &arguments)
+{
+    const QString command = arguments.size() >= 2 ? arguments.at(1) : QString();
+    if (command == "client") {
+        return runClient(arguments);
+    }
+
+    atexit([]() { // hack: manually set these to nullptr to prevent weird segfaults on macos
+        coutp = nullptr;
+        cerrp = nullptr;
+    });
+
+    // add logging handler to deal with quiet/verbose options
+    qInstallMessageHandler([](QtMsgType type, const QMessageLogContext &context, const QString &msg) {
+        static QTextStream serverErr(stderr);
+        if (!_isQuiet && (_isVerbose || (type != QtMsgType::QtDebugMsg && type != QtMsgType::QtWarningMsg))) {
+            (cerrp ? *cerrp : serverErr) << msg << Qt::endl;
+        }
+    });
+
+    pybind11::scoped_interpreter guard{};
+
+    if (command == "serve") {
+        return serve(arguments);
+    }
+
+    QFile out, err;
+    out.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered);
+    err.open(stderr, QIODevice::WriteOnly | QIODevice::Unbuffered);
+    return runCommand(arguments, &out, &err);
 }
 
 }
@@ -5,7 +5,11 @@
 
 namespace maincli {
 
-void run(const QStringList arguments);
+/**
+ * @brief Runs the command given by the command line arguments.
+ * @return the exit code
+ */
+int run(const QStringList &arguments);
 
 }
 
@@ -13,6 +13,7 @@
 #include "lib/configuration.h"
 #include "lib/csmmnetworkmanager.h"
 #include "lib/exewrapper.h"
+#include "lib/filecopy.h"
 #include "lib/importexportutils.h"
 #include "validationerrordialog.h"
 #include "lib/datafileset.h"
@@ -106,7 +107,7 @@ MainWindow::MainWindow(QWidget *parent)
             }
             try {
                 qInfo() << "Loading Modpacks: ";
-                std::tie(modList, tempModpackDirs) = ModLoader::importModpackCollection(modpackZips);
+                modList = ModLoader::importModpackCollection(modpackZips);
                 updateModListWidget();
                 QMessageBox::information(this, "Import modpack(s)", "Modpack(s) successfully imported.");
             } catch (const std::runtime_error &error) {
@@ -167,18 +168,23 @@ void MainWindow::loadMapList() {
     std::vector<MapDescriptor> descriptors;
     auto descriptorPtrs = ui->tableWidget->getDescriptors();
     std::transform(descriptorPtrs.begin(), descriptorPtrs.end(), std::back_inserter(descriptors), [](auto &ptr) { return *ptr; });
-    ui->statusbar->showMessage("Warning: This operation will import the maps in the map list one by one. Depending on the size of the map list, this can take a while and CSMM may freeze.");
+    ui->statusbar->showMessage("Warning: This operation will import the maps in the map list one by one. Depending on the size of the map list, this can take a while.");
     ui->statusbar->repaint();
-    CSMMProgressDialog progressDialog("Importing map list", QString(), 0, 100);
+    CSMMProgressDialog progressDialog("Importing map list", QString(), 0, 100, nullptr, Qt::WindowFlags(), true);
     progressDialog.setWindowModality(Qt::ApplicationModal);
     try {
-        Configuration::load(openFile, descriptors, importDir->path(), [&](double progress) {
-            progressDialog.setValue(100 * progress);
+        auto importDirPath = importDir->path();
+        progressDialog.runInWorker([&](const std::function<void(int)> &setProgress) {
+            Configuration::load(openFile, descriptors, importDirPath, [&](double progress) {
+                setProgress(100 * progress);
+            });
         });
         loadDescriptors(descriptors);
         ui->tableWidget->dirty = true;
         ui->statusbar->showMessage("Map list load completed");
         ui->statusbar->repaint();
+    } catch (const ProgressCanceled &) {
+        ui->statusbar->showMessage("Map list load canceled");
     } catch (const std::runtime_error &exception) {
         QMessageBox::critical(this, "Import Map List", QString("Error importing the map list: %1").arg(exception.what()));
     }
@@ -232,9 +238,12 @@ void MainWindow::openDir() {
     }
 
     auto copyTask = QtConcurrent::run([=]() {
-        std::error_code error;
-        std::filesystem::copy(dirname.toStdU16String(), newTempGameDir->path().toStdU16String(), std::filesystem::copy_options::recursive, error);
-        return error;
+        try {
+            FileCopy::copyTree(dirname, newTempGameDir->path());
+            return QString();
+        } catch (const FileCopy::Exception &e) {
+            return QString(e.what());
+        }
     });
     if (!ImportExportUtils::isMainDolVanilla(QDir(dirname))) {
         auto btn = QMessageBox::warning(this, "Non-vanilla main.dol detected",
@@ -250,17 +259,23 @@ void MainWindow::openDir() {
         progress.setWindowModality(Qt::WindowModal);
         progress.setValue(0);
 
-        auto gameInstance = GameInstance::fromGameDirectory(dirname, newTempImportDir->path());
-        CSMMModpack modpack(gameInstance, modList.begin(), modList.end());
-        modpack.load(dirname);
-        progress.setValue(1);
-        auto errorCode = await(copyTask);
+        std::vector<MapDescriptor> descriptors;
+        QString copyError;
+        progress.runInWorker([&](const std::function<void(int)> &setProgress) {
+            auto gameInstance = GameInstance::fromGameDirectory(dirname, newTempImportDir->path());
+            CSMMModpack modpack(gameInstance, modList.begin(), modList.end());
+            modpack.load(dirname);
+            descriptors = gameInstance.mapDescriptors();
+            setProgress(1);
+            copyTask.waitForFinished();
+            copyError = copyTask.result();
+        });
         progress.setValue(2);
-        if (errorCode) {
-            QMessageBox::critical(this, "Error loading game", QString::fromStdString("Error copying files to temporary working directory: " + errorCode.message()));
+        if (!copyError.isEmpty()) {
+            QMessageBox::critical(this, "Error loading game", "Error copying files to temporary working directory: " + copyError);
             return;
         }
-        loadDescriptors(gameInstance.mapDescriptors());
+        loadDescriptors(descriptors);
         setWindowFilePath(newTempGameDir->path());
         tempGameDir = newTempGameDir;
         importDir = newTempImportDir;
@@ -283,13 +298,18 @@ void MainWindow::openIsoWbfs() {
     if (isoWbfs.isEmpty()) return;
 
     try {
-        CSMMProgressDialog progress("Importing WBFS/ISO…", QString(), 0, 2, nullptr, Qt::WindowFlags(), true);
+        CSMMProgressDialog progress("Importing WBFS/ISO…", QString(), 0, 100, nullptr, Qt::WindowFlags(), true);
         progress.setWindowModality(Qt::WindowModal);
         progress.setValue(0);
 
-        await(ExeWrapper::extractWbfsIso(isoWbfs, newTempGameDir->path()));
+        progress.runInWorker([&](const std::function<void(int)> &setProgress) {
+            // only extract what the mods need; the rest is extracted from the image when exporting
+            await(ExeWrapper::extractWbfsIso(isoWbfs, newTempGameDir->path(), CSMMModpack::fileDependencies(modList.begin(), modList.end()), [&](double progressVal) {
+                setProgress(50 * progressVal);
+            }));
+        });
 
-        progress.setValue(1);
+        progress.setValue(50);
 
         if (!ImportExportUtils::isMainDolVanilla(newTempGameDir->path())) {
             auto btn = QMessageBox::warning(this, "Non-vanilla main.dol detected",
@@ -301,12 +321,16 @@ void MainWindow::openIsoWbfs() {
         }
         auto dirname = newTempGameDir->path();
 
-        auto gameInstance = GameInstance::fromGameDirectory(dirname, newTempImportDir->path());
-        CSMMModpack modpack(gameInstance, modList.begin(), modList.end());
-        modpack.load(dirname);
-        progress.setValue(2);
+        std::vector<MapDescriptor> descriptors;
+        progress.runInWorker([&](const std::function<void(int)> &) {
+            auto gameInstance = GameInstance::fromGameDirectory(dirname, newTempImportDir->path());
+            CSMMModpack modpack(gameInstance, modList.begin(), modList.end());
+            modpack.load(dirname);
+            descriptors = gameInstance.mapDescriptors();
+        });
+        progress.setValue(100);
 
-        loadDescriptors(gameInstance.mapDescriptors());
+        loadDescriptors(descriptors);
         setWindowFilePath(newTempGameDir->path());
         tempGameDir = newTempGameDir;
         importDir = newTempImportDir;
@@ -319,11 +343,7 @@ void MainWindow::openIsoWbfs() {
 }
 
 void MainWindow::loadDescriptors(const std::vector<MapDescriptor> &descriptors) {
-    ui->tableWidget->clearDescriptors();
-    for (auto &descriptor: descriptors) {
-        ui->tableWidget->appendMapDescriptor(descriptor);
-    }
-    ui->tableWidget->dirty = false;
+    ui->tableWidget->setDescriptors(descriptors);
     ui->mapToolbar->setEnabled(true);
     ui->importModPack->setEnabled(true);
     ui->actionValidate->setEnabled(true);
@@ -377,17 +397,30 @@ void MainWindow::exportToFolder(bool riivolution) {
                 progress.setWindowModality(Qt::WindowModal);
                 progress.setValue(0);
 
-                // need to use utf 16 b/c windows behaves strangely w/ utf 8
-                std::error_code error;
-                std::filesystem::copy(windowFilePath().toStdU16String(), saveDir.toStdU16String(), std::filesystem::copy_options::recursive, error);
-                if (error) {
+                auto gameDir = windowFilePath();
+                QString error;
+                progress.runInWorker([&](const std::function<void(int)> &) {
+                    try {
+                        FileCopy::copyTree(gameDir, saveDir);
+                    } catch (const FileCopy::Exception &e) {
+                        error = e.what();
+                        return;
+                    }
+                    // the exported folder is the complete game, so the rest is extracted there
+                    await(ExeWrapper::extractMissingFiles(saveDir));
+                });
+                if (!error.isEmpty()) {
                     progress.close();
-                    QMessageBox::critical(this, "Save", QString("Could not copy game data: %1").arg(error.message().c_str()));
+                    QMessageBox::critical(this, "Save", QString("Could not copy game data: %1").arg(error));
                 } else {
                     progress.setValue(100);
                     QMessageBox::information(this, "Save", "Saved successfuly.");
                 }
-            } catch (const ProgressCanceled &) { return; }
+            } catch (const ProgressCanceled &) {
+                return;
+            } catch (const std::runtime_error &e) {
+                QMessageBox::critical(this, "Save", QString("Save failed: %1").arg(e.what()));
+            }
             return;
         }
     }
@@ -411,39 +444,50 @@ void MainWindow::exportToFolder(bool riivolution) {
     try {
         progress.setValue(0);
 
-        std::error_code error;
-        std::filesystem::copy(windowFilePath().toStdU16String(), wiiSaveDir.toStdU16String(), std::filesystem::copy_options::recursive, error);
-
-        if (error) {
-            QMessageBox::critical(this, "Save", QString("Could not copy game data to temporary directory for modifying:\n%1").arg(error.message().c_str()));
-            return;
-        }
-
-        progress.setValue(30);
         std::vector<MapDescriptor> descriptors;
         auto descriptorPtrs = ui->tableWidget->getDescriptors();
         std::transform(descriptorPtrs.begin(), descriptorPtrs.end(), std::back_inserter(descriptors), [](auto &ptr) { return *ptr; });
+        auto gameDir = windowFilePath();
+        auto importDirPath = importDir->path();
 
+        progress.runInWorker([&](const std::function<void(int)> &setProgress) {
+            // a riivolution patch only needs the files the mods touch, whereas a folder needs the whole game
+            await(ExeWrapper::extractMissingFiles(gameDir, CSMMModpack::fileDependencies(modList.begin(), modList.end())));
 
-        auto gameInstance = GameInstance::fromGameDirectory(wiiSaveDir, importDir->path(), descriptors);
-        CSMMModpack modpack(gameInstance, modList.begin(), modList.end());
-        modpack.save(wiiSaveDir, [&](double progressVal) {
-            progress.setValue(30 + (90 - 30) * progressVal);
-        });
+            try {
+                FileCopy::copyTree(gameDir, wiiSaveDir);
+            } catch (const FileCopy::Exception &e) {
+                throw std::runtime_error(QString("Could not copy game data to temporary directory for modifying:\n%1").arg(e.what()).toStdString());
+            }
+            if (riivolution) {
+                QFile::remove(QDir(wiiSaveDir).filePath(SOURCE_IMAGE_FILE));
+            } else {
+                // unlike a disc image, an exported folder is the complete game
+                await(ExeWrapper::extractMissingFiles(wiiSaveDir));
+            }
 
-        if (riivolution) {
-            progress.setValue(90);
-            qInfo() << "Patching Riivolution…";
-            Riivolution::write(windowFilePath(), saveDir, gameInstance.addressMapper(),
-                               riivolutionName);
-        }
+            setProgress(30);
+            auto gameInstance = GameInstance::fromGameDirectory(wiiSaveDir, importDirPath, descriptors);
+            CSMMModpack modpack(gameInstance, modList.begin(), modList.end());
+            modpack.save(wiiSaveDir, [&](double progressVal) {
+                setProgress(30 + (90 - 30) * progressVal);
+            });
+
+            if (riivolution) {
+                setProgress(90);
+                qInfo() << "Patching Riivolution…";
+                Riivolution::write(gameDir, saveDir, gameInstance.addressMapper(),
+                                   riivolutionName);
+            }
+            descriptors = gameInstance.mapDescriptors();
+        });
 
         progress.setValue(100);
         QMessageBox::information(this, "Save", "Saved successfully.");
 
         // reload map descriptors
         int idx = 0;
-        for (auto &descriptor: gameInstance.mapDescriptors()) {
+        for (auto &descriptor: descriptors) {
             ui->tableWidget->loadRowWithMapDescriptor(idx++, descriptor);
         }
     } catch (const ProgressCanceled &) {
@@ -482,7 +526,13 @@ void MainWindow::exportIsoWbfs() {
 
             try {
                 progress.setValue(0);
-                await(ExeWrapper::createWbfsIso(windowFilePath(), saveFile, "01", false));
+                auto gameDir = windowFilePath();
+                progress.runInWorker([&](const std::function<void(int)> &setProgress) {
+                    // a partially extracted game directory is completed next to the image, not in place
+                    await(ExeWrapper::createWbfsIso(gameDir, saveFile, "01", false, false, [&](double progressVal) {
+                        setProgress(100 * progressVal);
+                    }));
+                });
                 progress.setValue(100);
             } catch (const ProgressCanceled &) {
                 return;
@@ -503,32 +553,42 @@ void MainWindow::exportIsoWbfs() {
         progress.setValue(0);
 
         QString intermediatePath = intermediateResults.path();
-        std::error_code error;
-        std::filesystem::copy(windowFilePath().toStdU16String(), intermediatePath.toStdU16String(), std::filesystem::copy_options::recursive, error);
-        if (error) {
-            QMessageBox::critical(this, "Export", QString("Could not copy to intermediate directory: %1").arg(error.message().c_str()));
-        }
-
-        progress.setValue(20);
+        auto gameDir = windowFilePath();
+        auto importDirPath = importDir->path();
+        auto markerCode = getMarkerCode();
+        bool separateSaveGame = getSeparateSaveGame();
         auto descriptorPtrs = ui->tableWidget->getDescriptors();
         std::transform(descriptorPtrs.begin(), descriptorPtrs.end(), std::back_inserter(descriptors), [](auto &ptr) { return *ptr; });
 
-        auto gameInstance = GameInstance::fromGameDirectory(intermediatePath, importDir->path(), descriptors);
-        CSMMModpack modpack(gameInstance, modList.begin(), modList.end());
-        modpack.save(intermediatePath, [&](double progressVal) {
-            progress.setValue(20 + (80 - 20) * progressVal);
+        progress.runInWorker([&](const std::function<void(int)> &setProgress) {
+            try {
+                FileCopy::copyTree(gameDir, intermediatePath);
+            } catch (const FileCopy::Exception &e) {
+                throw std::runtime_error(QString("Could not copy to intermediate directory: %1").arg(e.what()).toStdString());
+            }
+            // only the files the mods need; the rest is extracted next to the image when packing
+            await(ExeWrapper::extractMissingFiles(intermediatePath, CSMMModpack::fileDependencies(modList.begin(), modList.end()), [&](double progressVal) {
+                setProgress(20 * progressVal);
+            }));
+
+            setProgress(20);
+            auto gameInstance = GameInstance::fromGameDirectory(intermediatePath, importDirPath, descriptors);
+            CSMMModpack modpack(gameInstance, modList.begin(), modList.end());
+            modpack.save(intermediatePath, [&](double progressVal) {
+                setProgress(20 + (80 - 20) * progressVal);
+            });
+            descriptors = gameInstance.mapDescriptors();
+
+            setProgress(80);
+            qInfo() << "packing wbfs/iso";
+            bool patchWiimmfi = std::find_if(modList.begin(), modList.end(), [](const auto &mod) { return mod->modId() == "wifiFix"; }) != modList.end();
+            if (patchWiimmfi) {
+                qInfo() << "patching wiimmfi while packing";
+            }
+            await(ExeWrapper::createWbfsIso(intermediatePath, saveFile, markerCode, separateSaveGame, patchWiimmfi, [&](double progressVal) {
+                setProgress(80 + (100 - 80) * progressVal);
+            }));
         });
-        descriptors = gameInstance.mapDescriptors();
-
-        progress.setValue(80);
-        qInfo() << "packing wbfs/iso";
-        await(ExeWrapper::createWbfsIso(intermediatePath, saveFile, getMarkerCode(), getSeparateSaveGame()));
-
-        progress.setValue(90);
-        if (std::find_if(modList.begin(), modList.end(), [](const auto &mod) { return mod->modId() == "wifiFix"; }) != modList.end()) {
-            qInfo() << "patching wiimmfi";
-            await(ExeWrapper::patchWiimmfi(saveFile));
-        }
 
         progress.setValue(100);
         QMessageBox::information(this, "Export", "Exported successfully.");
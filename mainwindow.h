@@ -29,7 +29,6 @@ private:
     QSharedPointer<QTemporaryDir> importDir;
 
     ModListType modList;
-    std::shared_ptr<QTemporaryDir[]> tempModpackDirs;
 
 
     void openDir();
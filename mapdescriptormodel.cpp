@@ -0,0 +1,275 @@
+#include "mapdescriptormodel.h"
+
+#include <QTimer>
+#include "lib/getordefault.h"
+
+static const QStringList &columnLabels() {
+    static const QStringList labels{"", "", "Name", "MapSet [E]", "Zone [E]", "Order [E]",
+                                    "Tut. Map? [E]", "Unlock ID [E]", "Ruleset", "Initial Cash", "Target Amount",
+                                    "Base Salary", "Salary Increment", "Max. Dice Roll",
+                                    "Venture Cards", "FRB Files", "Switch Origin Points",
+                                    "Board Theme", "Background", "Background Music ID",
+                                    "Map Icon", "Looping Mode", "Looping Mode Radius",
+                                    "Looping Mode Horiz. Padding", "Looping Mode Vertical Square Count",
+                                    "Tour Bankruptcy Limit", "Tour Initial Cash", "Tour Opponents",
+                                    "Tour Clear Rank", "Name Msg ID", "Desc Msg ID",
+                                    "Description", "Internal Name", "District Names", "District Name IDs"};
+    return labels;
+}
+
+static QString displayText(const MapDescriptor &descriptor, int column) {
+    switch (column) {
+    case MapDescriptorModel::ImportColumn:
+        return "Import .yaml or .zip";
+    case MapDescriptorModel::ExportColumn:
+        return "Export .yaml";
+    case MapDescriptorModel::NameColumn:
+        return getOrDefault(descriptor.names, "en", QString());
+    case MapDescriptorModel::MapSetColumn:
+        return QString::number(descriptor.mapSet);
+    case MapDescriptorModel::ZoneColumn:
+        return QString::number(descriptor.zone);
+    case MapDescriptorModel::OrderColumn:
+        return QString::number(descriptor.order);
+    case MapDescriptorModel::UnlockIdColumn:
+        return QString::number(descriptor.unlockId);
+    case MapDescriptorModel::RuleSetColumn:
+        return descriptor.ruleSet == Easy ? "Easy" : "Standard";
+    case MapDescriptorModel::InitialCashColumn:
+        return QString::number(descriptor.initialCash);
+    case MapDescriptorModel::TargetAmountColumn:
+        return QString::number(descriptor.targetAmount);
+    case MapDescriptorModel::BaseSalaryColumn:
+        return QString::number(descriptor.baseSalary);
+    case MapDescriptorModel::SalaryIncrementColumn:
+        return QString::number(descriptor.salaryIncrement);
+    case MapDescriptorModel::MaxDiceRollColumn:
+        return QString::number(descriptor.maxDiceRoll);
+    case MapDescriptorModel::VentureCardsColumn:
+        return "View Venture Cards";
+    case MapDescriptorModel::FrbFilesColumn: {
+        QStringList frbFilesList;
+        for (auto &str: descriptor.frbFiles) {
+            if (!str.isEmpty()) {
+                frbFilesList.append(str);
+            }
+        }
+        return frbFilesList.join("; ");
+    }
+    case MapDescriptorModel::SwitchOriginPointsColumn: {
+        QStringList originPointsStrList;
+        for (auto &originPoint: descriptor.switchRotationOrigins) originPointsStrList.append(QString(originPoint));
+        return originPointsStrList.join("; ");
+    }
+    case MapDescriptorModel::ThemeColumn:
+        return descriptor.theme == Mario ? "Mario" : "DragonQuest";
+    case MapDescriptorModel::BackgroundColumn:
+        return descriptor.background;
+    case MapDescriptorModel::BgmIdColumn:
+        return Bgm::bgmIdToString(descriptor.bgmId);
+    case MapDescriptorModel::MapIconColumn:
+        return descriptor.mapIcon;
+    case MapDescriptorModel::LoopingModeColumn:
+        return QString::number(descriptor.loopingMode);
+    case MapDescriptorModel::LoopingModeRadiusColumn:
+        return QString::number(descriptor.loopingModeRadius);
+    case MapDescriptorModel::LoopingModeHorizontalPaddingColumn:
+        return QString::number(descriptor.loopingModeHorizontalPadding);
+    case MapDescriptorModel::LoopingModeVerticalSquareCountColumn:
+        return QString::number(descriptor.loopingModeVerticalSquareCount);
+    case MapDescriptorModel::TourBankruptcyLimitColumn:
+        return QString::number(descriptor.tourBankruptcyLimit);
+    case MapDescriptorModel::TourInitialCashColumn:
+        return QString::number(descriptor.tourInitialCash);
+    case MapDescriptorModel::TourOpponentsColumn: {
+        QStringList tourOpponentsList;
+        for (auto character: descriptor.tourCharacters) tourOpponentsList.append(tourCharacterToString(character));
+        return tourOpponentsList.join("; ");
+    }
+    case MapDescriptorModel::TourClearRankColumn:
+        return QString::number(descriptor.tourClearRank);
+    case MapDescriptorModel::NameMsgIdColumn:
+        return QString::number(descriptor.nameMsgId);
+    case MapDescriptorModel::DescMsgIdColumn:
+        return QString::number(descriptor.descMsgId);
+    case MapDescriptorModel::DescriptionColumn:
+        return getOrDefault(descriptor.descs, "en", QString());
+    case MapDescriptorModel::InternalNameColumn:
+        return descriptor.internalName;
+    case MapDescriptorModel::DistrictNamesColumn: {
+        auto distNames = getOrDefault(descriptor.districtNames, "en", std::vector<QString>());
+        return QStringList(distNames.begin(), distNames.end()).join("; ");
+    }
+    case MapDescriptorModel::DistrictNameIdsColumn: {
+        QStringList districtNameIdStrs;
+        for (quint32 v: descriptor.districtNameIds) {
+            districtNameIdStrs.push_back(QString::number(v));
+        }
+        return districtNameIdStrs.join("; ");
+    }
+    default:
+        return QString();
+    }
+}
+
+static bool isIntegerColumn(int column) {
+    return column == MapDescriptorModel::MapSetColumn || column == MapDescriptorModel::ZoneColumn
+            || column == MapDescriptorModel::OrderColumn || column == MapDescriptorModel::UnlockIdColumn;
+}
+
+MapDescriptorModel::MapDescriptorModel(QObject *parent) : QAbstractTableModel(parent) {}
+
+int MapDescriptorModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : descriptorPtrs.size();
+}
+
+int MapDescriptorModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant MapDescriptorModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= descriptorPtrs.size()) {
+        return QVariant();
+    }
+    auto &descriptor = *descriptorPtrs[index.row()];
+    int column = index.column();
+    if (column == PracticeBoardColumn) {
+        if (role == Qt::CheckStateRole) {
+            return descriptor.isPracticeBoard ? Qt::Checked : Qt::Unchecked;
+        }
+        return QVariant();
+    }
+    if (role == Qt::DisplayRole) {
+        return displayText(descriptor, column);
+    }
+    if (role == Qt::EditRole && isIntegerColumn(column)) {
+        switch (column) {
+        case MapSetColumn: return int(descriptor.mapSet);
+        case ZoneColumn: return int(descriptor.zone);
+        case OrderColumn: return int(descriptor.order);
+        default: return descriptor.unlockId;
+        }
+    }
+    return QVariant();
+}
+
+QVariant MapDescriptorModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    if (orientation == Qt::Horizontal) {
+        return columnLabels().value(section);
+    }
+    return QString::number(section);
+}
+
+Qt::ItemFlags MapDescriptorModel::flags(const QModelIndex &index) const {
+    auto result = QAbstractTableModel::flags(index);
+    if (index.column() == PracticeBoardColumn) {
+        result |= Qt::ItemIsUserCheckable;
+    } else if (isIntegerColumn(index.column())) {
+        result |= Qt::ItemIsEditable;
+    }
+    return result;
+}
+
+bool MapDescriptorModel::setData(const QModelIndex &index, const QVariant &value, int role) {
+    if (!index.isValid() || index.row() >= descriptorPtrs.size()) {
+        return false;
+    }
+    auto &descriptor = *descriptorPtrs[index.row()];
+    if (index.column() == PracticeBoardColumn && role == Qt::CheckStateRole) {
+        descriptor.isPracticeBoard = value.toInt() == Qt::Checked;
+    } else if (isIntegerColumn(index.column()) && role == Qt::EditRole) {
+        bool ok;
+        int intValue = value.toInt(&ok);
+        if (!ok) return false;
+        switch (index.column()) {
+        case MapSetColumn: descriptor.mapSet = intValue; break;
+        case ZoneColumn: descriptor.zone = intValue; break;
+        case OrderColumn: descriptor.order = intValue; break;
+        default: descriptor.unlockId = intValue; break;
+        }
+    } else {
+        return false;
+    }
+    Q_EMIT dataChanged(index, index, {role, Qt::DisplayRole});
+    Q_EMIT descriptorEdited(index.row());
+    return true;
+}
+
+bool MapDescriptorModel::removeRows(int row, int count, const QModelIndex &parent) {
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > descriptorPtrs.size()) {
+        return false;
+    }
+    flushRowsChanged();
+    beginRemoveRows(parent, row, row + count - 1);
+    descriptorPtrs.remove(row, count);
+    endRemoveRows();
+    // the vertical header shows the row numbers of the rows below
+    if (row < descriptorPtrs.size()) {
+        Q_EMIT headerDataChanged(Qt::Vertical, row, descriptorPtrs.size() - 1);
+    }
+    return true;
+}
+
+const QVector<QSharedPointer<MapDescriptor>> &MapDescriptorModel::descriptors() const {
+    return descriptorPtrs;
+}
+
+void MapDescriptorModel::setDescriptors(const std::vector<MapDescriptor> &newDescriptors) {
+    beginResetModel();
+    changedFirst = changedLast = -1;
+    descriptorPtrs.clear();
+    descriptorPtrs.reserve(newDescriptors.size());
+    for (auto &descriptor: newDescriptors) {
+        descriptorPtrs.append(QSharedPointer<MapDescriptor>::create(descriptor));
+    }
+    endResetModel();
+}
+
+void MapDescriptorModel::appendDescriptors(const std::vector<MapDescriptor> &newDescriptors) {
+    if (newDescriptors.empty()) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), descriptorPtrs.size(), descriptorPtrs.size() + newDescriptors.size() - 1);
+    for (auto &descriptor: newDescriptors) {
+        descriptorPtrs.append(QSharedPointer<MapDescriptor>::create(descriptor));
+    }
+    endInsertRows();
+}
+
+void MapDescriptorModel::setDescriptor(int row, const MapDescriptor &descriptor) {
+    descriptorPtrs[row] = QSharedPointer<MapDescriptor>::create(descriptor);
+    scheduleRowsChanged(row, row);
+}
+
+void MapDescriptorModel::clear() {
+    setDescriptors({});
+}
+
+bool MapDescriptorModel::isButtonColumn(int column) {
+    return column == ImportColumn || column == ExportColumn || column == VentureCardsColumn;
+}
+
+void MapDescriptorModel::scheduleRowsChanged(int first, int last) {
+    if (changedFirst < 0) {
+        changedFirst = first;
+        changedLast = last;
+        QTimer::singleShot(0, this, &MapDescriptorModel::flushRowsChanged);
+    } else {
+        changedFirst = qMin(changedFirst, first);
+        changedLast = qMax(changedLast, last);
+    }
+}
+
+void MapDescriptorModel::flushRowsChanged() {
+    if (changedFirst < 0) {
+        return;
+    }
+    int first = changedFirst, last = qMin(changedLast, descriptorPtrs.size() - 1);
+    changedFirst = changedLast = -1;
+    if (first <= last) {
+        Q_EMIT dataChanged(index(first, 0), index(last, ColumnCount - 1));
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef MAPDESCRIPTORMODEL_H
+#define MAPDESCRIPTORMODEL_H
+
+#include <QAbstractTableModel>
+#include <QSharedPointer>
+#include <QVector>
+#include "lib/mapdescriptor.h"
+
+/**
+ * @brief Table model backed directly by the map descriptor list.
+ *
+ * Cell contents are computed on demand in data(), so only the rows the view actually shows are formatted.
+ * Rows changed through setDescriptor() are collected and announced with a single dataChanged() once control
+ * returns to the event loop.
+ */
+class MapDescriptorModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column {
+        ImportColumn, ExportColumn, NameColumn, MapSetColumn, ZoneColumn, OrderColumn,
+        PracticeBoardColumn, UnlockIdColumn, RuleSetColumn, InitialCashColumn, TargetAmountColumn,
+        BaseSalaryColumn, SalaryIncrementColumn, MaxDiceRollColumn,
+        VentureCardsColumn, FrbFilesColumn, SwitchOriginPointsColumn,
+        ThemeColumn, BackgroundColumn, BgmIdColumn,
+        MapIconColumn, LoopingModeColumn, LoopingModeRadiusColumn,
+        LoopingModeHorizontalPaddingColumn, LoopingModeVerticalSquareCountColumn,
+        TourBankruptcyLimitColumn, TourInitialCashColumn, TourOpponentsColumn,
+        TourClearRankColumn, NameMsgIdColumn, DescMsgIdColumn,
+        DescriptionColumn, InternalNameColumn, DistrictNamesColumn, DistrictNameIdsColumn,
+        ColumnCount
+    };
+
+    explicit MapDescriptorModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
+
+    const QVector<QSharedPointer<MapDescriptor>> &descriptors() const;
+    /**
+     * @brief Replaces all descriptors with a single model reset.
+     */
+    void setDescriptors(const std::vector<MapDescriptor> &newDescriptors);
+    /**
+     * @brief Appends the descriptors with a single row insertion.
+     */
+    void appendDescriptors(const std::vector<MapDescriptor> &newDescriptors);
+    /**
+     * @brief Replaces the descriptor at row; the views are notified once per event loop iteration.
+     */
+    void setDescriptor(int row, const MapDescriptor &descriptor);
+    void clear();
+    /**
+     * @return whether the column is drawn as a push button
+     */
+    static bool isButtonColumn(int column);
+Q_SIGNALS:
+    /**
+     * @brief Emitted when the user edits a descriptor through the view.
+     */
+    void descriptorEdited(int row);
+private:
+    void scheduleRowsChanged(int first, int last);
+    void flushRowsChanged();
+
+    QVector<QSharedPointer<MapDescriptor>> descriptorPtrs;
+    int changedFirst = -1;
+    int changedLast = -1;
+};
+
+#endif // MAPDESCRIPTORMODEL_H
@@ -2,17 +2,22 @@
 #define MAPDESCRIPTORWIDGET_H
 
 #include <functional>
-#include <QTableWidget>
+#include <QTableView>
 #include <QTemporaryDir>
 #include <QObject>
 #include "lib/mapdescriptor.h"
+#include "mapdescriptormodel.h"
 
-class MapDescriptorWidget : public QTableWidget
+class MapDescriptorWidget : public QTableView
 {
 public:
     explicit MapDescriptorWidget(QWidget *parent = nullptr);
     void loadRowWithMapDescriptor(int row, const MapDescriptor &descriptor);
     void appendMapDescriptor(const MapDescriptor &descriptor);
+    /**
+     * @brief Replaces the map list with descriptors and marks it as not dirty.
+     */
+    void setDescriptors(const std::vector<MapDescriptor> &descriptors);
     void duplicateSelectedMapDescriptors();
     void removeSelectedMapDescriptors();
     void clearDescriptors();
@@ -21,7 +26,15 @@ public:
     void setImportDirectoryFunction(const std::function<QString()> &fn);
     bool dirty = false;
 private:
-    QVector<QSharedPointer<MapDescriptor>> descriptors;
+    void buttonClicked(const QModelIndex &index);
+    /**
+     * @brief Estimates the column widths from a sample of the rows once the current batch of changes is done.
+     * The widths are kept until rows are added again, so edits never trigger a relayout of the whole table.
+     */
+    void scheduleColumnWidthEstimate();
+
+    MapDescriptorModel *descriptorModel;
+    bool columnWidthEstimateScheduled = false;
     std::function<QString()> getGameDirectory;
     std::function<QString()> getImportDirectory;
 };
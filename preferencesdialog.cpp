@@ -69,6 +69,8 @@ PreferencesDialog::PreferencesDialog(QWidget *parent) :
     auto clearCacheOnError = settings.value("networkAutoClearCacheOnError").toBool();
     ui->autoClearCacheCheckBox->setChecked(clearCacheOnError);
 
+    ui->traceCheckBox->setChecked(settings.value("traceEnabled").toBool());
+
     auto size = settings.value("networkCacheSize").toInt();
     if (size >= 1 && size <= 10) {
         ui->cacheSizeSlider->setValue(size);
@@ -152,6 +154,8 @@ void PreferencesDialog::accept()
     auto networkCacheDirectory = ui->cacheDirectoryLabel->text();
     settings.setValue("networkCacheDirectory", networkCacheDirectory);
 
+    settings.setValue("traceEnabled", ui->traceCheckBox->isChecked());
+
     QDialog::accept();
 }
 
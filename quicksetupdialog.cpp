@@ -10,9 +10,11 @@
 
 #include "lib/await.h"
 #include "lib/exewrapper.h"
+#include "lib/filecopy.h"
 #include "lib/mods/modloader.h"
 #include "lib/mods/csmmmodpack.h"
 #include "lib/configuration.h"
+#include "lib/datafileset.h"
 #include "lib/riivolution.h"
 #include "csmmprogressdialog.h"
 #include "mainwindow.h"
@@ -216,27 +218,6 @@ void QuickSetupDialog::onResultClick(QAbstractButton *button)
         CSMMProgressDialog dialog("Starting process...", QString(), 0, 100, nullptr, Qt::WindowFlags(), true);
         dialog.setWindowModality(Qt::ApplicationModal);
         dialog.setWindowTitle("Creating Disc Image");
-        // copy directory if folder, extract wbfs/iso if file
-        if (QFileInfo(ui->inputGameLoc->text()).isDir()) {
-            std::error_code error;
-            std::filesystem::copy(ui->inputGameLoc->text().toStdU16String(), targetGameDir.toStdU16String(), std::filesystem::copy_options::recursive, error);
-            if (error) {
-                QMessageBox::critical(this, "Cannot save game", QString::fromStdString(error.message()));
-                return;
-            }
-        } else {
-            await(ExeWrapper::extractWbfsIso(ui->inputGameLoc->text(), targetGameDir));
-        }
-        if (shouldPatchRiivolutionVar) { // store vanilla game directory in intermediateDir for riivolution patching
-            std::error_code error;
-            std::filesystem::copy(targetGameDir.toStdU16String(), intermediateDir.path().toStdU16String(), std::filesystem::copy_options::recursive, error);
-            if (error) {
-                QMessageBox::critical(this, "Cannot save game", QString::fromStdString(error.message()));
-                return;
-            }
-        }
-        dialog.setValue(10);
-
         QVector<QString> modpackZips{ui->modpackZip->text()};
         for (int i=0; i<ui->additionalMods->count(); ++i) {
             modpackZips.append(ui->additionalMods->item(i)->text());
@@ -247,51 +228,87 @@ void QuickSetupDialog::onResultClick(QAbstractButton *button)
             qInfo() << str;
         }
 
-        auto mods = ModLoader::importModpackCollection(modpackZips);
-        auto gameInstance = GameInstance::fromGameDirectory(targetGameDir, importDir.path());
-        CSMMModpack modpack(gameInstance, mods.first.begin(), mods.first.end());
-        modpack.load(targetGameDir);
-
-        dialog.setValue(20);
-
-        auto mapListFileIt = QDirIterator(mods.second[0].path(), {"map[Ll]ist.yaml", "map[Ll]ist.yml"}, QDir::Files, QDirIterator::Subdirectories);
-        if (!mapListFileIt.hasNext()) {
-            QMessageBox::critical(this, "Cannot save game", "The maplist yaml was not found inside the modpack zip.");
-            return;
-        }
+        auto inputGameLoc = ui->inputGameLoc->text();
+        auto markerCode = ui->markerCode->text();
+        bool separateSaveGame = ui->separateSaveGame->isChecked();
+        auto riivolutionPatchName = ui->riivolutionPatchName->text();
+
+        dialog.runInWorker([&](const std::function<void(int)> &setProgress) {
+            auto mods = ModLoader::importModpackCollection(modpackZips);
+
+            // copy directory if folder, extract wbfs/iso if file
+            if (QFileInfo(inputGameLoc).isDir()) {
+                FileCopy::copyTree(inputGameLoc, targetGameDir, false, [&](double progress) {
+                    setProgress(10 * progress);
+                });
+            } else if (QFileInfo(outputLoc).isDir() && !shouldPatchRiivolutionVar) {
+                await(ExeWrapper::extractWbfsIso(inputGameLoc, targetGameDir, {}, [&](double progress) {
+                    setProgress(10 * progress);
+                }));
+            } else {
+                // only extract what the mods need; the rest is extracted from the image right before packing
+                await(ExeWrapper::extractWbfsIso(inputGameLoc, targetGameDir,
+                                                 CSMMModpack::fileDependencies(mods.begin(), mods.end()), [&](double progress) {
+                    setProgress(10 * progress);
+                }));
+            }
+            FileManifest::Manifest vanillaFiles;
+            QString vanillaMainDol = QDir(intermediateDir.path()).filePath("main.dol");
+            if (shouldPatchRiivolutionVar) { // remember the vanilla files and main.dol for riivolution patching
+                vanillaFiles = FileManifest::cachedVanillaManifest(targetGameDir);
+                try {
+                    FileCopy::copyFile(QDir(targetGameDir).filePath(MAIN_DOL), vanillaMainDol);
+                } catch (const FileCopy::Exception &e) {
+                    throw std::runtime_error(QString("Cannot back up vanilla main.dol for Riivolution patching: %1").arg(e.what()).toStdString());
+                }
+            }
+            setProgress(10);
 
-        mapListFileIt.next();
-        Configuration::load(mapListFileIt.fileInfo().absoluteFilePath(), gameInstance.mapDescriptors(), QDir(importDir.path()), [&](double progress) {
-            dialog.setValue(20 + (60 - 20) * progress);
-        });
+            auto gameInstance = GameInstance::fromGameDirectory(targetGameDir, importDir.path());
+            CSMMModpack modpack(gameInstance, mods.begin(), mods.end());
+            modpack.load(targetGameDir);
 
-        dialog.setValue(60);
+            setProgress(20);
 
-        modpack.save(targetGameDir, [&](double progress) {
-            dialog.setValue(60 + (90 - 60) * progress);
-        });
+            auto mapListFileIt = QDirIterator(ModLoader::extractedModpackRoot(modpackZips[0]), {"map[Ll]ist.yaml", "map[Ll]ist.yml"}, QDir::Files, QDirIterator::Subdirectories);
+            if (!mapListFileIt.hasNext()) {
+                throw std::runtime_error("The maplist yaml was not found inside the modpack zip.");
+            }
 
-        dialog.setValue(90);
-
-        // create wbfs/iso if file
-        if (!QFileInfo(outputLoc).isDir()) {
-            qInfo() << "Marker Code: " << ui->markerCode->text();
-            qInfo() << "Is Separate Save Game: " << ui->separateSaveGame->isChecked();
-            qInfo() << "Writing modified game image...";
-            await(ExeWrapper::createWbfsIso(targetGameDir, outputLoc, ui->markerCode->text(), ui->separateSaveGame->isChecked()));
-            if (std::find_if(mods.first.begin(), mods.first.end(), [](const auto &mod) { return mod->modId() == "wifiFix"; }) != mods.first.end()) {
-                qInfo() << "Patching Wiimmfi...";
-                dialog.setValue(95);
-                await(ExeWrapper::patchWiimmfi(outputLoc));
+            mapListFileIt.next();
+            Configuration::load(mapListFileIt.fileInfo().absoluteFilePath(), gameInstance.mapDescriptors(), QDir(importDir.path()), [&](double progress) {
+                setProgress(20 + (60 - 20) * progress);
+            });
+
+            setProgress(60);
+
+            modpack.save(targetGameDir, [&](double progress) {
+                setProgress(60 + (90 - 60) * progress);
+            });
+
+            setProgress(90);
+
+            // create wbfs/iso if file
+            if (!QFileInfo(outputLoc).isDir()) {
+                qInfo() << "Marker Code: " << markerCode;
+                qInfo() << "Is Separate Save Game: " << separateSaveGame;
+                qInfo() << "Writing modified game image...";
+                bool patchWiimmfi = std::find_if(mods.begin(), mods.end(), [](const auto &mod) { return mod->modId() == "wifiFix"; }) != mods.end();
+                if (patchWiimmfi) {
+                    qInfo() << "Patching Wiimmfi while writing...";
+                }
+                await(ExeWrapper::createWbfsIso(targetGameDir, outputLoc, markerCode, separateSaveGame, patchWiimmfi, [&](double progress) {
+                    setProgress(90 + (100 - 90) * progress);
+                }));
             }
-        }
 
-        // riivolution stuff
-        if (shouldPatchRiivolutionVar) {
-            qInfo() << "Patching Riivolution...";
-            dialog.setValue(95);
-            Riivolution::write(intermediateDir.path(), outputLoc, gameInstance.addressMapper(), ui->riivolutionPatchName->text());
-        }
+            // riivolution stuff
+            if (shouldPatchRiivolutionVar) {
+                qInfo() << "Patching Riivolution...";
+                setProgress(95);
+                Riivolution::write(vanillaFiles, vanillaMainDol, outputLoc, gameInstance.addressMapper(), riivolutionPatchName);
+            }
+        });
 
         dialog.setValue(100);
 
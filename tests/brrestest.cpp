@@ -0,0 +1,106 @@
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "lib/await.h"
+#include "lib/brres.h"
+#include "lib/exewrapper.h"
+
+/**
+ * Tests that the in-memory brres archives match what wszst extracts. The tests need the Wiimms tools next to the
+ * test executable and are skipped unless CSMM_TEST_IMAGE names a Fortune Street image.
+ */
+class BrresTest : public QObject {
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void vanillaSubFilesMatchWszst();
+    void vanillaArchivesRoundTrip();
+private:
+    QTemporaryDir tmp;
+    QDir gameDir;
+    QStringList brresFiles;
+};
+
+static QByteArray readFile(const QString &path) {
+    QFile file(path);
+    return file.open(QFile::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+void BrresTest::initTestCase() {
+    auto image = qEnvironmentVariable("CSMM_TEST_IMAGE");
+    if (image.isEmpty()) {
+        QSKIP("CSMM_TEST_IMAGE is not set");
+    }
+    QDir appDir(QCoreApplication::applicationDirPath());
+    if (!QFile::exists(appDir.filePath("wit/bin/" WIT_NAME)) || !QFile::exists(appDir.filePath("wit/bin/" WSZST_NAME))) {
+        QSKIP("wit and wszst are not installed next to the test executable");
+    }
+    QVERIFY(tmp.isValid());
+    gameDir = QDir(QDir(tmp.path()).filePath("game"));
+    await(ExeWrapper::extractWbfsIso(image, gameDir.path()));
+    QDirIterator it(gameDir.filePath("files"), {"*.brres"}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        brresFiles.append(gameDir.relativeFilePath(it.next()));
+    }
+    QVERIFY(!brresFiles.isEmpty());
+
+    ExeWrapper::SzsBatch batch;
+    QVector<QFuture<void>> extractions;
+    for (auto &brresFile: brresFiles) {
+        extractions.append(batch.extract(gameDir.path(), brresFile, QDir(tmp.path()).filePath("wszst")));
+    }
+    batch.run();
+    for (auto &extraction: extractions) {
+        await(extraction);
+    }
+}
+
+void BrresTest::vanillaSubFilesMatchWszst() {
+    QDir wszstDir(QDir(tmp.path()).filePath("wszst")), csmmDir(QDir(tmp.path()).filePath("csmm"));
+    for (auto &brresFile: brresFiles) {
+        auto archive = Brres::Archive::fromFile(gameDir.filePath(brresFile));
+        archive.extractTo(csmmDir.filePath(brresFile));
+
+        QDir extracted(wszstDir.filePath(brresFile));
+        QStringList wszstPaths;
+        QDirIterator it(extracted.path(), QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            auto path = extracted.relativeFilePath(it.next());
+            // the setup file records how wszst should pack the directory again and is no sub-file
+            if (path != "wszst-setup.txt") {
+                wszstPaths.append(path);
+            }
+        }
+        QStringList paths = archive.paths();
+        paths.sort();
+        wszstPaths.sort();
+        QCOMPARE(paths, wszstPaths);
+        for (auto &path: paths) {
+            if (readFile(csmmDir.filePath(brresFile + "/" + path)) != readFile(extracted.filePath(path))) {
+                QFAIL(qPrintable(QString("%1/%2 differs from the wszst extraction").arg(brresFile, path)));
+            }
+        }
+    }
+}
+
+void BrresTest::vanillaArchivesRoundTrip() {
+    QDir wszstDir(QDir(tmp.path()).filePath("wszst"));
+    for (auto &brresFile: brresFiles) {
+        auto original = readFile(gameDir.filePath(brresFile));
+        Brres::Archive archive(original);
+        QCOMPARE(archive.serialize(), original);
+
+        // reading the wszst extraction back must give the vanilla file again, byte for byte
+        QDir extracted(wszstDir.filePath(brresFile));
+        QFile::remove(extracted.filePath("wszst-setup.txt"));
+        QVERIFY2(archive.updateFrom(extracted.path()), qPrintable(brresFile));
+        QVERIFY2(!archive.isModified(), qPrintable(brresFile));
+        QVERIFY2(archive.serialize() == original, qPrintable(brresFile));
+    }
+}
+
+QTEST_GUILESS_MAIN(BrresTest)
+#include "brrestest.moc"
@@ -0,0 +1,95 @@
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "lib/await.h"
+#include "lib/datafileset.h"
+#include "lib/exewrapper.h"
+#include "lib/filecopy.h"
+
+/**
+ * Tests completing a partially extracted game directory. The tests which extract from a disc image need the
+ * Wiimms tools next to the test executable and are skipped unless CSMM_TEST_IMAGE names a Fortune Street image.
+ */
+class ExtractMissingFilesTest : public QObject {
+    Q_OBJECT
+private Q_SLOTS:
+    void moveMissingFilesKeepsPresentFiles();
+    void extractMissingFilesFromPartialTree();
+};
+
+static void writeFile(const QDir &root, const QString &path, const QByteArray &content) {
+    QVERIFY(root.mkpath(QFileInfo(path).path()));
+    QFile file(root.filePath(path));
+    QVERIFY(file.open(QFile::WriteOnly));
+    QCOMPARE(file.write(content), content.size());
+}
+
+static QByteArray readFile(const QDir &root, const QString &path) {
+    QFile file(root.filePath(path));
+    return file.open(QFile::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+void ExtractMissingFilesTest::moveMissingFilesKeepsPresentFiles() {
+    QTemporaryDir tmp;
+    QVERIFY(tmp.isValid());
+    QDir partial(QDir(tmp.path()).filePath("partial")), extracted(QDir(tmp.path()).filePath("extracted"));
+
+    // a partial tree with main.dol modified since it was extracted
+    writeFile(partial, MAIN_DOL, "modified");
+    writeFile(partial, "files/game/game_sequence.arc", "modified");
+    writeFile(extracted, MAIN_DOL, "vanilla");
+    writeFile(extracted, "files/game/game_sequence.arc", "vanilla");
+    writeFile(extracted, ITAST_BRSAR, "brsar");
+    writeFile(extracted, "files/param/ms_sample.frb", "frb");
+
+    auto moved = FileCopy::moveMissingFiles(extracted.path(), partial.path());
+    moved.sort();
+    QCOMPARE(moved, (QStringList{"files/param/ms_sample.frb", ITAST_BRSAR}));
+    QCOMPARE(readFile(partial, MAIN_DOL), QByteArray("modified"));
+    QCOMPARE(readFile(partial, "files/game/game_sequence.arc"), QByteArray("modified"));
+    QCOMPARE(readFile(partial, ITAST_BRSAR), QByteArray("brsar"));
+    QCOMPARE(readFile(partial, "files/param/ms_sample.frb"), QByteArray("frb"));
+}
+
+void ExtractMissingFilesTest::extractMissingFilesFromPartialTree() {
+    auto image = qEnvironmentVariable("CSMM_TEST_IMAGE");
+    if (image.isEmpty()) {
+        QSKIP("CSMM_TEST_IMAGE is not set");
+    }
+    if (!QFile::exists(QDir(QCoreApplication::applicationDirPath()).filePath("wit/bin/" WIT_NAME))) {
+        QSKIP("wit is not installed next to the test executable");
+    }
+    QTemporaryDir tmp;
+    QVERIFY(tmp.isValid());
+    QDir gameDir(QDir(tmp.path()).filePath("game"));
+
+    await(ExeWrapper::extractWbfsIso(image, gameDir.path(), {MAIN_DOL}));
+    QVERIFY(gameDir.exists(SOURCE_IMAGE_FILE));
+    QVERIFY(!gameDir.exists(ITAST_BRSAR));
+    writeFile(gameDir, MAIN_DOL, "modified");
+
+    await(ExeWrapper::extractMissingFiles(gameDir.path(), {MAIN_DOL, ITAST_BRSAR}));
+    QVERIFY(gameDir.exists(ITAST_BRSAR));
+    QCOMPARE(readFile(gameDir, MAIN_DOL), QByteArray("modified"));
+    // the image is still needed for the files which are not extracted yet
+    QVERIFY(gameDir.exists(SOURCE_IMAGE_FILE));
+    QVERIFY(gameDir.entryList({"csmm_extract_*"}, QDir::Dirs).isEmpty());
+
+    // packing completes the directory next to the image and leaves the game directory partial
+    auto imageFile = QDir(tmp.path()).filePath("packed.wbfs");
+    await(ExeWrapper::createWbfsIso(gameDir.path(), imageFile, "02", false));
+    QVERIFY(QFileInfo(imageFile).size() > 0);
+    QVERIFY(gameDir.exists(SOURCE_IMAGE_FILE));
+    QVERIFY(!gameDir.exists("files/game/game_sequence.arc"));
+    QVERIFY(QDir(tmp.path()).entryList({"csmm_pack_*"}, QDir::Dirs).isEmpty());
+
+    await(ExeWrapper::extractMissingFiles(gameDir.path()));
+    QVERIFY(gameDir.exists("files/game/game_sequence.arc"));
+    QCOMPARE(readFile(gameDir, MAIN_DOL), QByteArray("modified"));
+    QVERIFY(!gameDir.exists(SOURCE_IMAGE_FILE));
+}
+
+QTEST_GUILESS_MAIN(ExtractMissingFilesTest)
+#include "extractmissingfilestest.moc"